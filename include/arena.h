@@ -0,0 +1,96 @@
+/* arena.h */
+
+#ifndef ARENA_H_INCLUDED
+#define ARENA_H_INCLUDED
+
+#include <stddef.h>
+
+enum arena_consts {
+    /* the capacity of an arena created by `get_thread_arena` in bytes */
+    default_arena_capacity = 4 << 20
+};
+
+typedef struct tag_arena {
+    unsigned char *memory;
+    size_t capacity, used;
+    /* the counters reported by the benchmark */
+    unsigned long num_of_allocations, num_of_resets;
+    size_t bytes_allocated, peak_used;
+} arena;
+
+void init_arena(arena *a, size_t capacity);
+/*
+    Allocates the arena memory. It's the only heap allocation the arena makes.
+RECEIVES:
+    - `a` the pointer to the arena to initialize;
+    - `capacity` the arena size in bytes.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the memory can't be allocated, an error message is printed and the
+    program terminates. */
+
+void free_arena(arena *a);
+/*
+    Frees the arena memory.
+RECEIVES:
+    - `a` the pointer to the arena.
+RETURNES:
+    --- */
+
+void *arena_alloc(arena *a, size_t size);
+/*
+    Takes the next aligned block of the arena memory.
+RECEIVES:
+    - `a` the pointer to the arena;
+    - `size` the block size in bytes.
+RETURNES:
+    - the pointer to the block. It stays valid until the arena is reset or
+    released to a mark taken before the allocation.
+ERROR HANDLING:
+    - if the arena is exhausted, an error message is printed and the program
+    terminates. */
+
+size_t arena_mark(const arena *a);
+/*
+    Remembers the current arena state.
+RECEIVES:
+    - `a` the pointer to the arena.
+RETURNES:
+    - the mark to pass to `arena_release`. */
+
+void arena_release(arena *a, size_t mark);
+/*
+    Frees every block allocated after the mark was taken, in O(1).
+RECEIVES:
+    - `a` the pointer to the arena;
+    - `mark` the value returned by `arena_mark`.
+RETURNES:
+    --- */
+
+void reset_arena(arena *a);
+/*
+    Frees every block of the arena in O(1).
+RECEIVES:
+    - `a` the pointer to the arena.
+RETURNES:
+    --- */
+
+arena *get_thread_arena();
+/*
+    Gives access to the calling thread's own arena of the
+`default_arena_capacity` size, allocated at the 1st call.
+RECEIVES:
+    ---
+RETURNES:
+    - the pointer to the thread's arena. */
+
+void free_thread_arena();
+/*
+    Frees the calling thread's arena, if it was allocated.
+RECEIVES:
+    ---
+RETURNES:
+    --- */
+
+#endif
@@ -0,0 +1,127 @@
+/* board_net.h */
+
+#ifndef BOARD_NET_H_INCLUDED
+#define BOARD_NET_H_INCLUDED
+
+#include "arena.h"
+#include "constants.h"
+#include "field.h"
+#include "placement.h"
+#include "search.h"
+#include <stddef.h>
+
+enum board_net_consts {
+    /* the board features the net takes: the column heights, the holes per
+    column (both for `max_field_width` columns), the completed lines, the
+    bumpiness, the maximum height and a zero padding, so an input row is a
+    whole number of 4 float SIMD vectors */
+    board_net_inputs = 2 * max_field_width + 4,
+    /* the hidden layer size `save_heuristic_board_net` writes */
+    default_board_net_hidden = 8
+};
+
+/* the header of a board net file; the header is followed by the float32
+weights: the hidden layer matrix (`num_of_hidden` rows of `num_of_inputs`),
+the hidden layer biases, the output weights and the output bias */
+typedef struct tag_board_net_header {
+    char magic[4];
+    unsigned int num_of_inputs, num_of_hidden;
+    unsigned int reserved;
+} board_net_header;
+
+/* a two layer perceptron scoring boards, its weights are mapped from a file */
+typedef struct tag_board_net {
+    void *mapping;
+    size_t mapping_size;
+    int num_of_hidden;
+    const float *hidden_weights, *hidden_biases, *output_weights;
+    float output_bias;
+} board_net;
+
+void load_board_net(board_net *net, const char *file_name);
+/*
+    Maps the weights file into memory, the weights are used right where they
+are mapped.
+RECEIVES:
+    - `net` the pointer to the net to initialize;
+    - `file_name` the weights file.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be mapped or it isn't a board net file of
+    `board_net_inputs` inputs, an error message is printed and the program
+    terminates. */
+
+void unload_board_net(board_net *net);
+/*
+    Unmaps the weights file.
+RECEIVES:
+    - `net` the pointer to the net.
+RETURNES:
+    --- */
+
+void save_heuristic_board_net(
+    const char *file_name, const heuristic_weights *weights, int num_of_hidden
+);
+/*
+    Writes a board net file scoring the standard field exactly like
+`evaluate_field` with the given weights (the extra hidden units get zero
+weights), a starting point for training.
+RECEIVES:
+    - `file_name` the weights file to write;
+    - `weights` the pointer to the heuristic weights;
+    - `num_of_hidden` the hidden layer size, at least 2.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be written, an error message is printed and the
+    program terminates. */
+
+void board_features(
+    const field_kernels *kernels, const field_row *field,
+    int completed_lines, float *features
+);
+/*
+    Describes the field state by the net inputs.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state;
+    - `completed_lines` the number of lines cleared on the way to the state;
+    - `features` the array of `board_net_inputs` floats to fill.
+RETURNES:
+    --- */
+
+void evaluate_boards(
+    const board_net *net, const float *features, int num_of_boards,
+    float *values
+);
+/*
+    Scores a batch of boards at once: every weight loaded is applied to 4
+boards with SSE (a scalar loop stands in where SSE isn't available).
+RECEIVES:
+    - `net` the pointer to the net;
+    - `features` `num_of_boards` rows of `board_net_inputs` floats, 16 byte
+    aligned;
+    - `num_of_boards` the batch size;
+    - `values` the array of `num_of_boards` floats to store the scores to.
+RETURNES:
+    --- */
+
+bool net_best_placement(
+    const board_net *net, const field_kernels *kernels, const field_row *field,
+    piece_kind kind, arena *a, placement *best
+);
+/*
+    Scores every placement of the piece in one batch and picks the best one.
+RECEIVES:
+    - `net` the pointer to the net;
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the current field state;
+    - `kind` the piece;
+    - `a` the arena for the placements, the field snapshots and the features,
+    left as it was found;
+    - `best` the pointer to store the best placement to.
+RETURNES:
+    - the boolean value indicating whether the piece can be placed at all. */
+
+#endif
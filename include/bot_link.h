@@ -0,0 +1,165 @@
+/* bot_link.h */
+
+#ifndef BOT_LINK_H_INCLUDED
+#define BOT_LINK_H_INCLUDED
+
+#include "constants.h"
+#include "field.h"
+#include "game.h"
+#include <stdatomic.h>
+
+enum bot_link_consts {
+    /* the actions a bot can send ahead of the ones the game has taken */
+    bot_link_actions = 32,
+    /* the times a waiting side checks the shared words before it sleeps in
+    the kernel; the other process usually answers within that time */
+    bot_link_spins = 2000
+};
+
+/* the game state a bot sees */
+typedef struct tag_bot_link_state {
+    field_row field[max_field_height];
+    /* the `field_size` of the game */
+    unsigned char size;
+    bool game_on;
+    /* the falling piece and the kinds of the previewed ones, the next one
+    first */
+    struct_piece piece;
+    unsigned char preview[max_preview_pieces];
+    unsigned char num_of_previews;
+    int level, score, lines;
+    /* the pieces spawned so far, so a new piece of the same kind is told
+    from the last one */
+    unsigned int num_of_pieces;
+    /* the actions of the bot the game has taken before the state */
+    unsigned int actions_done;
+} bot_link_state;
+
+/* the POSIX shared memory segment the game and a bot process share; every
+word a side waits on is a futex word on its own cache line */
+typedef struct tag_bot_link_segment {
+    char magic[4];
+    /* `sizeof(bot_link_segment)`, so an incompatible build isn't attached */
+    unsigned int segment_size;
+    /* the sequence number of the state: odd while the game writes it */
+    _Alignas(cache_line_size) atomic_uint state_seq;
+    /* set while the bot sleeps waiting for a new state */
+    atomic_uint bot_sleeping;
+    bot_link_state state;
+    /* the actions sent so far, the action `i` is `actions[i % size]` */
+    _Alignas(cache_line_size) atomic_uint actions_sent;
+    /* set while the game sleeps waiting for an action */
+    atomic_uint game_sleeping;
+    unsigned char actions[bot_link_actions];
+    /* the actions the game has taken so far */
+    _Alignas(cache_line_size) atomic_uint actions_done;
+} bot_link_segment;
+
+/* one side's view of the segment */
+typedef struct tag_bot_link {
+    bot_link_segment *segment;
+    /* the segment name, unlinked by the game when it closes the link */
+    const char *name;
+    bool owner;
+    /* the game: the pieces spawned so far; the bot: the state sequence
+    number it has read */
+    unsigned int num_of_pieces, state_seq;
+} bot_link;
+
+void create_bot_link(bot_link *link, const char *name);
+/*
+    Creates the shared memory segment a bot process attaches to (a segment
+left by an earlier game is reused).
+RECEIVES:
+    - `link` the pointer to the game's link to initialize;
+    - `name` the segment name, "/name".
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the segment can't be created or mapped, an error message is printed
+    and the program terminates. */
+
+void attach_bot_link(bot_link *link, const char *name);
+/*
+    Maps the segment a game has created.
+RECEIVES:
+    - `link` the pointer to the bot's link to initialize;
+    - `name` the segment name the game was given.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the segment can't be mapped or it isn't a bot link of this build, an
+    error message is printed and the program terminates. */
+
+void close_bot_link(bot_link *link);
+/*
+    Unmaps the segment; the game also removes its name.
+RECEIVES:
+    - `link` the pointer to the link.
+RETURNES:
+    --- */
+
+void publish_bot_link_state(bot_link *link, const game *g);
+/*
+    Lets the bot see the game state after a step (or a number of them): the
+state is written and the sleeping bot is woken. Called by the game.
+RECEIVES:
+    - `link` the pointer to the game's link;
+    - `g` the pointer to the game, `g->changes` telling what the last step
+    changed.
+RETURNES:
+    --- */
+
+game_action wait_bot_link_action(bot_link *link, int delay);
+/*
+    Takes the next action the bot has sent, waiting for it if there's none.
+Called by the game, which should publish the state after the action is
+applied, so the bot knows it's taken.
+RECEIVES:
+    - `link` the pointer to the game's link;
+    - `delay` the longest time to wait in milliseconds (0 - don't wait).
+RETURNES:
+    - the action, `no_action` if none was sent in time. */
+
+bool wait_bot_link_state(bot_link *link, bot_link_state *state, int delay);
+/*
+    Copies the state the game has published since the last call, waiting for
+it if there's none. Called by the bot.
+RECEIVES:
+    - `link` the pointer to the bot's link;
+    - `state` the pointer to store the state to;
+    - `delay` the longest time to wait in milliseconds (-1 - wait forever).
+RETURNES:
+    - the boolean value indicating whether a new state was copied. */
+
+bool send_bot_link_action(bot_link *link, game_action action);
+/*
+    Sends an action to the game and wakes the game if it sleeps. Called by the
+bot.
+RECEIVES:
+    - `link` the pointer to the bot's link;
+    - `action` the action.
+RETURNES:
+    - the boolean value indicating whether the action was sent (it isn't if
+    `bot_link_actions` actions are already waiting for the game). */
+
+unsigned int bot_link_actions_done(const bot_link *link);
+/*
+    Tells how many of the sent actions the game has taken.
+RECEIVES:
+    - `link` the pointer to the link.
+RETURNES:
+    - the number of the taken actions since the segment was created. */
+
+void bot_link_game(const bot_link_state *state, game *g);
+/*
+    Rebuilds a game record from the published state, so a bot can run the
+engine's policies and path finding on it. The engine tables must have been
+built by an `init_game` call.
+RECEIVES:
+    - `state` the pointer to the state;
+    - `g` the pointer to the game to fill.
+RETURNES:
+    --- */
+
+#endif
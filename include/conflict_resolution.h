@@ -4,6 +4,7 @@
 #define CONFLICT_RESOLUTION_H_INCLUDED
 
 #include "constants.h"
+#include "field.h"
 
 typedef enum tag_crossing_action { prevention, signal } crossing_action;
 
@@ -14,7 +15,8 @@ bool side_boundaries_crossing_(
     Indicates whether the piece has crossed the field side boundary. If the
 `crossing_action` value is `signal`, it does nothing else. If the
 `crossing_action` value is `prevention` - prevents the crossing by changing
-the `piece->x_shift` value and changes the `*dx` value if it can.
+the `piece->x_shift` value and changes the `*dx` value if it can. Both the
+crossing and the push-back are looked up in the precomputed piece masks.
 RECEIVES:
     - `action` indicates whether the function prevents the detected crossing;
     - `piece` the pointer to the structure containing the current pice
@@ -24,14 +26,31 @@ RECEIVES:
 RETURNES:
     - the boolean value indicating whether a side boundary crossing took place. */
 
+bool placement_conflict(
+    const field_row *field, piece_kind kind, position orientation,
+    int x_shift, int y_decline
+);
+/*
+    Signals if a piece placed at the given position would cross occupied field
+cells, the side boundaries or the bottom/top boundaries of the standard size
+field. Uses the precomputed piece masks, so the check is a bitwise AND per piece
+row.
+RECEIVES:
+    - `field` the array of rows describing the current field state;
+    - `kind`, `orientation` the piece and its orientation;
+    - `x_shift`, `y_decline` the piece coordinates to the top left field
+    corner.
+RETURNES:
+    - the boolean value indicating whether the conflict occurred. */
+
 bool field_or_side_boundaries_conflict(
-    const bool (*field)[field_width], const struct_piece *piece
+    const field_row *field, const struct_piece *piece
 );
 /*
     Signals if a piece now has a conflict with occupied field cells, or if it
 crosses the side field boundaries.
 RECEIVES:
-    - `field` the pointer to the matrix describing the current field state;
+    - `field` the array of rows describing the current field state;
     - `piece` the pointer to the structure containing the current piece
     properties.
 RETURNES:
@@ -39,50 +58,55 @@ RETURNES:
 */
 
 bool piece_field_crossing_conflict(
-    const bool (*field)[field_width], const struct_piece *piece
+    const field_row *field, const struct_piece *piece
 );
 /*
     Signals if a piece cell is crossing an occupied field cell.
 RECEIVES:
-    - `field` the pointer to the matrix describing the current field state;
+    - `field` the array of rows describing the current field state;
     - `piece` the pointer to the structure containing the current piece
     properties.
 RETURNES:
     - the boolean value indicating whether a piece/field cell crossing occurred.
 */
 
-void make_backup(void *dst, const struct_piece *piece);
+void init_rotation_rules(const struct_piece *set_of_pieces);
+/*
+    Precomputes, for every piece and every orientation it can be rotated from,
+the shifts resolving the rotation conflicts. Must be called once after
+`init_piece_tables` and before `handle_rotation_conflicts` is used.
+RECEIVES:
+    - `set_of_pieces` the array of `num_of_pieces` pieces in their spawn
+    orientation, in the `piece_kind` order.
+RETURNES:
+    --- */
+
+bool handle_rotation_conflicts(const field_row *field, struct_piece *piece);
 /*
-    Copies to the `dst` argument the current state of the `piece->form` matrix.
-It can be used later to restore the initial `piece->form` state.
+    Rotates the piece 90 degrees clockwise and prevents conflicts (crossing the
+field borders or already occupied field cells) after the rotation. In some
+cases, if a conflict is too deep, the rotation doesn't take place. The
+resolution is looked up in the tables built by `init_rotation_rules`, so the
+piece matrix is never backed up and restored.
 RECEIVES:
-    - `dst` untyped pointer to the matrix to store the current state of the
-    `piece->form` matrix;
+    - `field` the array of rows describing the current field state;
     - `piece` the pointer to the structure containing the current piece
     properties.
 RETURNES:
-    ---
-ERROR HANDLING:
-    - the `len` can't be different from `small_piece_size` and `big_piece_size`
-    values. If it does, an error message is printed with the current `len` value
-    and the program terminates. */
-
+    - the boolean value indicating whether the piece was rotated. */
 
-void handle_rotation_conflicts(
-    const bool (*field)[field_width], struct_piece *piece, const void *backup
+bool handle_rotation_conflicts_on(
+    const field_kernels *kernels, const field_row *field, struct_piece *piece
 );
 /*
-    Prevents conflicts (crossing the field borders or already occupied field
-cells) after a rotation of a piece. In some cases, if a conflict is too deep, it
-rolls the rotation back.
+    The same as `handle_rotation_conflicts`, but for a field of any size the
+engine kernels are generated for.
 RECEIVES:
-    - `field` the pointer to the matrix describing the current field state;
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the current field state;
     - `piece` the pointer to the structure containing the current piece
-    properties;
-    - `backup` untyped pointer to the matrix containing the state of the piece
-    before the rotation. It's used for rolling the rotation back in case we
-    couldn't resolve the conflict.
+    properties.
 RETURNES:
-    --- */
+    - the boolean value indicating whether the piece was rotated. */
 
 #endif
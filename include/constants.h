@@ -9,11 +9,27 @@ enum constants {
     /* game field size in cells */
     field_height                        = 20,
     field_width                         = 10,
+    /* the biggest field size the engine kernels are generated for */
+    max_field_height                    = 40,
+    max_field_width                     = 16,
     /* the number of pieces available in the game */
     num_of_pieces                       = 7,
     /* piece sizes in cells */
     small_piece_size                    = 3,
     big_piece_size                      = 4,
+    /* the number of occupied cells every piece consists of */
+    piece_cells                         = 4,
+    /* the number of wall cells encoded on each side of a piece row, enough
+    for a piece matrix to lie completely outside the field */
+    side_wall_cells                     = big_piece_size,
+    /* field row bit masks: no cells occupied, and all the cells occupied */
+    empty_field_row                     = 0,
+    full_field_row                      = (1 << field_width) - 1,
+    /* the range of `x_shift` values piece masks are precomputed for */
+    min_piece_x_shift                   = -big_piece_size,
+    max_piece_x_shift                   = max_field_width,
+    num_of_piece_x_shifts               =
+        max_piece_x_shift - min_piece_x_shift + 1,
     /* initial piece shift to the left border of the field when it spawns */
     initial_piece_shift                 = 4,
     /* the maximum number of lines that can be completed in one game move */
@@ -27,8 +43,20 @@ enum constants {
     four_lines_score_bonus              = 800,
     /* the number of lines you need to get level up */
     num_of_completed_lines_for_level_up = 10,
-    /* the maximum game level after which you cannot level up any more */
-    maximum_game_level                  = 15,
+    /* the maximum game level a game can start at */
+    maximum_game_level                  = 20,
+    /* the last level the gravity of which is given in milliseconds per cell
+    (`speed_list`), the levels after it have the `high_gravity_list` one; the
+    maximum level the completed lines lead up to */
+    last_classic_gravity_level          = 15,
+    /* the time a gravity step of the high gravity levels takes, one frame */
+    gravity_frame_time                  = 16,
+    /* the lock delay of the high gravity levels if the game sets none, in
+    milliseconds */
+    high_gravity_lock_delay             = 500,
+    /* the moves and rotations of a landed piece restarting its lock delay,
+    if the game sets a lock delay but no limit */
+    default_move_reset_limit            = 15,
     /* the number of lines the resize request message consists of */
     num_of_resize_msg_lines             = 6,
     /* the maximum length of a game message (for example, the score message) */
@@ -44,6 +72,14 @@ typedef enum tag_speed_list {
         twelfth = 28,   thirteenth = 18,   fourteenth = 11,   fifteenth = 7
 } speed_list;
 
+/* the gravity of the levels after the `last_classic_gravity_level`, in cells
+per frame (`gravity_frame_time`); 20G drops the piece to its landing row as
+soon as it spawns or moves */
+typedef enum tag_high_gravity_list {
+    sixteenth = 3, seventeenth = 5, eighteenth = 8, nineteenth = 12,
+    twentieth = 20
+} high_gravity_list;
+
 /* the messages used when the player's terminal window is too small */
 
 #define RESIZE_WARNING_MSG         "YOUR TERMINAL WINDOW IS TOO SMALL!"
@@ -62,13 +98,39 @@ typedef enum tag_speed_list {
 
 #define FINAL_SCORE_MSG            "YOUR SCORE IS %d"
 
+/* the messages at the end of a versus match */
+
+#define VERSUS_WIN_MSG             "YOU WIN!"
+
+#define VERSUS_LOSS_MSG            "YOU LOSE."
+
+#define VERSUS_DRAW_MSG            "IT'S A DRAW."
+
+#define PEER_LOST_MSG              "THE OTHER PLAYER IS GONE."
+
+/* one field row: bit `x` is set if the cell in column `x` is occupied (16 bits
+are enough for `max_field_width` columns) */
+typedef unsigned short field_row;
+
+/* one piece matrix row laid over a field row: bit `side_wall_cells + x` is set
+if the piece occupies the cell in column `x`; the bits on both sides of the
+field stand for the side walls */
+typedef unsigned int piece_row;
+
 typedef enum tag_move_direction { left = 1, right } move_direction;
 
 typedef enum tag_position {
     horizontal_1, vertical_1, horizontal_2, vertical_2, orientation_count
 } position;
 
+/* the pieces in the order they are initialized in the set of pieces */
+typedef enum tag_piece_kind {
+    i_piece, o_piece, t_piece, s_piece, z_piece, j_piece, l_piece
+} piece_kind;
+
 typedef struct tag_struct_piece {
+    /* which piece it is */
+    piece_kind kind;
     /* piece size */
     unsigned char size;
     /* cell order in the piece */
@@ -82,7 +144,8 @@ typedef struct tag_struct_piece {
     signed char x_shift, y_decline, ghost_decline;
     /* is it I-form piece? */
     bool i_form;
-    /* the current piece orientation in space */
+    /* the current piece orientation in space (the number of clockwise
+    rotations from the spawn orientation) */
     position orientation;
 } struct_piece;
 
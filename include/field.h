@@ -0,0 +1,113 @@
+/* field.h */
+
+#ifndef FIELD_H_INCLUDED
+#define FIELD_H_INCLUDED
+
+#include "constants.h"
+
+/* the field sizes the engine kernels are generated for */
+typedef enum tag_field_size {
+    /* 20 rows, 10 columns */
+    standard_field,
+    /* 40 rows (the standard field with a buffer zone above it), 10 columns */
+    buffered_field,
+    /* 20 rows, 6 columns */
+    narrow_field,
+    /* 20 rows, 16 columns */
+    wide_field,
+    num_of_field_sizes
+} field_size;
+
+/* the engine kernels specialized for one field size: every loop bound and
+every row mask is a compile-time constant inside them */
+typedef struct tag_field_kernels {
+    /* the field size in cells */
+    int height, width;
+    /* the `x_shift` of a spawning piece */
+    int spawn_x_shift;
+    /* makes every field cell empty */
+    void (*init_field)(field_row *field);
+    /* signals if the piece at the given position crosses occupied field cells
+    or any field boundary */
+    bool (*placement_conflict)(
+        const field_row *field, piece_kind kind, position orientation,
+        int x_shift, int y_decline
+    );
+    /* the `y_decline` the piece falls to from the given position */
+    int (*landing_decline)(
+        const field_row *field, piece_kind kind, position orientation,
+        int x_shift, int y_decline
+    );
+    /* the piece cells become field cells */
+    void (*lock_piece)(
+        field_row *field, piece_kind kind, position orientation,
+        int x_shift, int y_decline
+    );
+    /* deletes the completed lines, moves the lines above them down and
+    returns the number of deleted lines */
+    int (*clear_completed_lines)(field_row *field);
+    /* the same, but after a piece was locked into the rows `first_row` to
+    `last_row`: only they are checked, and only the rows from `top_row` (the
+    topmost one having occupied cells, or any row above it) down to the
+    lowest completed line are moved */
+    int (*clear_locked_lines)(
+        field_row *field, int first_row, int last_row, int top_row
+    );
+    /* pushes `num_of_rows` (up to the field height) copies of `row` in
+    from the bottom, moving the rows from `top_row` (the topmost one having
+    occupied cells, or any row above it) up by as many rows; returns whether
+    occupied rows were pushed out above the field */
+    bool (*insert_bottom_rows)(
+        field_row *field, int num_of_rows, field_row row, int top_row
+    );
+    /* the shift pushing the piece back inside the side boundaries, or inside
+    the bottom/top boundaries, zero if it doesn't cross them */
+    int (*side_push)(piece_kind kind, position orientation, int x_shift);
+    int (*bottom_top_push)(piece_kind kind, position orientation, int y_decline);
+} field_kernels;
+
+const field_kernels *get_field_kernels(field_size size);
+/*
+    Gives access to the engine kernels generated for the field size.
+RECEIVES:
+    - `size` the field size.
+RETURNES:
+    - the pointer to the kernels dispatch table entry.
+ERROR HANDLING:
+    - if `size` is not one of the `field_size` values, an error message is
+    printed and the program terminates. */
+
+void init_field(field_row *field);
+/*
+    Makes every cell of the standard size field empty.
+RECEIVES:
+    - `field` the array of `field_height` rows describing the field state.
+RETURNES:
+    --- */
+
+bool field_cell_is_occupied(const field_row *field, int x, int y);
+/*
+    Signals if the field cell is occupied.
+RECEIVES:
+    - `field` the array of rows describing the current field state;
+    - `x`, `y` the cell coordinates to the top left field corner.
+RETURNES:
+    - the boolean value indicating whether the cell is occupied. */
+
+bool field_row_is_completed(field_row row);
+/*
+    Signals if every cell of the standard size field row is occupied.
+RECEIVES:
+    - `row` the field row.
+RETURNES:
+    - the boolean value indicating whether the row is completed. */
+
+bool field_row_is_empty(field_row row);
+/*
+    Signals if no cell of the standard size field row is occupied.
+RECEIVES:
+    - `row` the field row.
+RETURNES:
+    - the boolean value indicating whether the row is empty. */
+
+#endif
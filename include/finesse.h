@@ -0,0 +1,58 @@
+/* finesse.h */
+
+#ifndef FINESSE_H_INCLUDED
+#define FINESSE_H_INCLUDED
+
+#include "constants.h"
+#include "game.h"
+#include "placement.h"
+
+enum finesse_consts {
+    /* the upper bound of the actions a path consists of, the hard drop
+    included */
+    max_finesse_path_length = 32
+};
+
+/* the shortest sequence of player actions bringing the falling piece to a
+placement: moves and rotations, then a hard drop */
+typedef struct tag_finesse_path {
+    int length;
+    /* the `game_action` values, in the order they are to be taken */
+    unsigned char actions[max_finesse_path_length];
+} finesse_path;
+
+void init_finesse_tables();
+/*
+    Precomputes, for every field size and every piece, the shortest paths from
+the spawn position to every orientation and `x_shift` on the empty field. Must
+be called once after the 1st `init_game` call (it needs the engine tables) and
+before `find_finesse_path` is used.
+RECEIVES:
+    ---
+RETURNES:
+    --- */
+
+bool find_finesse_path(
+    const game *g, const placement *target, finesse_path *path
+);
+/*
+    Finds the shortest sequence of `move_left`, `move_right` and `rotate_piece`
+actions followed by a `hard_drop` bringing the falling piece from where it is
+now to the placement, so a computer player can press the keys a human would.
+The moves and the rotations follow the game rules (the rotation conflicts are
+resolved the same way), and the gravity is supposed not to act until the hard
+drop. A spawned piece first tries the precomputed empty field paths, replayed
+on the real field; if none of them lands the piece right, a breadth-first
+search over the orientations and the positions the piece can reach on the real
+field is made (so a rotation kicked off the field cells isn't looked for when
+an empty field path works, even if it would save an action).
+RECEIVES:
+    - `g` the pointer to the game;
+    - `target` the pointer to a placement of the falling piece (any placement
+    covering the same cells is as good);
+    - `path` the pointer to store the path to.
+RETURNES:
+    - the boolean value indicating whether the placement can be reached in at
+    most `max_finesse_path_length` actions. */
+
+#endif
@@ -18,9 +18,49 @@ enum frontend_consts {
     score_row           = 4,
     next_label_row      = 6,
     next_row            = 7,
+    /* the screen lines one previewed piece takes: a piece is 2 cells tall
+    at most, the pieces are a line apart */
+    preview_slot_height = 2 * cell_height + 1,
+    /* the garbage rows waiting to rise in a versus match */
+    garbage_label_row   = 12,
+    garbage_row         = 13,
     /* how far the game info is from the playing field
     (the game info's x coordinate) */
-    game_info_gap       = 2
+    game_info_gap       = 2,
+    /* the time a computer player shows every key press for, in
+    milliseconds */
+    policy_key_delay    = 40,
+    /* how often the keyboard is checked for Esc while an external bot plays,
+    in milliseconds */
+    bot_link_key_check  = 40,
+    /* the shortest time between two frames the render thread draws, in
+    milliseconds (60 frames per second) */
+    frame_interval      = 16,
+    /* how long the cleared lines are shown emptying before the rows above
+    them fall, in milliseconds; the game doesn't wait for it */
+    line_clear_time     = 200,
+    /* the gap between the two boards of a versus match, in cells */
+    versus_board_gap    = 1,
+    /* the key presses a versus match keeps for the next frames (one key is
+    taken a frame) */
+    max_versus_keys     = 8,
+    /* the frames the local inputs of a match over the loopback interface are
+    delayed by, so the other side gets most of them in time and rolls back
+    rarely */
+    versus_input_delay  = 2,
+    /* the longest wait for a key while the other side's packets are
+    expected, in milliseconds */
+    versus_poll_interval = 2,
+    /* how often the other side is called before the match starts, how long
+    it may keep silent and how long the last inputs are sent for after the
+    match, in milliseconds */
+    versus_hello_interval = 50,
+    versus_link_timeout = 5000,
+    versus_link_linger  = 1000,
+    /* the delayed auto shift and the auto repeat rate of a held left or right
+    key, in milliseconds */
+    default_das         = 167,
+    default_arr         = 33
 };
 
 /* how one row of a playing field cell looks like: */
@@ -31,10 +71,79 @@ enum frontend_consts {
 
 #define GHOST_CELL_ROW      ":::"
 
+#define CLEARED_CELL_ROW    "==="
+
 /* how one character cell of the playing field boundary looks like: */
 
 #define BOTTOM_TOP_BOUNDARY "-"
 
 #define SIDE_BOUNDARY       "|"
 
+/* the command line option choosing the raw ANSI screen backend instead of the
+ncurses one */
+
+#define ANSI_SCREEN_OPTION  "--ansi"
+
+/* the command line options letting a computer player play: by the lookahead
+search, or by the board net from the weights file given after the option;
+the search takes its heuristic weights from the file given after `--weights`,
+if any, and looks at the number of pieces given after `--depth` (the falling
+and the next one by default, the previewed ones at most); `--rollouts` makes
+it play by the Monte Carlo rollouts instead, for the number of milliseconds
+per piece given after the option */
+
+#define BOT_OPTION          "--bot"
+
+#define WEIGHTS_OPTION      "--weights"
+
+#define DEPTH_OPTION        "--depth"
+
+#define ROLLOUTS_OPTION     "--rollouts"
+
+#define NET_OPTION          "--net"
+
+/* the command line option letting an external bot process play through the
+shared memory segment named after the option (`tetris-shmbot` attaches to it) */
+
+#define BOT_LINK_OPTION     "--shm"
+
+/* the command line option recording the game to the file given after it, for
+`tetris-review` to replay */
+
+#define RECORD_OPTION       "--record"
+
+/* the command line options changing the game rules: the level the game
+starts at (the levels after the 15th drop the pieces by cells per frame, up
+to 20G), the lock delay in milliseconds and the number of the moves of a
+landed piece restarting it */
+
+#define LEVEL_OPTION        "--level"
+
+#define LOCK_DELAY_OPTION   "--lock-delay"
+
+#define MOVE_RESETS_OPTION  "--move-resets"
+
+/* the command line option setting the number of the previewed pieces, 1 to
+5 */
+
+#define PREVIEWS_OPTION     "--previews"
+
+/* the command line options changing how a held left or right key moves the
+piece: the delayed auto shift and the auto repeat rate in milliseconds (the
+rate 0 moves the piece to the wall at once) */
+
+#define DAS_OPTION          "--das"
+
+#define ARR_OPTION          "--arr"
+
+/* the command line options starting a versus match: against the computer
+player on the same screen (it plays the way `--bot` or `--net` tells, by the
+search if neither is given), or against another game over the loopback
+interface, the local and the other side's UDP ports given after the option
+(`--bot` and `--net` let the computer play the local side) */
+
+#define VERSUS_OPTION       "--versus"
+
+#define VERSUS_UDP_OPTION   "--versus-udp"
+
 #endif
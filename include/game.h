@@ -0,0 +1,308 @@
+/* game.h */
+
+#ifndef GAME_H_INCLUDED
+#define GAME_H_INCLUDED
+
+#include "constants.h"
+#include "field.h"
+#include "placement.h"
+
+/* what the player can do with the falling piece; `shift_left` and
+`shift_right` move it as far as it goes in one step (a held key repeating
+instantly), they come last so the recorded actions keep their values */
+typedef enum tag_game_action {
+    no_action, move_left, move_right, rotate_piece, soft_drop, hard_drop,
+    quit_game, shift_left, shift_right
+} game_action;
+
+typedef enum tag_game_event_kind {
+    /* the player did something */
+    input_event,
+    /* the gravity deadline has come */
+    gravity_event
+} game_event_kind;
+
+typedef struct tag_game_event {
+    game_event_kind kind;
+    /* the player's action for the `input_event` */
+    game_action action;
+    /* the time the event happened at, in milliseconds */
+    long time;
+} game_event;
+
+/* the flags telling what the last `game_step` call changed */
+typedef enum tag_game_change {
+    piece_changed      = 1 << 0,
+    field_changed      = 1 << 1,
+    score_changed      = 1 << 2,
+    level_changed      = 1 << 3,
+    next_piece_changed = 1 << 4,
+    game_ended         = 1 << 5
+} game_change;
+
+enum game_layout_consts {
+    cache_line_size = 64,
+    /* the most pieces a game previews */
+    max_preview_pieces = 5
+};
+
+/* the falling piece as the game record keeps it; the piece matrix and the rest
+of `struct_piece` are looked up by the kind and the orientation */
+typedef struct tag_packed_piece {
+    unsigned char kind, orientation;
+    signed char x_shift, y_decline, ghost_decline;
+} packed_piece;
+
+/* one game packed into two cache lines, so a host can keep millions of games
+resident; `game_kernels`, `game_piece`, `game_next_piece` and
+`game_preview_kind` unpack the rest */
+typedef struct tag_game {
+    /* the time the falling piece is moved down by the gravity at */
+    long gravity_deadline;
+    int score;
+    /* the total number of completed lines */
+    int lines;
+    /* the state of the game's own random piece generator */
+    unsigned int rng_state;
+    packed_piece piece;
+    /* the kinds of the previewed pieces, a ring buffer: the next piece is
+    `preview[preview_head]`, the slot it leaves at its spawn gets the piece
+    drawn after the last previewed one */
+    unsigned char preview[max_preview_pieces];
+    unsigned char preview_head, num_of_previews;
+    unsigned char level;
+    /* the number of lines completed since the last level up */
+    unsigned char lines_since_level_up;
+    /* the `field_size` of the game */
+    unsigned char size;
+    /* the topmost field row having occupied cells (the field height if the
+    field is empty), so a line clear moves only the rows under it */
+    unsigned char stack_top;
+    bool game_on;
+    /* the `game_change` flags set by the last `game_step` call */
+    unsigned char changes;
+    /* the lock delay in milliseconds (0 - the classic one: the piece locks
+    at the gravity step after it lands) and the moves restarting it */
+    unsigned short lock_delay;
+    unsigned char move_reset_limit;
+    /* the moves which have restarted the falling piece's lock delay */
+    unsigned char lock_resets;
+    /* set while the falling piece waits for its lock delay to end, the
+    gravity deadline is the time it locks at */
+    bool landed;
+    /* the lines the last step cleared, for the screen to show them going:
+    bit `i` of `cleared_lines` is the row `cleared_top + i` as it was before
+    the rows above it fell */
+    unsigned char cleared_top, cleared_lines;
+    field_row field[max_field_height];
+} __attribute__((aligned(cache_line_size))) game;
+
+/* how the pieces of a game fall and lock and how many of them it previews,
+`init_game` starts a game with the classic rules: the 1st level, no lock delay
+but a gravity step and one previewed piece */
+typedef struct tag_game_rules {
+    int start_level;
+    /* 1 to `max_preview_pieces` */
+    int previews;
+    /* in milliseconds, 0 - the classic lock */
+    int lock_delay;
+    /* the moves and rotations of a landed piece restarting its lock delay */
+    int move_reset_limit;
+} game_rules;
+
+/* the undo journal of `game_place_piece_journaled`: the field rows the
+placement touched and the few record fields it changes */
+typedef struct tag_game_undo {
+    placement_undo field;
+    int score, lines;
+    unsigned int rng_state;
+    packed_piece piece;
+    /* the preview slot the spawn refilled, before it did */
+    unsigned char preview_kind, preview_head;
+    unsigned char level, lines_since_level_up, stack_top;
+    unsigned char lock_resets;
+    bool game_on, landed;
+} game_undo;
+
+void init_set_of_pieces(struct_piece *set_of_pieces);
+/*
+    Fills the set of pieces with every piece in its spawn orientation.
+RECEIVES:
+    - `set_of_pieces` the array of `num_of_pieces` pieces to fill in the
+    `piece_kind` order.
+RETURNES:
+    --- */
+
+void init_game(game *g, field_size size, unsigned int seed, long time);
+/*
+    Starts a new game: the field is empty, the 1st piece is spawned and its
+gravity deadline is set. Precomputes the engine tables the 1st time it's called.
+RECEIVES:
+    - `g` the pointer to the game to initialize;
+    - `size` the field size;
+    - `seed` the seed of the game's random piece generator (0 is replaced);
+    - `time` the current time in milliseconds.
+RETURNES:
+    --- */
+
+void set_game_rules(game *g, const game_rules *rules, long time);
+/*
+    Changes the rules of a game just started: its level, its lock delay, the
+number of the moves restarting the lock delay and the number of the previewed
+pieces. The pieces added to the preview are the ones drawn next anyway, so the
+pieces of a game don't depend on how many of them are previewed.
+RECEIVES:
+    - `g` the pointer to the game started by `init_game`;
+    - `rules` the pointer to the rules (the level and the number of the
+    previewed pieces are clamped to the 1st to `maximum_game_level` and
+    `max_preview_pieces` ranges);
+    - `time` the current time in milliseconds.
+RETURNES:
+    ---
+    `g->changes` gets what the rules changed added to the changes of the
+    game start. */
+
+const field_kernels *game_kernels(const game *g);
+/*
+    Gives access to the engine kernels for the game's field size.
+RECEIVES:
+    - `g` the pointer to the game.
+RETURNES:
+    - the pointer to the kernels. */
+
+struct_piece game_piece(const game *g);
+/*
+    Unpacks the falling piece of the game.
+RECEIVES:
+    - `g` the pointer to the game.
+RETURNES:
+    - the falling piece with its matrix in the current orientation. */
+
+struct_piece game_piece_at(
+    piece_kind kind, position orientation, int x_shift, int y_decline
+);
+/*
+    Builds a piece at the given position, the way a game would unpack it.
+RECEIVES:
+    - `kind`, `orientation` the piece and its orientation;
+    - `x_shift`, `y_decline` the piece coordinates to the top left field
+    corner.
+RETURNES:
+    - the piece with its matrix in the orientation (its ghost is at the piece
+    itself). */
+
+struct_piece game_next_piece(const game *g);
+/*
+    Unpacks the piece that spawns next.
+RECEIVES:
+    - `g` the pointer to the game.
+RETURNES:
+    - the next piece in its spawn orientation. */
+
+piece_kind game_preview_kind(const game *g, int i);
+/*
+    Tells the kind of a previewed piece.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `i` the piece's place in the preview, 0 (the next piece) to
+    `g->num_of_previews - 1`.
+RETURNES:
+    - the kind of the piece. */
+
+void game_step(game *g, const game_event *event);
+/*
+    Advances the game by one event: applies the player's action or the gravity
+to the falling piece, locks it, clears the completed lines, updates the score
+and the level and spawns the next piece as necessary. Never blocks, so one
+thread can drive any number of games by calling it for each game's own events.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `event` the event to process.
+RETURNES:
+    ---
+    `g->changes` tells what the step changed, `g->gravity_deadline` - when the
+    game needs the next `gravity_event`. */
+
+bool game_place_piece(game *g, const placement *p);
+/*
+    Puts the falling piece straight to the placement, then locks it like
+`game_step` does. Lets a search driven player skip the moves leading there.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `p` the pointer to a placement of the falling piece.
+RETURNES:
+    - the boolean value indicating whether the piece was placed (it isn't if
+    the game is over or the placement is taken by field cells).
+    `g->changes` tells what the placement changed. */
+
+bool game_place_piece_journaled(
+    game *g, const placement *p, game_undo *undo
+);
+/*
+    The same as `game_place_piece`, but journals the changes first, so
+`game_undo_placement` can revert them without a copy of the whole game.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `p` the pointer to a placement of the falling piece;
+    - `undo` the pointer to the journal to fill.
+RETURNES:
+    - the boolean value indicating whether the piece was placed; if it wasn't,
+    the game is left as it was and the journal is of no use. */
+
+void game_undo_placement(game *g, const game_undo *undo);
+/*
+    Reverts a journaled placement: the field, the score, the lines, the level,
+the falling and the next piece and the random piece generator are restored.
+RECEIVES:
+    - `g` the pointer to the game right after the placement;
+    - `undo` the pointer to the placement's journal.
+RETURNES:
+    ---
+    `g->changes` tells what the reversion changed. */
+
+void game_add_garbage(game *g, int num_of_rows, int hole_x);
+/*
+    Pushes garbage rows in from the bottom of the field: the field rises by
+`num_of_rows` rows and the new rows are full but for one hole. The falling
+piece stays where it is unless the rising cells take its place, then it's
+pushed up above them. The game ends if occupied rows rise above the field or
+the piece can't be pushed up.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `num_of_rows` the number of garbage rows;
+    - `hole_x` the column of the hole in every garbage row, 0 to the field
+    width - 1 (a column outside the field is taken as the nearest one).
+RETURNES:
+    ---
+    `g->changes` tells what the garbage changed. */
+
+int gravity_delay(int level);
+/*
+    Gives the time between two gravity steps.
+RECEIVES:
+    - `level` the game level.
+RETURNES:
+    - the piece fall step delay in milliseconds. */
+
+int gravity_rows(int level);
+/*
+    Gives the number of cells a piece falls by in one gravity step: one up
+to the `last_classic_gravity_level`, a whole frame's worth after it.
+RECEIVES:
+    - `level` the game level.
+RETURNES:
+    - the number of cells (`twentieth` or more - the piece lands at once). */
+
+int score_bonus(int level, int num_of_completed_lines);
+/*
+    Gives the number of scores for completing lines at a time.
+RECEIVES:
+    - `level` the game level;
+    - `num_of_completed_lines` the number of lines completed at a time.
+RETURNES:
+    - the score bonus.
+ERROR HANDLING:
+    - if `num_of_completed_lines` isn't in the 1..4 range, an error message is
+    printed and the program terminates. */
+
+#endif
@@ -0,0 +1,86 @@
+/* key_repeat.h */
+
+#ifndef KEY_REPEAT_H_INCLUDED
+#define KEY_REPEAT_H_INCLUDED
+
+#include "game.h"
+
+enum key_repeat_consts {
+    /* the longest gap between two presses of a key the terminal repeats
+    because it's held, in milliseconds: the terminals repeat a held key 25 to
+    40 times a second, and nobody taps a key that fast */
+    max_terminal_repeat_gap = 60,
+    /* how long the 1st repeat of a held key may come after the press (the
+    terminal's own delay before it repeats), in milliseconds */
+    max_terminal_repeat_delay = 700,
+    /* how often a key held with the instant repeat rate shifts the piece
+    again, so the piece stays at the wall after a rotation, in milliseconds */
+    instant_repeat_interval = 16
+};
+
+/* the left or the right key held down: the terminal tells the key presses
+only, so a key is known to be held once the terminal repeats it, and to be
+released once the repeats stop; the piece is then moved by the game clock,
+the delayed auto shift (DAS) after the press and one cell every auto repeat
+rate (ARR) interval after it, not by the terminal's repeats; the 1st repeat
+can't be told from a tap, so it moves the piece once like a tap does and the
+repeats after it go on an ARR interval later, which makes a DAS shorter than
+the terminal's repeat delay take effect only at that delay */
+typedef struct tag_key_repeat {
+    /* in milliseconds, the ARR 0 moves the piece to the wall at once */
+    int das, arr;
+    /* `move_left`, `move_right` or `no_action` if neither key was pressed */
+    game_action direction;
+    /* the time the key was pressed at and the time it came last at */
+    long pressed_at, last_seen;
+    /* the last gap between two repeats of the held key */
+    long repeat_gap;
+    bool held;
+    /* the time of the next move of the held key */
+    long next_shift;
+} key_repeat;
+
+void init_key_repeat(key_repeat *k, int das, int arr);
+/*
+    Starts tracking the left and the right keys, neither of them held.
+RECEIVES:
+    - `k` the pointer to the tracker to initialize;
+    - `das`, `arr` the delayed auto shift and the auto repeat rate in
+    milliseconds (the negative ones are taken as 0).
+RETURNES:
+    --- */
+
+game_action key_repeat_press(key_repeat *k, game_action action, long time);
+/*
+    Takes the action of a key the player pressed: a press of the left or the
+right key moves the piece once, a repeat of the held key is left to
+`key_repeat_due`.
+RECEIVES:
+    - `k` the pointer to the tracker;
+    - `action` the action the key stands for;
+    - `time` the time the key came at, in milliseconds.
+RETURNES:
+    - the action to take now, `no_action` for a repeat of the held key. */
+
+long key_repeat_deadline(const key_repeat *k);
+/*
+    Tells when the held key needs `key_repeat_due` next: to move the piece or
+to find the key released.
+RECEIVES:
+    - `k` the pointer to the tracker.
+RETURNES:
+    - the time in milliseconds, `LONG_MAX` if no key is held. */
+
+game_action key_repeat_due(key_repeat *k, long time);
+/*
+    Moves the piece by the held key once its deadline has come, or finds the
+key released if the terminal has stopped repeating it.
+RECEIVES:
+    - `k` the pointer to the tracker;
+    - `time` the current time in milliseconds, not before
+    `key_repeat_deadline`.
+RETURNES:
+    - the action to take: a move, a shift to the wall for the ARR 0, or
+    `no_action` if there's none due. */
+
+#endif
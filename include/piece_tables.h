@@ -0,0 +1,84 @@
+/* piece_tables.h */
+
+#ifndef PIECE_TABLES_H_INCLUDED
+#define PIECE_TABLES_H_INCLUDED
+
+#include "constants.h"
+
+typedef struct tag_piece_masks {
+    /* the piece matrix rows at a given `x_shift` (a cell outside the field
+    lands on the wall bits) */
+    piece_row rows[big_piece_size];
+} piece_masks;
+
+typedef struct tag_piece_orientation {
+    /* the piece matrix in this orientation */
+    union tag_form form;
+    /* the {x, y} matrix coordinates of the piece's occupied cells */
+    signed char cells[piece_cells][2];
+    /* the matrix columns and rows the piece cells occupy */
+    signed char min_x, max_x, min_y, max_y;
+    /* whether a boundary push-back moves the piece by one cell for every
+    crossing cell or just once (only the I piece lying along the crossed
+    boundary is pushed cell by cell) */
+    bool push_each_side_cell, push_each_bottom_top_cell;
+    /* whether an earlier orientation of the piece has the same cells shifted,
+    so a search over the piece placements can skip this one */
+    bool duplicate;
+    /* the piece masks for every `x_shift` from `min_piece_x_shift` to
+    `max_piece_x_shift` */
+    piece_masks masks[num_of_piece_x_shifts];
+} piece_orientation;
+
+void init_piece_tables(const struct_piece *set_of_pieces);
+/*
+    Precomputes every orientation of every piece by rotating the spawn matrices
+from `set_of_pieces`. Must be called once before any other function of this
+module is used.
+RECEIVES:
+    - `set_of_pieces` the array of `num_of_pieces` pieces in their spawn
+    orientation, in the `piece_kind` order.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if a piece doesn't consist of exactly `piece_cells` cells, an error
+    message is printed and the program terminates. */
+
+const piece_orientation *get_piece_orientation(
+    piece_kind kind, position orientation
+);
+/*
+    Gives access to a precomputed piece orientation.
+RECEIVES:
+    - `kind` the piece;
+    - `orientation` the number of clockwise rotations from the spawn
+    orientation.
+RETURNES:
+    - the pointer to the piece orientation description. */
+
+const piece_masks *get_piece_masks(
+    piece_kind kind, position orientation, int x_shift
+);
+/*
+    Gives access to the precomputed piece masks, so a collision with the field
+cells and the side walls is a bitwise AND per piece row. The masks don't depend
+on the field width, the walls are in the field rows.
+RECEIVES:
+    - `kind` the piece;
+    - `orientation` the number of clockwise rotations from the spawn
+    orientation;
+    - `x_shift` the piece shift to the left border of the field.
+RETURNES:
+    - the pointer to the piece masks, or NULL if `x_shift` is out of the
+    precomputed range (the piece is too far outside the field). */
+
+position next_orientation_of(position orientation);
+/*
+    Traverses the list of orientations cyclically (after the last value, we get
+the 1st value again).
+RECEIVES:
+    - `orientation` the current orientation.
+RETURNES:
+    - the orientation after one more clockwise rotation. */
+
+#endif
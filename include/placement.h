@@ -0,0 +1,123 @@
+/* placement.h */
+
+#ifndef PLACEMENT_H_INCLUDED
+#define PLACEMENT_H_INCLUDED
+
+#include "arena.h"
+#include "constants.h"
+#include "field.h"
+
+enum placement_consts {
+    /* the upper bound of the number of placements of one piece */
+    max_num_of_placements = orientation_count * max_field_width
+};
+
+/* where a piece dropped straight down from the top of the field lands */
+typedef struct tag_placement {
+    piece_kind kind;
+    position orientation;
+    signed char x_shift, y_decline;
+} placement;
+
+/* the undo journal of one placement: only the rows the piece was locked into
+and the lines it completed, so the placement is reverted in time proportional
+to the rows it touched, not to the field size */
+typedef struct tag_placement_undo {
+    /* the 1st row the piece covers, and the covered rows as they were */
+    signed char first_row, num_of_rows;
+    field_row rows[big_piece_size];
+    /* the completed lines, top down (they were full, so only the indices are
+    kept) */
+    signed char num_of_cleared;
+    signed char cleared[max_num_of_completed_lines];
+} placement_undo;
+
+placement *enumerate_placements(
+    const field_kernels *kernels, const field_row *field, piece_kind kind,
+    arena *a, int *num_of_placements
+);
+/*
+    Lists every distinct placement of the piece: each orientation (the shifted
+copies of an earlier one are skipped) at each `x_shift` the piece fits the field
+at, dropped from the spawn row.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the current field state;
+    - `kind` the piece;
+    - `a` the arena the list is allocated in;
+    - `num_of_placements` the pointer to store the list length to.
+RETURNES:
+    - the pointer to the list in the arena (the arena keeps the whole
+    `max_num_of_placements` block for it). */
+
+field_row *snapshot_field(
+    const field_kernels *kernels, const field_row *field, arena *a
+);
+/*
+    Copies the field into the arena, so a placement can be tried on the copy.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state;
+    - `a` the arena the copy is allocated in.
+RETURNES:
+    - the pointer to the copy. */
+
+int apply_placement(
+    const field_kernels *kernels, field_row *field, const placement *p
+);
+/*
+    Locks the piece at the placement and clears the completed lines.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state to change;
+    - `p` the pointer to the placement.
+RETURNES:
+    - the number of cleared lines. */
+
+void record_placement(
+    const field_kernels *kernels, const field_row *field, const placement *p,
+    placement_undo *undo
+);
+/*
+    Journals what the placement is going to change: the rows the piece covers
+and the lines it completes. Must be called before the placement is applied to
+the field, by `apply_placement` or in any other way.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state before the
+    placement;
+    - `p` the pointer to the placement;
+    - `undo` the pointer to the journal to fill.
+RETURNES:
+    --- */
+
+int apply_placement_journaled(
+    const field_kernels *kernels, field_row *field, const placement *p,
+    placement_undo *undo
+);
+/*
+    The same as `apply_placement`, but journals the changes first, so
+`undo_placement` can revert them.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state to change;
+    - `p` the pointer to the placement;
+    - `undo` the pointer to the journal to fill.
+RETURNES:
+    - the number of cleared lines. */
+
+void undo_placement(
+    const field_kernels *kernels, field_row *field, const placement_undo *undo
+);
+/*
+    Reverts a journaled placement: puts the cleared lines back, moving the rows
+above them up, then restores the rows the piece covered.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state right after the
+    placement;
+    - `undo` the pointer to the placement's journal.
+RETURNES:
+    --- */
+
+#endif
@@ -0,0 +1,85 @@
+/* policy.h */
+
+#ifndef POLICY_H_INCLUDED
+#define POLICY_H_INCLUDED
+
+#include "arena.h"
+#include "board_net.h"
+#include "game.h"
+#include "placement.h"
+#include "rollout.h"
+#include "search.h"
+
+enum policy_consts {
+    /* the pieces the search policy looks at by default: the falling one and
+    the next */
+    search_policy_depth = 2,
+    /* the most pieces it can look at: the falling one and the whole
+    preview */
+    max_search_policy_depth = 1 + max_preview_pieces
+};
+
+/* a computer player: picks where the falling piece goes; the terminal game and
+the headless tools drive any policy the same way */
+typedef struct tag_player_policy {
+    const char *name;
+    bool (*choose)(
+        const struct tag_player_policy *policy, const game *g, arena *a,
+        placement *move
+    );
+    /* the policy's own data */
+    const heuristic_weights *weights;
+    int depth;
+    const board_net *net;
+    const rollout_config *rollouts;
+} player_policy;
+
+void init_search_policy(
+    player_policy *policy, const heuristic_weights *weights, int depth
+);
+/*
+    Makes the policy play by the lookahead search over the falling piece and
+the previewed ones.
+RECEIVES:
+    - `policy` the pointer to the policy to initialize;
+    - `weights` the pointer to the heuristic weights the search maximizes;
+    - `depth` the number of the pieces the search looks at, 1 (the falling
+    one) to `max_search_policy_depth` (no more than the game previews are
+    looked at).
+RETURNES:
+    --- */
+
+void init_net_policy(player_policy *policy, const board_net *net);
+/*
+    Makes the policy play by the board net scoring every placement of the
+falling piece in one batch.
+RECEIVES:
+    - `policy` the pointer to the policy to initialize;
+    - `net` the pointer to the loaded net.
+RETURNES:
+    --- */
+
+void init_rollout_policy(player_policy *policy, const rollout_config *config);
+/*
+    Makes the policy play the placement of the falling piece with the best
+mean reward of the Monte Carlo rollouts, a slow but strong reference player.
+RECEIVES:
+    - `policy` the pointer to the policy to initialize;
+    - `config` the pointer to the rollout evaluation config, kept by the
+    policy.
+RETURNES:
+    --- */
+
+bool policy_move(const player_policy *policy, game *g, arena *a);
+/*
+    Lets the policy place the falling piece.
+RECEIVES:
+    - `policy` the pointer to the policy;
+    - `g` the pointer to the game;
+    - `a` the arena the policy works in, left as it was found.
+RETURNES:
+    - the boolean value indicating whether the piece was placed (it isn't if
+    the game is over or the piece can't be placed anywhere).
+    `g->changes` tells what the move changed. */
+
+#endif
@@ -0,0 +1,92 @@
+/* render_queue.h */
+
+#ifndef RENDER_QUEUE_H_INCLUDED
+#define RENDER_QUEUE_H_INCLUDED
+
+#include "game.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+enum render_queue_consts {
+    /* the state the producer writes, the one the consumer draws and the
+    published one between them */
+    num_of_render_states = 3,
+    /* the flag of the published state's index telling the consumer hasn't
+    taken it yet */
+    fresh_state = 1 << 2
+};
+
+/* draws the game state; `g->changes` tells what changed since the state it
+drew the last time */
+typedef void (*render_callback)(const game *g, void *ctx);
+
+/* a single-producer/single-consumer exchange of game states: the thread
+running the game publishes a state after every step that changed something,
+the render thread takes the latest published one at most once a frame; the
+three states are swapped by one atomic exchange each side, so neither side
+ever waits for the other */
+typedef struct tag_render_queue {
+    game states[num_of_render_states];
+    /* the index of the published state, on its own cache line */
+    _Alignas(cache_line_size) atomic_uint published;
+    /* the producer's and the consumer's own state indices */
+    _Alignas(cache_line_size) unsigned int back;
+    unsigned int front;
+    atomic_bool running;
+    render_callback draw;
+    /* called every frame with the last drawn state, NULL if nothing moves
+    on the screen between the states */
+    render_callback animate;
+    /* set once a state has been drawn */
+    bool drawn;
+    void *ctx;
+    /* the shortest time between two frames in milliseconds */
+    int frame_interval;
+    pthread_t thread;
+} render_queue;
+
+void start_render_thread(
+    render_queue *q, render_callback draw, render_callback animate, void *ctx,
+    int frame_interval
+);
+/*
+    Empties the queue and starts the thread drawing the states posted to it.
+Once a frame the thread takes the latest state posted since the last frame,
+carrying the changes of every state posted meanwhile, so a slow terminal makes
+the frames rarer instead of holding the game up. An animation plays on the
+render thread alone, so it never holds the game up either.
+RECEIVES:
+    - `q` the pointer to the queue;
+    - `draw` the function drawing a state (called by the render thread only);
+    - `animate` the function advancing the screen's animations, called every
+    frame once a state has been drawn, with the last drawn state (its
+    `changes` are the ones drawn already), or NULL;
+    - `ctx` the pointer passed to `draw` and `animate`;
+    - `frame_interval` the shortest time between two frames in milliseconds.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the thread can't be started, an error message is printed and the
+    program terminates. */
+
+void post_game_state(render_queue *q, const game *g);
+/*
+    Publishes a copy of the game state without waiting. If the state it
+replaces hasn't been taken by the render thread, the replaced state's changes
+are added to the new one. Must be called by one thread only.
+RECEIVES:
+    - `q` the pointer to the queue;
+    - `g` the pointer to the game.
+RETURNES:
+    --- */
+
+void stop_render_thread(render_queue *q);
+/*
+    Lets the render thread draw the state left in the queue and waits for it
+to finish, so the calling thread can draw again.
+RECEIVES:
+    - `q` the pointer to the queue.
+RETURNES:
+    --- */
+
+#endif
@@ -0,0 +1,128 @@
+/* replay.h */
+
+#ifndef REPLAY_H_INCLUDED
+#define REPLAY_H_INCLUDED
+
+#include "game.h"
+
+enum replay_consts {
+    /* the game time between two keyframes in milliseconds: a seek
+    re-simulates at most this much of the game */
+    default_keyframe_interval = 5000
+};
+
+/* one recorded `game_step` call, its time relative to the recording start */
+typedef struct tag_recorded_event {
+    unsigned int time;
+    unsigned char kind, action;
+} recorded_event;
+
+/* the game as it was at a keyframe time: the game record itself (the packed
+field, the piece, the random generator state, the score and the level) and the
+1st event after it */
+typedef struct tag_keyframe {
+    game state;
+    unsigned int first_event;
+} keyframe;
+
+/* a recorded game: the events every step was made by and a keyframe every
+`keyframe_interval` milliseconds of it, keyframe `k` is the game at
+`start_time + k * keyframe_interval` */
+typedef struct tag_recording {
+    long start_time;
+    unsigned int keyframe_interval;
+    recorded_event *events;
+    unsigned int num_of_events, events_capacity;
+    keyframe *keyframes;
+    unsigned int num_of_keyframes, keyframes_capacity;
+    /* the game after the last recorded event, the next keyframe is made of
+    it */
+    game last_state;
+} recording;
+
+void init_recording(
+    recording *r, const game *g, long time, unsigned int keyframe_interval
+);
+/*
+    Starts recording a game; the game as it is now becomes the 1st keyframe.
+RECEIVES:
+    - `r` the pointer to the recording to initialize;
+    - `g` the pointer to the game, started by `init_game`;
+    - `time` the time the game was started at in milliseconds;
+    - `keyframe_interval` the game time between two keyframes in milliseconds
+    (0 - `default_keyframe_interval`).
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the memory can't be allocated, an error message is printed and the
+    program terminates. */
+
+void free_recording(recording *r);
+/*
+    Frees the memory of the recording.
+RECEIVES:
+    - `r` the pointer to the recording.
+RETURNES:
+    --- */
+
+void record_step(recording *r, const game_event *event, const game *g);
+/*
+    Records a step of the game, adding the keyframes due before it.
+RECEIVES:
+    - `r` the pointer to the recording;
+    - `event` the pointer to the event the step was made by (the events come
+    in the order of their time);
+    - `g` the pointer to the game after the step.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the memory can't be allocated, an error message is printed and the
+    program terminates. */
+
+void save_recording(const recording *r, const char *file_name);
+/*
+    Writes the recording with its keyframes to the file.
+RECEIVES:
+    - `r` the pointer to the recording;
+    - `file_name` the file name.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be written, an error message is printed and the
+    program terminates. */
+
+void load_recording(recording *r, const char *file_name);
+/*
+    Reads a recording written by `save_recording`.
+RECEIVES:
+    - `r` the pointer to the recording to initialize;
+    - `file_name` the file name.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be read or it isn't a recording of this build, an
+    error message is printed and the program terminates. */
+
+long recording_duration(const recording *r);
+/*
+    Gives the time the recorded game took.
+RECEIVES:
+    - `r` the pointer to the recording.
+RETURNES:
+    - the time from the start to the last event in milliseconds. */
+
+unsigned int seek_recording(const recording *r, long time, game *g);
+/*
+    Restores the game as it was at the given time: starts from the last
+keyframe before it and re-simulates only the events since the keyframe, so
+the cost doesn't depend on how far into the game the time is.
+RECEIVES:
+    - `r` the pointer to the recording;
+    - `time` the time from the recording start in milliseconds (clamped to
+    the recorded time);
+    - `g` the pointer to store the game to.
+RETURNES:
+    - the number of the events made up to the time (the index of the 1st
+    event after it). */
+
+#endif
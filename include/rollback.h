@@ -0,0 +1,105 @@
+/* rollback.h */
+
+#ifndef ROLLBACK_H_INCLUDED
+#define ROLLBACK_H_INCLUDED
+
+#include "versus.h"
+
+enum rollback_consts {
+    /* the most frames a late input can reach back: the match doesn't run
+    further ahead of the inputs it knows (256 ms at 16 ms a frame) */
+    max_rollback_frames = 16,
+    /* the inputs kept for each player, the ones still to be sent again
+    included */
+    rollback_input_frames = 4 * max_rollback_frames
+};
+
+/* a versus match run ahead of the other player's inputs: the missing inputs
+are predicted, and when an input comes which isn't the predicted one, the
+match is restored from the snapshot of its frame and simulated again */
+typedef struct tag_rollback_session {
+    versus_match match;
+    /* the match before frame `f` is `snapshots[f % max_rollback_frames]` */
+    versus_match snapshots[max_rollback_frames];
+    /* player `p`'s action at frame `f` is
+    `inputs[f % rollback_input_frames][p]` once it's confirmed */
+    unsigned char inputs[rollback_input_frames][num_of_versus_players];
+    /* the number of the frames each player's inputs are confirmed for */
+    unsigned int confirmed[num_of_versus_players];
+    /* the 1st frame simulated with a wrong prediction, if `rollback_due` */
+    unsigned int rollback_from;
+    bool rollback_due;
+    /* the number of the rollbacks, the frames they simulated again and the
+    deepest one */
+    unsigned long rollbacks, resimulated_frames;
+    unsigned int max_rollback_depth;
+} rollback_session;
+
+void init_rollback_session(
+    rollback_session *s, field_size size, unsigned int seed
+);
+/*
+    Starts a match no input of which is known yet.
+RECEIVES:
+    - `s` the pointer to the session to initialize;
+    - `size`, `seed` the match's field size and seed (see
+    `init_versus_match`).
+RETURNES:
+    --- */
+
+bool set_rollback_input(
+    rollback_session *s, int player, unsigned int frame, game_action action
+);
+/*
+    Confirms a player's action at a frame. The frames of each player are
+confirmed one by one, so an input already known or coming before the ones
+preceding it is ignored (the sender sends it again). If the frame has been
+simulated with another action predicted, the next `advance_rollback` call
+rolls the match back to it.
+RECEIVES:
+    - `s` the pointer to the session;
+    - `player` the player's index;
+    - `frame` the frame the action was taken at;
+    - `action` the action (`no_action` if the player did nothing).
+RETURNES:
+    - the boolean value indicating whether the input was taken: it isn't if
+    it's known already, if the frames before it aren't confirmed or if it's
+    too far ahead of the other player's confirmed inputs. */
+
+game_action rollback_input(
+    const rollback_session *s, int player, unsigned int frame
+);
+/*
+    Gives a player's action at a frame, the confirmed one or the predicted
+one (no action: keys are pressed at some frames only, so the player is
+predicted to press nothing).
+RECEIVES:
+    - `s` the pointer to the session;
+    - `player` the player's index;
+    - `frame` the frame, one of the last `rollback_input_frames` confirmed
+    frames of the player or a frame after them.
+RETURNES:
+    - the action. */
+
+bool advance_rollback(rollback_session *s);
+/*
+    Rolls the match back and simulates it again if a wrong prediction has
+been found, then simulates the next frame if the match isn't too far ahead of
+the confirmed inputs. A board simulated again gets all its `changes` flags
+set, so it's drawn anew.
+RECEIVES:
+    - `s` the pointer to the session.
+RETURNES:
+    - the boolean value indicating whether the next frame was simulated. */
+
+versus_result rollback_outcome(const rollback_session *s);
+/*
+    Tells the outcome of the match as far as the confirmed inputs tell it: a
+game over predicted from unconfirmed inputs can still be rolled back.
+RECEIVES:
+    - `s` the pointer to the session, right after `advance_rollback`.
+RETURNES:
+    - the outcome of the match at the last frame all the inputs are confirmed
+    for (`match_goes_on` while the outcome isn't certain). */
+
+#endif
@@ -0,0 +1,77 @@
+/* rollout.h */
+
+#ifndef ROLLOUT_H_INCLUDED
+#define ROLLOUT_H_INCLUDED
+
+#include "game.h"
+#include "placement.h"
+#include "search.h"
+
+enum rollout_consts {
+    /* the upper bound of the number of rollout threads */
+    max_rollout_threads = 64
+};
+
+typedef struct tag_rollout_config {
+    int num_of_threads;
+    /* the number of pieces played after the evaluated placement */
+    int depth;
+    /* the wall-clock time the evaluation may take in milliseconds (0 - no
+    limit); every thread makes at least one rollout per placement anyway */
+    long budget_ms;
+    /* the number of rollouts per placement the evaluation stops at, even if
+    the time budget isn't spent (0 - no limit) */
+    long max_rollouts;
+    /* the seed the threads' random streams are derived from */
+    unsigned int seed;
+    /* the weights of the greedy policy playing the rollouts */
+    const heuristic_weights *weights;
+} rollout_config;
+
+/* the rewards the rollouts starting with one placement got */
+typedef struct tag_rollout_stats {
+    placement move;
+    long num_of_rollouts;
+    /* the score gained by the rollouts (the `score_bonus` rules) */
+    double mean, variance;
+} rollout_stats;
+
+void init_rollout_config(rollout_config *config);
+/*
+    Fills the config with the defaults: a thread per online CPU, 10 pieces
+deep, 100 ms, no rollouts limit, the default heuristic weights.
+RECEIVES:
+    - `config` the pointer to the config to fill.
+RETURNES:
+    --- */
+
+int evaluate_placements(
+    const game *g, const rollout_config *config, rollout_stats *stats
+);
+/*
+    Scores every placement of the falling piece by Monte Carlo rollouts: the
+piece is put to the placement, then the game goes on `config->depth` pieces
+with random pieces after the previewed ones, played by the greedy search. Every
+thread makes a round of rollouts of every placement at a time, with its own
+statistics, random stream and search arena, so the threads share nothing until
+their sums are added up per placement.
+RECEIVES:
+    - `g` the pointer to the game;
+    - `config` the pointer to the evaluation config;
+    - `stats` the array of `max_num_of_placements` entries to fill.
+RETURNES:
+    - the number of the placements evaluated (0 if the game is over).
+ERROR HANDLING:
+    - if a thread can't be started, an error message is printed and the
+    program terminates. */
+
+const rollout_stats *best_rollout_stats(const rollout_stats *stats, int n);
+/*
+    Picks the placement with the best mean reward.
+RECEIVES:
+    - `stats` the array of the evaluated placements;
+    - `n` the number of the placements.
+RETURNES:
+    - the pointer to the best entry, or NULL if `n` is 0. */
+
+#endif
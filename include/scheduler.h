@@ -0,0 +1,103 @@
+/* scheduler.h */
+
+#ifndef SCHEDULER_H_INCLUDED
+#define SCHEDULER_H_INCLUDED
+
+#include "game.h"
+
+enum scheduler_consts {
+    /* the maximum number of actions waiting to be processed per game */
+    max_pending_actions = 16
+};
+
+/* the scheduling state of one game, kept apart from the game records so they
+stay two cache lines each */
+typedef struct tag_game_slot {
+    /* the game's position in the deadline heap, -1 if the game is over */
+    int heap_index;
+    /* the player's actions waiting to be processed, in the order they came
+    (a ring buffer of `game_action` values) */
+    unsigned char pending[max_pending_actions];
+    unsigned char first_pending, num_of_pending;
+    /* whether the game is in the list of games woken by input */
+    bool woken;
+} game_slot;
+
+/* called after every step of a scheduled game */
+typedef void (*step_callback)(int game_id, const game *g, void *ctx);
+
+typedef struct tag_scheduler {
+    game *games;
+    game_slot *slots;
+    int num_of_games;
+    /* the running game ids ordered by their gravity deadlines (a binary
+    min-heap) */
+    int *deadline_heap;
+    int heap_size;
+    /* the ids of the games with pending actions */
+    int *woken_games;
+    int num_of_woken;
+} scheduler;
+
+void init_scheduler(
+    scheduler *s, int num_of_games, field_size size, unsigned int seed,
+    long time
+);
+/*
+    Starts `num_of_games` games driven by one scheduler. Every game gets its
+own random piece generator seed derived from `seed`.
+RECEIVES:
+    - `s` the pointer to the scheduler to initialize;
+    - `num_of_games` the number of games;
+    - `size` the field size of the games;
+    - `seed` the seed the games' seeds are derived from;
+    - `time` the current time in milliseconds.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the memory can't be allocated, an error message is printed and the
+    program terminates. */
+
+void free_scheduler(scheduler *s);
+/*
+    Frees the memory allocated by `init_scheduler`.
+RECEIVES:
+    - `s` the pointer to the scheduler.
+RETURNES:
+    --- */
+
+bool post_action(scheduler *s, int game_id, game_action action);
+/*
+    Queues the player's action for the game and wakes the game up at the next
+`run_scheduler` call.
+RECEIVES:
+    - `s` the pointer to the scheduler;
+    - `game_id` the game index;
+    - `action` the player's action.
+RETURNES:
+    - the boolean value indicating whether the action was queued (it isn't if
+    the game is over or its queue is full). */
+
+int run_scheduler(scheduler *s, long now, step_callback on_step, void *ctx);
+/*
+    Processes the actions of the woken games and the gravity of the games whose
+deadline has come. The other games are not touched at all.
+RECEIVES:
+    - `s` the pointer to the scheduler;
+    - `now` the current time in milliseconds;
+    - `on_step` the function called after every game step, can be NULL;
+    - `ctx` the pointer passed to `on_step`.
+RETURNES:
+    - the number of the game steps made. */
+
+long next_deadline(const scheduler *s);
+/*
+    Gives the time the scheduler has to be run at next, unless an action is
+posted earlier.
+RECEIVES:
+    - `s` the pointer to the scheduler.
+RETURNES:
+    - the earliest gravity deadline of the running games in milliseconds, or
+    -1 if every game is over. */
+
+#endif
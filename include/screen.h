@@ -0,0 +1,99 @@
+/* screen.h */
+
+#ifndef SCREEN_H_INCLUDED
+#define SCREEN_H_INCLUDED
+
+typedef enum tag_screen_backend_kind {
+    /* draws through the ncurses library */
+    ncurses_screen,
+    /* composes every frame into a buffer of raw ANSI escape sequences and
+    writes it to the terminal at once */
+    ansi_screen
+} screen_backend_kind;
+
+/* the keys the game distinguishes (besides the space bar and the Esc key,
+which are returned as their character codes) */
+typedef enum tag_screen_key {
+    no_key    = -1,
+    key_left  = 0x100,
+    key_right,
+    key_up,
+    key_down
+} screen_key;
+
+void screen_init(screen_backend_kind kind);
+/*
+    Prepares the terminal for the game using the chosen backend: hides the
+cursor, turns off the input echo and line buffering.
+RECEIVES:
+    - `kind` the backend all the other functions of this module will use.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the terminal can't be prepared, an error message is printed and the
+    program terminates. */
+
+void screen_end();
+/*
+    Restores the terminal state changed by `screen_init`.
+RECEIVES:
+    ---
+RETURNES:
+    --- */
+
+void screen_size(int *row, int *col);
+/*
+    Gives the terminal size in character cells.
+RECEIVES:
+    - `row`, `col` the pointers to store the number of rows and columns.
+RETURNES:
+    --- */
+
+void screen_put_str(int y, int x, const char *str);
+/*
+    Puts the string to the frame being composed. It appears on the terminal
+after `screen_flush` is called.
+RECEIVES:
+    - `y`, `x` the terminal coordinates of the string's 1st character;
+    - `str` the string.
+RETURNES:
+    --- */
+
+void screen_clear();
+/*
+    Makes the frame being composed empty.
+RECEIVES:
+    ---
+RETURNES:
+    --- */
+
+void screen_flush();
+/*
+    Shows the composed frame on the terminal.
+RECEIVES:
+    ---
+RETURNES:
+    --- */
+
+int screen_get_key(int delay);
+/*
+    Shows the composed frame and waits for a key press.
+RECEIVES:
+    - `delay` the maximum time to wait in milliseconds, or a negative value to
+    wait as long as it takes.
+RETURNES:
+    - one of the `screen_key` values, or the code of the pressed character;
+    `no_key` if no key was pressed in time. */
+
+int screen_read_key(int delay);
+/*
+    Waits for a key press without showing the frame, so one thread can read
+the keys while another one draws.
+RECEIVES:
+    - `delay` the maximum time to wait in milliseconds, or a negative value to
+    wait as long as it takes.
+RETURNES:
+    - one of the `screen_key` values, or the code of the pressed character;
+    `no_key` if no key was pressed in time. */
+
+#endif
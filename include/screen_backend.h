@@ -0,0 +1,47 @@
+/* screen_backend.h */
+
+#ifndef SCREEN_BACKEND_H_INCLUDED
+#define SCREEN_BACKEND_H_INCLUDED
+
+/* the operations every screen backend implements, see `screen.h` for their
+descriptions */
+typedef struct tag_screen_backend {
+    void (*init)(void);
+    void (*end)(void);
+    void (*size)(int *row, int *col);
+    void (*put_str)(int y, int x, const char *str);
+    void (*clear)(void);
+    void (*flush)(void);
+    int (*get_key)(int delay);
+    int (*read_key)(int delay);
+} screen_backend;
+
+int read_terminal_key(int delay);
+/*
+    Waits for a key press and reads it straight from the terminal input,
+decoding the arrow keys' escape sequences (both the `ESC [` and the keypad
+transmit `ESC O` forms). Draws nothing.
+RECEIVES:
+    - `delay` the maximum time to wait in milliseconds, or a negative value to
+    wait as long as it takes.
+RETURNES:
+    - one of the `screen_key` values, or the code of the pressed character;
+    `no_key` if no key was pressed in time. */
+
+const screen_backend *get_ncurses_screen_backend();
+/*
+    Gives access to the backend drawing through the ncurses library.
+RECEIVES:
+    ---
+RETURNES:
+    - the pointer to the backend operations. */
+
+const screen_backend *get_ansi_screen_backend();
+/*
+    Gives access to the backend composing frames of raw ANSI escape sequences.
+RECEIVES:
+    ---
+RETURNES:
+    - the pointer to the backend operations. */
+
+#endif
@@ -0,0 +1,119 @@
+/* search.h */
+
+#ifndef SEARCH_H_INCLUDED
+#define SEARCH_H_INCLUDED
+
+#include "arena.h"
+#include "constants.h"
+#include "field.h"
+#include "placement.h"
+
+/* the weights of the field features a placement search maximizes the sum of */
+typedef struct tag_heuristic_weights {
+    double aggregate_height, completed_lines, holes, bumpiness;
+} heuristic_weights;
+
+/* the field features the placement quality is judged by */
+typedef struct tag_field_profile {
+    /* the height of every column, and the number of its empty cells under its
+    top cell */
+    int heights[max_field_width], column_holes[max_field_width];
+    int aggregate_height, max_height, holes, bumpiness;
+} field_profile;
+
+/* one evaluated placement of the search */
+typedef struct tag_search_node {
+    placement move;
+    /* the field after the placement: the search's working copy, which the
+    placement is applied to and reverted on by the journal */
+    field_row *field;
+    placement_undo undo;
+    int completed_lines;
+    double value;
+} search_node;
+
+const heuristic_weights *default_heuristic_weights();
+/*
+    Gives access to the hand-tuned weights playing reasonably well.
+RECEIVES:
+    ---
+RETURNES:
+    - the pointer to the weights. */
+
+void save_heuristic_weights(
+    const char *file_name, const heuristic_weights *weights
+);
+/*
+    Writes the weights to a text file, a `name value` line per weight.
+RECEIVES:
+    - `file_name` the name of the file to write;
+    - `weights` the pointer to the weights.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be written, an error message is printed and the
+    program terminates. */
+
+void load_heuristic_weights(const char *file_name, heuristic_weights *weights);
+/*
+    Reads the weights `save_heuristic_weights` wrote.
+RECEIVES:
+    - `file_name` the name of the file to read;
+    - `weights` the pointer to store the weights to.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be read or a weight is missing or unknown, an error
+    message is printed and the program terminates. */
+
+void measure_field(
+    const field_kernels *kernels, const field_row *field,
+    field_profile *profile
+);
+/*
+    Measures the field features.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state;
+    - `profile` the pointer to store the features to.
+RETURNES:
+    --- */
+
+double evaluate_field(
+    const field_kernels *kernels, const field_row *field,
+    int completed_lines, const heuristic_weights *weights
+);
+/*
+    Scores the field state the search reached.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the field state;
+    - `completed_lines` the number of lines cleared on the way to the state;
+    - `weights` the pointer to the feature weights.
+RETURNES:
+    - the weighted sum of the field features, the higher the better. */
+
+bool search_best_placement(
+    const field_kernels *kernels, const field_row *field,
+    const piece_kind *pieces, int num_of_known_pieces,
+    const heuristic_weights *weights, arena *a, placement *best
+);
+/*
+    Tries every placement of every known piece in turn and picks the placement
+of the 1st piece leading to the best final field. The placements are applied
+to a single working copy of the field and reverted by their undo journals, so
+no search node copies the field. The working copy, every search node and
+placement list live in the arena, which is left as it was found, so the search
+itself never calls malloc or free.
+RECEIVES:
+    - `kernels` the engine kernels for the field size;
+    - `field` the array of rows describing the current field state;
+    - `pieces` the falling piece followed by the previewed ones;
+    - `num_of_known_pieces` the search depth (at least 1);
+    - `weights` the pointer to the feature weights;
+    - `a` the search arena;
+    - `best` the pointer to store the best placement to.
+RETURNES:
+    - the boolean value indicating whether the piece can be placed at all. */
+
+#endif
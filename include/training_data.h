@@ -0,0 +1,157 @@
+/* training_data.h */
+
+#ifndef TRAINING_DATA_H_INCLUDED
+#define TRAINING_DATA_H_INCLUDED
+
+#include "field.h"
+#include "game.h"
+#include "placement.h"
+#include <pthread.h>
+
+enum training_data_consts {
+    /* the records a chunk holds; a multiple of 64, so every column of a chunk
+    starts 64 byte aligned */
+    training_data_chunk_records = 4096,
+    /* the file header and every chunk header are this long */
+    training_data_header_size = 64
+};
+
+/* the header a training data file starts with; the file is a sequence of
+`chunk_size` byte long chunks after it, so a reader can map the file and find
+chunk `i` at `training_data_header_size + i * chunk_size` */
+typedef struct tag_training_data_header {
+    char magic[4];
+    unsigned int version;
+    /* the field size of every recorded game in cells */
+    unsigned int field_height, field_width;
+    unsigned int chunk_records, chunk_size;
+    unsigned char reserved[training_data_header_size - 6 * 4];
+} training_data_header;
+
+/* the header every chunk starts with; the columns follow it, each holding
+`chunk_records` values (only the 1st `num_of_records` of them are written):
+    - `field`: `field_height` field rows (`field_row`) per record, top down,
+      the field the piece was placed on;
+    - `game_id`: uint32, the game the decision was made in, the decisions of
+      one game are recorded in order;
+    - `score_delta`: int32, the `score_bonus` the placement earned;
+    - `piece`, `next_piece`: uint8, the falling and the next `piece_kind`;
+    - `orientation`, `x_shift`, `y_decline`: uint8, int8, int8, the chosen
+      placement;
+    - `lines`: uint8, the lines the placement completed;
+    - `game_over`: uint8, 1 if the next piece couldn't spawn. */
+typedef struct tag_training_data_chunk_header {
+    char magic[4];
+    unsigned int num_of_records;
+    /* the index of the chunk's 1st record among the records of the whole
+    file (the unwritten ones of the partly filled chunks aren't counted) */
+    unsigned long long first_record;
+    unsigned char reserved[training_data_header_size - 4 - 4 - 8];
+} training_data_chunk_header;
+
+/* an open training data file; the chunks of any number of buffers are
+appended to it, one whole chunk at a time */
+typedef struct tag_training_data_file {
+    int fd;
+    int field_height, field_width;
+    unsigned int chunk_size;
+    /* the records appended so far, the earlier runs' ones included */
+    unsigned long long num_of_records;
+    pthread_mutex_t lock;
+} training_data_file;
+
+/* one chunk being filled in memory, column by column; every thread recording
+decisions has its own */
+typedef struct tag_training_data_buffer {
+    training_data_file *file;
+    unsigned char *chunk;
+    /* the columns inside `chunk` */
+    field_row *field;
+    unsigned int *game_id;
+    int *score_delta;
+    unsigned char *piece, *next_piece, *orientation;
+    signed char *x_shift, *y_decline;
+    unsigned char *lines, *game_over;
+    int num_of_records;
+} training_data_buffer;
+
+void open_training_data(
+    training_data_file *f, const char *file_name, field_size size
+);
+/*
+    Opens the training data file for appending, writing its header if the
+file is new or empty.
+RECEIVES:
+    - `f` the pointer to the file to initialize;
+    - `file_name` the file name;
+    - `size` the field size of the games to be recorded.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the file can't be opened, it isn't a training data file of the same
+    field size and chunk layout, or it ends with a partial or damaged chunk,
+    an error message is printed and the program terminates. */
+
+void close_training_data(training_data_file *f);
+/*
+    Closes the file; the buffers writing to it must be flushed before.
+RECEIVES:
+    - `f` the pointer to the file.
+RETURNES:
+    --- */
+
+void init_training_data_buffer(
+    training_data_buffer *b, training_data_file *f
+);
+/*
+    Allocates an empty chunk writing to the file.
+RECEIVES:
+    - `b` the pointer to the buffer to initialize;
+    - `f` the pointer to the open file.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the memory can't be allocated, an error message is printed and the
+    program terminates. */
+
+void record_decision(
+    training_data_buffer *b, unsigned int game_id, const game *before,
+    const placement *move, const game *after
+);
+/*
+    Adds one decision to the chunk: the state before it, the chosen placement
+and the outcome. Appends the chunk to the file when it gets full, so the file
+is written once per `training_data_chunk_records` decisions.
+RECEIVES:
+    - `b` the pointer to the buffer;
+    - `game_id` the number telling the game from the other recorded ones;
+    - `before` the pointer to the game before the placement;
+    - `move` the pointer to the placement of the falling piece;
+    - `after` the pointer to the game after the placement.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the chunk can't be written, an error message is printed and the
+    program terminates. */
+
+void flush_training_data(training_data_buffer *b);
+/*
+    Appends the partly filled chunk to the file (the unwritten records of the
+chunk are zeros) and empties the buffer.
+RECEIVES:
+    - `b` the pointer to the buffer.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the chunk can't be written, an error message is printed and the
+    program terminates. */
+
+void free_training_data_buffer(training_data_buffer *b);
+/*
+    Flushes the buffer and frees its chunk.
+RECEIVES:
+    - `b` the pointer to the buffer.
+RETURNES:
+    --- */
+
+#endif
@@ -0,0 +1,84 @@
+/* versus.h */
+
+#ifndef VERSUS_H_INCLUDED
+#define VERSUS_H_INCLUDED
+
+#include "game.h"
+
+enum versus_consts {
+    num_of_versus_players = 2,
+    /* the game time one frame takes in milliseconds; both sides simulate the
+    match frame by frame, so they stay in step whatever their clocks do */
+    versus_frame_time = 16,
+    /* the most garbage rows waiting for one player, the rest are dropped */
+    max_pending_garbage = 40
+};
+
+/* the outcome of a match */
+typedef enum tag_versus_result {
+    match_goes_on = -1,
+    /* the index of the winner, or a draw */
+    first_player_won = 0,
+    second_player_won = 1,
+    match_drawn = 2
+} versus_result;
+
+/* two games sharing a piece sequence, sending each other garbage rows; the
+whole state is a plain value, so a snapshot is one copy */
+typedef struct tag_versus_match {
+    game games[num_of_versus_players];
+    /* the garbage rows sent to each player, rising after its next lock
+    which completes no lines */
+    unsigned char pending_garbage[num_of_versus_players];
+    /* the `game_change` flags of the steps since the flags were cleared */
+    unsigned char changes[num_of_versus_players];
+    /* the random generator the garbage holes are placed by */
+    unsigned int garbage_rng;
+    /* the number of the frames simulated */
+    unsigned int frame;
+} versus_match;
+
+void init_versus_match(versus_match *m, field_size size, unsigned int seed);
+/*
+    Starts a match: both games get the same seed, so they get the same pieces.
+RECEIVES:
+    - `m` the pointer to the match to initialize;
+    - `size` the field size of both games;
+    - `seed` the seed of the pieces and the garbage holes.
+RETURNES:
+    --- */
+
+void versus_frame(
+    versus_match *m, const game_action inputs[num_of_versus_players]
+);
+/*
+    Simulates one frame: each player's action (if any), the gravity due by the
+end of the frame and the garbage the locks send and receive. The same inputs
+always give the same match.
+RECEIVES:
+    - `m` the pointer to the match;
+    - `inputs` the players' actions taken at the frame (`no_action` if a player
+    did nothing).
+RETURNES:
+    ---
+    `m->changes` gets the changes of the frame added. */
+
+versus_result versus_outcome(const versus_match *m);
+/*
+    Tells whether the match is over and who won it.
+RECEIVES:
+    - `m` the pointer to the match.
+RETURNES:
+    - `match_goes_on` while both games go on; the player still playing, or
+    `match_drawn` if both games ended at the same frame. */
+
+int garbage_rows_sent(int num_of_completed_lines);
+/*
+    Gives the number of garbage rows a lock completing lines sends.
+RECEIVES:
+    - `num_of_completed_lines` the number of lines completed at a time.
+RETURNES:
+    - the number of garbage rows: none for a single, 1 for a double, 2 for a
+    triple and 4 for four lines at a time. */
+
+#endif
@@ -0,0 +1,96 @@
+/* versus_link.h */
+
+#ifndef VERSUS_LINK_H_INCLUDED
+#define VERSUS_LINK_H_INCLUDED
+
+#include "rollback.h"
+#include <netinet/in.h>
+
+enum versus_link_consts {
+    /* the most inputs one packet carries: every local input the other side
+    hasn't confirmed, up to the ones the session keeps */
+    versus_link_inputs = rollback_input_frames
+};
+
+/* the UDP datagram both sides send each other every frame; it repeats the
+inputs not confirmed yet, so a lost packet needs no resend request */
+typedef struct tag_versus_packet {
+    char magic[4];
+    /* the sender's random seed, the match is seeded with both seeds */
+    unsigned int seed;
+    /* the number of the receiver's inputs the sender has confirmed */
+    unsigned int inputs_confirmed;
+    /* the frame of the 1st input carried */
+    unsigned int first_frame;
+    unsigned int num_of_inputs;
+    unsigned char inputs[versus_link_inputs];
+} versus_packet;
+
+/* one side of a match played over the loopback interface */
+typedef struct tag_versus_link {
+    int socket;
+    struct sockaddr_in peer;
+    /* the index of the local player: the side on the lower port plays
+    first */
+    int local_player;
+    unsigned int local_seed, peer_seed;
+    bool peer_seen;
+    /* the number of the local inputs the other side has confirmed */
+    unsigned int inputs_confirmed;
+    /* the time the last packet came at, in milliseconds */
+    long last_heard;
+} versus_link;
+
+void open_versus_link(versus_link *link, int local_port, int peer_port);
+/*
+    Binds a UDP socket to the local port of the loopback interface and picks
+the local random seed.
+RECEIVES:
+    - `link` the pointer to the link to initialize;
+    - `local_port`, `peer_port` the local port and the other side's one.
+RETURNES:
+    ---
+ERROR HANDLING:
+    - if the ports are the same or the socket can't be bound, an error
+    message is printed and the program terminates. */
+
+void close_versus_link(versus_link *link);
+/*
+    Closes the socket of the link.
+RECEIVES:
+    - `link` the pointer to the link.
+RETURNES:
+    --- */
+
+void send_versus_packet(versus_link *link, const rollback_session *s);
+/*
+    Sends the other side the local seed and the local inputs it hasn't
+confirmed yet (a packet is never waited for, a lost one is made up for by the
+next one).
+RECEIVES:
+    - `link` the pointer to the link;
+    - `s` the pointer to the session, NULL before the match starts.
+RETURNES:
+    --- */
+
+bool receive_versus_packets(versus_link *link, rollback_session *s, long time);
+/*
+    Takes every packet which has come from the other side, without waiting:
+the 1st one tells its seed, the inputs they carry are confirmed in the
+session.
+RECEIVES:
+    - `link` the pointer to the link;
+    - `s` the pointer to the session, NULL before the match starts;
+    - `time` the current time in milliseconds.
+RETURNES:
+    - the boolean value indicating whether any packet has come. */
+
+unsigned int versus_link_seed(const versus_link *link);
+/*
+    Gives the seed of the match, the same on both sides.
+RECEIVES:
+    - `link` the pointer to the link, the other side's seed known.
+RETURNES:
+    - the seed. */
+
+#endif
@@ -0,0 +1,175 @@
+/* ansi_screen.c */
+
+#include "constants.h"
+#include "screen.h"
+#include "screen_backend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+enum ansi_screen_consts {
+    /* the terminal size used if it can't be requested */
+    default_rows          = 24,
+    default_cols          = 80,
+    /* the longest cursor movement sequence: ESC [ rrrrr ; ccccc H */
+    max_cursor_move_len   = 16,
+    /* the unchanged characters between two changed runs of a row are written
+    again instead of being skipped if there are fewer of them than this (a
+    cursor movement costs about as much) */
+    min_skipped_run       = 8
+};
+
+#define ENTER_SCREEN_SEQ "\033[?1049h\033[?25l\033[2J"
+
+#define LEAVE_SCREEN_SEQ "\033[?25h\033[?1049l"
+
+#define CURSOR_MOVE_SEQ  "\033[%d;%dH"
+
+static struct termios saved_termios;
+
+static int rows, cols;
+
+/* the characters currently on the terminal and the frame being composed */
+static char *shown, *composed;
+
+/* the frame's escape sequences, allocated once for the worst case */
+static char *frame;
+
+static size_t frame_size;
+
+static void write_all(const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t written = write(STDOUT_FILENO, buf, len);
+        if (written < 0)
+            return;
+        buf += written;
+        len -= written;
+    }
+}
+
+static void *allocate(size_t size)
+{
+    void *ptr = malloc(size);
+    if (!ptr) {
+        fprintf(stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    return ptr;
+}
+
+static void ansi_init()
+{
+    struct termios raw;
+    struct winsize ws;
+    if (tcgetattr(STDIN_FILENO, &saved_termios) < 0) {
+        fprintf(stderr, "%s:%d: stdin is not a terminal\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    raw = saved_termios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) && ws.ws_row && ws.ws_col) {
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    } else {
+        rows = default_rows;
+        cols = default_cols;
+    }
+    shown = allocate(rows * cols);
+    composed = allocate(rows * cols);
+    memset(shown, ' ', rows * cols);
+    memset(composed, ' ', rows * cols);
+    frame_size =
+        rows * (cols + (cols / min_skipped_run + 1) * max_cursor_move_len);
+    frame = allocate(frame_size);
+    write_all(ENTER_SCREEN_SEQ, strlen(ENTER_SCREEN_SEQ));
+}
+
+static void ansi_end()
+{
+    write_all(LEAVE_SCREEN_SEQ, strlen(LEAVE_SCREEN_SEQ));
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+    free(shown);
+    free(composed);
+    free(frame);
+}
+
+static void ansi_size(int *row, int *col)
+{
+    *row = rows;
+    *col = cols;
+}
+
+static void ansi_put_str(int y, int x, const char *str)
+{
+    if ((y < 0) || (y > rows - 1))
+        return;
+    for (; *str; str++, x++) {
+        if ((x >= 0) && (x < cols))
+            composed[y * cols + x] = *str;
+    }
+}
+
+static void ansi_clear()
+{
+    memset(composed, ' ', rows * cols);
+}
+
+static int changed_run_end(const char *row_shown, const char *row_composed, int x)
+{
+    /* `x` is the 1st changed character; the run goes on while the unchanged
+    gaps inside it are too short to be worth a cursor movement */
+    int end = x + 1, gap = 0;
+    for (x=end; (x < cols) && (gap < min_skipped_run); x++) {
+        if (row_shown[x] != row_composed[x]) {
+            end = x + 1;
+            gap = 0;
+        } else
+            gap++;
+    }
+    return end;
+}
+
+static void ansi_flush()
+{
+    size_t len = 0;
+    int x, y;
+    for (y=0; y < rows; y++) {
+        char *row_shown = shown + y * cols;
+        const char *row_composed = composed + y * cols;
+        for (x=0; x < cols; x++) {
+            int end;
+            if (row_shown[x] == row_composed[x])
+                continue;
+            end = changed_run_end(row_shown, row_composed, x);
+            len += sprintf(frame + len, CURSOR_MOVE_SEQ, y + 1, x + 1);
+            memcpy(frame + len, row_composed + x, end - x);
+            memcpy(row_shown + x, row_composed + x, end - x);
+            len += end - x;
+            x = end - 1;
+        }
+    }
+    if (len)
+        write_all(frame, len);
+}
+
+static int ansi_get_key(int delay)
+{
+    ansi_flush();
+    return read_terminal_key(delay);
+}
+
+const screen_backend *get_ansi_screen_backend()
+{
+    static const screen_backend ansi_backend = {
+        ansi_init, ansi_end, ansi_size, ansi_put_str,
+        ansi_clear, ansi_flush, ansi_get_key, read_terminal_key
+    };
+    return &ansi_backend;
+}
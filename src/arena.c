@@ -0,0 +1,92 @@
+/* arena.c */
+
+#include "arena.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum arena_alignment {
+    /* every block starts at an address divisible by this */
+    arena_alignment = 16
+};
+
+static _Thread_local arena thread_arena;
+
+static _Thread_local bool thread_arena_initialized = false;
+
+void init_arena(arena *a, size_t capacity)
+{
+    a->memory = malloc(capacity);
+    if (!a->memory) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+    a->capacity = capacity;
+    a->used = 0;
+    a->num_of_allocations = 0;
+    a->num_of_resets = 0;
+    a->bytes_allocated = 0;
+    a->peak_used = 0;
+}
+
+void free_arena(arena *a)
+{
+    free(a->memory);
+    a->memory = NULL;
+    a->capacity = 0;
+    a->used = 0;
+}
+
+void *arena_alloc(arena *a, size_t size)
+{
+    size_t start =
+        (a->used + arena_alignment - 1) & ~(size_t)(arena_alignment - 1);
+    if (start + size > a->capacity) {
+        fprintf(
+            stderr, "%s:%d: the arena of %zu bytes is exhausted\n",
+            __FILE__, __LINE__, a->capacity
+        );
+        exit(1);
+    }
+    a->used = start + size;
+    if (a->used > a->peak_used)
+        a->peak_used = a->used;
+    a->num_of_allocations++;
+    a->bytes_allocated += size;
+    return a->memory + start;
+}
+
+size_t arena_mark(const arena *a)
+{
+    return a->used;
+}
+
+void arena_release(arena *a, size_t mark)
+{
+    a->used = mark;
+}
+
+void reset_arena(arena *a)
+{
+    a->used = 0;
+    a->num_of_resets++;
+}
+
+arena *get_thread_arena()
+{
+    if (!thread_arena_initialized) {
+        init_arena(&thread_arena, default_arena_capacity);
+        thread_arena_initialized = true;
+    }
+    return &thread_arena;
+}
+
+void free_thread_arena()
+{
+    if (thread_arena_initialized) {
+        free_arena(&thread_arena);
+        thread_arena_initialized = false;
+    }
+}
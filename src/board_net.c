@@ -0,0 +1,265 @@
+/* board_net.c */
+
+#include "board_net.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+enum board_net_layout {
+    /* the feature positions in an input row */
+    heights_input = 0,
+    holes_input = max_field_width,
+    completed_lines_input = 2 * max_field_width,
+    bumpiness_input,
+    max_height_input,
+    /* the boards a hidden layer weight is applied to at once */
+    boards_per_step = 4
+};
+
+static const char board_net_magic[4] = { 'T', 'B', 'N', '1' };
+
+static size_t board_net_file_size(int num_of_hidden)
+{
+    /* the hidden layer matrix and biases, the output weights and bias */
+    return sizeof(board_net_header) + sizeof(float) *
+        (num_of_hidden * board_net_inputs + 2 * num_of_hidden + 1);
+}
+
+static void board_net_error(const char *file_name, const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", file_name, msg);
+    exit(1);
+}
+
+void load_board_net(board_net *net, const char *file_name)
+{
+    const board_net_header *header;
+    const float *weights;
+    struct stat st;
+    int fd = open(file_name, O_RDONLY);
+    if ((fd == -1) || (fstat(fd, &st) == -1)) {
+        perror(file_name);
+        exit(1);
+    }
+    if ((size_t)st.st_size < sizeof(board_net_header))
+        board_net_error(file_name, "not a board net file");
+    net->mapping_size = st.st_size;
+    net->mapping = mmap(NULL, net->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (net->mapping == MAP_FAILED) {
+        perror(file_name);
+        exit(1);
+    }
+    header = net->mapping;
+    if (memcmp(header->magic, board_net_magic, sizeof(board_net_magic)) != 0)
+        board_net_error(file_name, "not a board net file");
+    if (header->num_of_inputs != board_net_inputs)
+        board_net_error(file_name, "the net takes another number of inputs");
+    if ((header->num_of_hidden == 0) ||
+        (net->mapping_size != board_net_file_size(header->num_of_hidden)))
+    {
+        board_net_error(file_name, "the file size doesn't match the net");
+    }
+    /* the mapping is page aligned and the header is 16 bytes long, so every
+    hidden layer row starts 16 byte aligned */
+    weights = (const float *)(header + 1);
+    net->num_of_hidden = header->num_of_hidden;
+    net->hidden_weights = weights;
+    net->hidden_biases = weights + net->num_of_hidden * board_net_inputs;
+    net->output_weights = net->hidden_biases + net->num_of_hidden;
+    net->output_bias = net->output_weights[net->num_of_hidden];
+}
+
+void unload_board_net(board_net *net)
+{
+    munmap(net->mapping, net->mapping_size);
+    net->mapping = NULL;
+}
+
+void save_heuristic_board_net(
+    const char *file_name, const heuristic_weights *weights, int num_of_hidden
+)
+{
+    board_net_header header = { { 0 }, board_net_inputs, num_of_hidden, 0 };
+    size_t num_of_floats =
+        (board_net_file_size(num_of_hidden) - sizeof(header)) / sizeof(float);
+    float *w = calloc(num_of_floats, sizeof(float));
+    float *output_weights;
+    FILE *f;
+    int x;
+    if (!w || (num_of_hidden < 2)) {
+        fprintf(stderr, "%s:%d: can't build the net\n", __FILE__, __LINE__);
+        exit(1);
+    }
+    /* the hidden layer biases stay zero */
+    output_weights = w + num_of_hidden * board_net_inputs + num_of_hidden;
+    memcpy(header.magic, board_net_magic, sizeof(board_net_magic));
+    /* the 1st hidden unit passes the positive part of the heuristic value,
+    the 2nd one - the negative part, so the output is the value itself; the
+    features are scaled back the way `board_features` normalized them */
+    for (x=0; x < field_width; x++) {
+        w[heights_input + x] = weights->aggregate_height * field_height;
+        w[holes_input + x] = weights->holes * field_height;
+    }
+    w[completed_lines_input] =
+        weights->completed_lines * max_num_of_completed_lines;
+    w[bumpiness_input] = weights->bumpiness * field_height * field_width;
+    for (x=0; x < board_net_inputs; x++)
+        w[board_net_inputs + x] = -w[x];
+    output_weights[0] = 1;
+    output_weights[1] = -1;
+    f = fopen(file_name, "wb");
+    if (!f ||
+        (fwrite(&header, sizeof(header), 1, f) != 1) ||
+        (fwrite(w, sizeof(float), num_of_floats, f) != num_of_floats) ||
+        (fclose(f) != 0))
+    {
+        perror(file_name);
+        exit(1);
+    }
+    free(w);
+}
+
+void board_features(
+    const field_kernels *kernels, const field_row *field,
+    int completed_lines, float *features
+)
+{
+    field_profile profile;
+    float height = kernels->height;
+    int x;
+    measure_field(kernels, field, &profile);
+    for (x=0; x < max_field_width; x++) {
+        features[heights_input + x] = profile.heights[x] / height;
+        features[holes_input + x] = profile.column_holes[x] / height;
+    }
+    features[completed_lines_input] =
+        (float)completed_lines / max_num_of_completed_lines;
+    features[bumpiness_input] = profile.bumpiness / (height * kernels->width);
+    features[max_height_input] = profile.max_height / height;
+    features[max_height_input + 1] = 0;
+}
+
+#ifdef __SSE__
+static float horizontal_sum(__m128 v)
+{
+    __m128 shuffled = _mm_movehl_ps(v, v);
+    v = _mm_add_ps(v, shuffled);
+    shuffled = _mm_shuffle_ps(v, v, 1);
+    return _mm_cvtss_f32(_mm_add_ss(v, shuffled));
+}
+
+/* the dot products of one weight row with 4 input rows */
+static void dot4(const float *w, const float *inputs, float *dots)
+{
+    __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+    int i;
+    for (i=0; i < board_net_inputs; i += 4) {
+        __m128 wv = _mm_load_ps(w + i);
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(wv, _mm_load_ps(inputs + i)));
+        sum1 = _mm_add_ps(
+            sum1, _mm_mul_ps(wv, _mm_load_ps(inputs + board_net_inputs + i))
+        );
+        sum2 = _mm_add_ps(
+            sum2, _mm_mul_ps(wv, _mm_load_ps(inputs + 2*board_net_inputs + i))
+        );
+        sum3 = _mm_add_ps(
+            sum3, _mm_mul_ps(wv, _mm_load_ps(inputs + 3*board_net_inputs + i))
+        );
+    }
+    dots[0] = horizontal_sum(sum0);
+    dots[1] = horizontal_sum(sum1);
+    dots[2] = horizontal_sum(sum2);
+    dots[3] = horizontal_sum(sum3);
+}
+#else
+static void dot4(const float *w, const float *inputs, float *dots)
+{
+    int b, i;
+    for (b=0; b < boards_per_step; b++) {
+        dots[b] = 0;
+        for (i=0; i < board_net_inputs; i++)
+            dots[b] += w[i] * inputs[b * board_net_inputs + i];
+    }
+}
+#endif
+
+static float dot(const float *w, const float *inputs)
+{
+    float sum = 0;
+    int i;
+    for (i=0; i < board_net_inputs; i++)
+        sum += w[i] * inputs[i];
+    return sum;
+}
+
+void evaluate_boards(
+    const board_net *net, const float *features, int num_of_boards,
+    float *values
+)
+{
+    int h, b, num_of_hidden = net->num_of_hidden;
+    for (b=0; b < num_of_boards; b++)
+        values[b] = net->output_bias;
+    /* a hidden unit's weights stay in the cache for the whole batch */
+    for (h=0; h < num_of_hidden; h++) {
+        const float *w = net->hidden_weights + h * board_net_inputs;
+        float dots[boards_per_step];
+        for (b=0; b + boards_per_step <= num_of_boards; b += boards_per_step) {
+            int i;
+            dot4(w, features + b * board_net_inputs, dots);
+            for (i=0; i < boards_per_step; i++) {
+                float hidden = fmaxf(dots[i] + net->hidden_biases[h], 0);
+                values[b + i] += net->output_weights[h] * hidden;
+            }
+        }
+        /* the rest of the batch, one board at a time */
+        for (; b < num_of_boards; b++) {
+            float hidden = fmaxf(
+                dot(w, features + b * board_net_inputs) + net->hidden_biases[h],
+                0
+            );
+            values[b] += net->output_weights[h] * hidden;
+        }
+    }
+}
+
+bool net_best_placement(
+    const board_net *net, const field_kernels *kernels, const field_row *field,
+    piece_kind kind, arena *a, placement *best
+)
+{
+    size_t mark = arena_mark(a);
+    int num_of_placements, i, best_i = 0;
+    placement *placements =
+        enumerate_placements(kernels, field, kind, a, &num_of_placements);
+    float *features =
+        arena_alloc(a, num_of_placements * board_net_inputs * sizeof(float));
+    float *values = arena_alloc(a, num_of_placements * sizeof(float));
+    field_row *work = snapshot_field(kernels, field, a);
+    for (i=0; i < num_of_placements; i++) {
+        placement_undo undo;
+        int lines =
+            apply_placement_journaled(kernels, work, &placements[i], &undo);
+        board_features(kernels, work, lines, features + i * board_net_inputs);
+        undo_placement(kernels, work, &undo);
+    }
+    evaluate_boards(net, features, num_of_placements, values);
+    for (i=1; i < num_of_placements; i++) {
+        if (values[i] > values[best_i])
+            best_i = i;
+    }
+    if (num_of_placements)
+        *best = placements[best_i];
+    arena_release(a, mark);
+    return num_of_placements > 0;
+}
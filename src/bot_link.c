@@ -0,0 +1,240 @@
+/* bot_link.c */
+
+#include "bot_link.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char bot_link_magic[4] = { 'T', 'B', 'L', '1' };
+
+/* sleeps while the futex word is `value`, at most `delay` milliseconds (-1 -
+with no limit); the segment is shared between processes, so the futex isn't
+a private one */
+static void futex_wait(atomic_uint *word, unsigned int value, int delay)
+{
+    struct timespec timeout, *t = NULL;
+    if (delay >= 0) {
+        timeout.tv_sec = delay / 1000;
+        timeout.tv_nsec = (delay % 1000) * 1000000L;
+        t = &timeout;
+    }
+    syscall(SYS_futex, (unsigned int *)word, FUTEX_WAIT, value, t, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *word)
+{
+    syscall(
+        SYS_futex, (unsigned int *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0
+    );
+}
+
+/* waits until the word isn't `value` any more: spins first, then sleeps on
+the futex with `sleeping` set, so the other side knows it has to wake it up */
+static bool wait_for_change(
+    atomic_uint *word, unsigned int value, atomic_uint *sleeping, int delay
+)
+{
+    int i;
+    for (i=0; i < bot_link_spins; i++) {
+        if (atomic_load_explicit(word, memory_order_acquire) != value)
+            return true;
+        if (delay == 0)
+            return false;
+    }
+    /* the other side changes the word, then checks the flag: either it sees
+    the flag or this side sees the new value before it sleeps */
+    atomic_store(sleeping, 1);
+    if (atomic_load(word) == value)
+        futex_wait(word, value, delay);
+    atomic_store(sleeping, 0);
+    return atomic_load_explicit(word, memory_order_acquire) != value;
+}
+
+/* stores the word's new value and wakes the other side if it sleeps */
+static void change_and_wake(
+    atomic_uint *word, unsigned int value, atomic_uint *sleeping
+)
+{
+    atomic_store(word, value);
+    if (atomic_load(sleeping))
+        futex_wake(word);
+}
+
+static bot_link_segment *map_segment(int fd, const char *name)
+{
+    bot_link_segment *segment = mmap(
+        NULL, sizeof(bot_link_segment), PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd, 0
+    );
+    close(fd);
+    if (segment == MAP_FAILED) {
+        perror(name);
+        exit(1);
+    }
+    return segment;
+}
+
+void create_bot_link(bot_link *link, const char *name)
+{
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if ((fd == -1) || (ftruncate(fd, sizeof(bot_link_segment)) == -1)) {
+        perror(name);
+        exit(1);
+    }
+    link->segment = map_segment(fd, name);
+    link->name = name;
+    link->owner = true;
+    link->num_of_pieces = 0;
+    link->state_seq = 0;
+    memset(link->segment, 0, sizeof(bot_link_segment));
+    link->segment->segment_size = sizeof(bot_link_segment);
+    memcpy(link->segment->magic, bot_link_magic, sizeof(bot_link_magic));
+}
+
+void attach_bot_link(bot_link *link, const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1) {
+        perror(name);
+        exit(1);
+    }
+    link->segment = map_segment(fd, name);
+    link->name = name;
+    link->owner = false;
+    link->num_of_pieces = 0;
+    link->state_seq = 0;
+    if ((memcmp(link->segment->magic, bot_link_magic, 4) != 0) ||
+        (link->segment->segment_size != sizeof(bot_link_segment)))
+    {
+        fprintf(stderr, "%s: not a bot link of this game build\n", name);
+        exit(1);
+    }
+}
+
+void close_bot_link(bot_link *link)
+{
+    munmap(link->segment, sizeof(bot_link_segment));
+    if (link->owner)
+        shm_unlink(link->name);
+}
+
+void publish_bot_link_state(bot_link *link, const game *g)
+{
+    bot_link_segment *s = link->segment;
+    unsigned int seq =
+        atomic_load_explicit(&s->state_seq, memory_order_relaxed);
+    int i;
+    if (g->changes & next_piece_changed)
+        link->num_of_pieces++;
+    /* a seqlock: the bot retries a copy made while the sequence number was
+    odd or changed */
+    atomic_store_explicit(&s->state_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(s->state.field, g->field, sizeof(g->field));
+    s->state.size = g->size;
+    s->state.game_on = g->game_on;
+    s->state.piece = game_piece(g);
+    for (i=0; i < g->num_of_previews; i++)
+        s->state.preview[i] = game_preview_kind(g, i);
+    s->state.num_of_previews = g->num_of_previews;
+    s->state.level = g->level;
+    s->state.score = g->score;
+    s->state.lines = g->lines;
+    s->state.num_of_pieces = link->num_of_pieces;
+    s->state.actions_done =
+        atomic_load_explicit(&s->actions_done, memory_order_relaxed);
+    change_and_wake(&s->state_seq, seq + 2, &s->bot_sleeping);
+}
+
+game_action wait_bot_link_action(bot_link *link, int delay)
+{
+    bot_link_segment *s = link->segment;
+    unsigned int done =
+        atomic_load_explicit(&s->actions_done, memory_order_relaxed);
+    unsigned char action;
+    if (!wait_for_change(&s->actions_sent, done, &s->game_sleeping, delay))
+        return no_action;
+    action = s->actions[done % bot_link_actions];
+    atomic_store_explicit(&s->actions_done, done + 1, memory_order_release);
+    /* the other process is trusted with nothing but the actions */
+    return (action <= shift_right) ? action : no_action;
+}
+
+bool wait_bot_link_state(bot_link *link, bot_link_state *state, int delay)
+{
+    bot_link_segment *s = link->segment;
+    for (;;) {
+        unsigned int seq =
+            atomic_load_explicit(&s->state_seq, memory_order_acquire);
+        if (seq == link->state_seq) {
+            if (!wait_for_change(
+                    &s->state_seq, seq, &s->bot_sleeping, delay
+                ))
+                return false;
+            continue;
+        }
+        /* the game is writing it */
+        if (seq & 1)
+            continue;
+        memcpy(state, &s->state, sizeof(*state));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->state_seq, memory_order_relaxed) == seq) {
+            link->state_seq = seq;
+            return true;
+        }
+    }
+}
+
+bool send_bot_link_action(bot_link *link, game_action action)
+{
+    bot_link_segment *s = link->segment;
+    unsigned int sent =
+        atomic_load_explicit(&s->actions_sent, memory_order_relaxed);
+    if (sent - bot_link_actions_done(link) >= bot_link_actions)
+        return false;
+    s->actions[sent % bot_link_actions] = action;
+    change_and_wake(&s->actions_sent, sent + 1, &s->game_sleeping);
+    return true;
+}
+
+unsigned int bot_link_actions_done(const bot_link *link)
+{
+    return atomic_load_explicit(
+        &link->segment->actions_done, memory_order_acquire
+    );
+}
+
+void bot_link_game(const bot_link_state *state, game *g)
+{
+    int y;
+    memset(g, 0, sizeof(*g));
+    g->size = state->size;
+    memcpy(g->field, state->field, sizeof(g->field));
+    g->stack_top = game_kernels(g)->height;
+    for (y=0; y < game_kernels(g)->height; y++) {
+        if (!field_row_is_empty(g->field[y])) {
+            g->stack_top = y;
+            break;
+        }
+    }
+    g->piece.kind = state->piece.kind;
+    g->piece.orientation = state->piece.orientation;
+    g->piece.x_shift = state->piece.x_shift;
+    g->piece.y_decline = state->piece.y_decline;
+    g->piece.ghost_decline = state->piece.ghost_decline;
+    memcpy(g->preview, state->preview, sizeof(g->preview));
+    g->preview_head = 0;
+    g->num_of_previews = state->num_of_previews;
+    g->level = state->level;
+    g->score = state->score;
+    g->lines = state->lines;
+    g->rng_state = 1;
+    g->game_on = state->game_on;
+}
@@ -1,92 +1,101 @@
 /* conflict_resolution.c */
 
 #include "conflict_resolution.h"
+#include "piece_tables.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-#define MAKE_FUNCTION_MATRIX_COPY(FUNNAME, SIZE) \
-    void FUNNAME( \
-        bool (*dst)[SIZE ## _piece_size], \
-        const bool (*src)[SIZE ## _piece_size] \
-    ) \
-    { \
-        int x, y; \
-        for (y=0; y < SIZE ## _piece_size; y++) { \
-            for (x=0; x < SIZE ## _piece_size; x++) \
-                dst[y][x] = src[y][x]; \
-        } \
-    }
-
-MAKE_FUNCTION_MATRIX_COPY(small_matrix_copy, small)
-
-MAKE_FUNCTION_MATRIX_COPY(big_matrix_copy, big)
+static const field_kernels *standard_kernels()
+{
+    static const field_kernels *kernels = NULL;
+    if (!kernels)
+        kernels = get_field_kernels(standard_field);
+    return kernels;
+}
 
-void make_backup(void *dst, const struct_piece *piece)
+bool placement_conflict(
+    const field_row *field, piece_kind kind, position orientation,
+    int x_shift, int y_decline
+)
 {
-    bool (*backup_matrix)[piece->size] = dst;
-    switch (piece->size) {
-        case small_piece_size:
-            small_matrix_copy(backup_matrix, piece->form.small);
-            break;
-        case big_piece_size:
-            big_matrix_copy(backup_matrix, piece->form.big);
-            break;
-        default:
-            fprintf(
-                stderr, "%s:%d: incorrect piece size %d\n",
-                __FILE__, __LINE__, piece->size
-            );
-            exit(1);
-    }
+    return standard_kernels()->placement_conflict(
+        field, kind, orientation, x_shift, y_decline
+    );
 }
 
-static void prev_orientation(struct_piece *piece)
+bool piece_field_crossing_conflict(
+    const field_row *field, const struct_piece *piece
+)
 {
-    /* traversing a list of enumerated values cyclically in reverse order
-    (after the 1st value, we get the last value) */
-    piece->orientation = piece->orientation - 1;
-    if (piece->orientation < 0)
-        piece->orientation = piece->orientation + orientation_count;
+    return placement_conflict(
+        field, piece->kind, piece->orientation,
+        piece->x_shift, piece->y_decline
+    );
 }
 
-static void apply_backup(struct_piece *piece, const void *src, int dx, int dy)
+bool field_or_side_boundaries_conflict(
+    const field_row *field, const struct_piece *piece
+)
 {
-    const bool (*backup_matrix)[piece->size] = src;
-    switch (piece->size) {
-        case small_piece_size:
-            small_matrix_copy(piece->form.small, backup_matrix);
-            break;
-        case big_piece_size:
-            big_matrix_copy(piece->form.big, backup_matrix);
-            break;
-        default:
-            fprintf(
-                stderr, "%s:%d: incorrect piece size %d\n",
-                __FILE__, __LINE__, piece->size
-            );
-            exit(1);
-    }
-    piece->x_shift -= dx;
-    piece->y_decline -= dy;
-    if (piece->i_form)
-        prev_orientation(piece);
+    return placement_conflict(
+        field, piece->kind, piece->orientation,
+        piece->x_shift, piece->y_decline
+    );
 }
 
-static bool o_piece(const struct_piece *piece)
+bool side_boundaries_crossing_(
+    crossing_action action, struct_piece *piece, int *dx
+)
 {
-    return ((piece->size == big_piece_size) && (!piece->i_form));
+    int push = standard_kernels()->side_push(
+        piece->kind, piece->orientation, piece->x_shift
+    );
+    if (!push)
+        return false;
+    if (action == signal)
+        return true;
+    piece->x_shift += push;
+    if (dx)
+        *dx += push;
+    return true;
 }
 
-static bool i_piece_rotation_conflict(
-    const bool (*field)[field_width], const struct_piece *piece, int x, int y
+typedef struct tag_kick {
+    signed char dx, dy;
+} kick;
+
+typedef struct tag_rotation_rule {
+    /* whether a rotation changes the piece at all (the O piece doesn't) */
+    bool rotates;
+    /* the piece orientation after the rotation */
+    position to;
+    /* the `x_shift` correction applied before any conflict checks: after the
+    rotation of the I piece both of its vertical incarnations have to be at
+    the same column */
+    signed char pre_shift;
+    /* the shift resolving a piece/field cell crossing, for every combination
+    of the rotated piece cells crossing the occupied field cells
+    (bit `i` - the `i`th cell of the rotated piece has a conflict) */
+    kick kicks[1 << piece_cells];
+} rotation_rule;
+
+static rotation_rule rotation_rules[num_of_pieces][orientation_count];
+
+static bool conflict_in_cell_(
+    const piece_orientation *to, int conflicts, int x, int y
 )
 {
-    return (field[piece->y_decline + y][piece->x_shift + x] == 1);
+    int i;
+    for (i=0; i < piece_cells; i++) {
+        if ((to->cells[i][0] == x) && (to->cells[i][1] == y))
+            return (conflicts >> i) & 1;
+    }
+    return false;
 }
 
-static void handle_i_form_piece_rotation_conflict(
-    const bool (*field)[field_width], const struct_piece *piece,
-    const int (*confl_coords)[2], const int *amendments, int *coordinate
+static void i_form_piece_kick(
+    const piece_orientation *to, int conflicts, const int (*confl_coords)[2],
+    const int *amendments, signed char *coordinate
 )
 {
     int confl_1_x = confl_coords[0][0], confl_1_y = confl_coords[0][1];
@@ -94,11 +103,11 @@ static void handle_i_form_piece_rotation_conflict(
     int confl_3_x = confl_coords[2][0], confl_3_y = confl_coords[2][1];
     int amendment = 0;
         /* short_side_conflict */
-    if (i_piece_rotation_conflict(field, piece, confl_1_x, confl_1_y)) {
+    if (conflict_in_cell_(to, conflicts, confl_1_x, confl_1_y)) {
             /* long_side_border_conflict */
-        if (i_piece_rotation_conflict(field, piece, confl_2_x, confl_2_y) ||
+        if (conflict_in_cell_(to, conflicts, confl_2_x, confl_2_y) ||
             /* long_side_center_conflict */
-            i_piece_rotation_conflict(field, piece, confl_3_x, confl_3_y))
+            conflict_in_cell_(to, conflicts, confl_3_x, confl_3_y))
         {
             return;
         } else
@@ -106,11 +115,11 @@ static void handle_i_form_piece_rotation_conflict(
     }
     else
         /* long_side_border_conflict */
-    if (i_piece_rotation_conflict(field, piece, confl_2_x, confl_2_y))
+    if (conflict_in_cell_(to, conflicts, confl_2_x, confl_2_y))
         amendment = amendments[1];
     else
         /* long_side_center_conflict */
-    if (i_piece_rotation_conflict(field, piece, confl_3_x, confl_3_y))
+    if (conflict_in_cell_(to, conflicts, confl_3_x, confl_3_y))
         amendment = amendments[2];
     *coordinate += amendment;
 }
@@ -140,118 +149,72 @@ static void handle_i_form_piece_rotation_conflict(
         . . . .    . 1 . .
 
 */
-static void i_form_piece_rotation_conflicts_handling(
-    const bool (*field)[field_width], struct_piece *piece, int *dx, int *dy
+static kick i_form_piece_rotation_kick(
+    const piece_orientation *to, position orientation, int conflicts
 )
 {
-    int tmpdx = 0, tmpdy = 0;
-    switch (piece->orientation) {
+    kick res = { 0, 0 };
+    switch (orientation) {
         case (horizontal_1): {
             int conflict_coordinates[][2] = { { 0, 2 }, { 3, 2 }, { 2, 2 } };
             int amendments[] = { 1, -2, -1 };
-            handle_i_form_piece_rotation_conflict(
-                field, piece, conflict_coordinates, amendments, &tmpdx
+            i_form_piece_kick(
+                to, conflicts, conflict_coordinates, amendments, &res.dx
             );
             break;
         }
         case (vertical_1): {
             int conflict_coordinates[][2] = { { 1, 3 }, { 1, 0 }, { 1, 1 } };
             int amendments[] = { -1, 2, 1 };
-            handle_i_form_piece_rotation_conflict(
-                field, piece, conflict_coordinates, amendments, &tmpdy
+            i_form_piece_kick(
+                to, conflicts, conflict_coordinates, amendments, &res.dy
             );
             break;
         }
         case (horizontal_2): {
             int conflict_coordinates[][2] = { { 3, 1 }, { 0, 1 }, { 1, 1 } };
             int amendments[] = { -1, 2, 1 };
-            handle_i_form_piece_rotation_conflict(
-                field, piece, conflict_coordinates, amendments, &tmpdx
+            i_form_piece_kick(
+                to, conflicts, conflict_coordinates, amendments, &res.dx
             );
             break;
         }
         case (vertical_2): {
             int conflict_coordinates[][2] = { { 2, 0 }, { 2, 3 }, { 2, 2 } };
             int amendments[] = { 1, -2, -1 };
-            handle_i_form_piece_rotation_conflict(
-                field, piece, conflict_coordinates, amendments, &tmpdy
+            i_form_piece_kick(
+                to, conflicts, conflict_coordinates, amendments, &res.dy
             );
             break;
         }
-        case (orientation_count):
-            ;
-            break;
         default:
             fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
             exit(1);
     }
-    piece->x_shift += tmpdx;
-    *dx += tmpdx;
-    piece->y_decline += tmpdy;
-    *dy += tmpdy;
-}
-
-static bool cell_occupied_by_(
-    const bool (*field)[field_width], int x, int y, const struct_piece *piece
-)
-{
-    return (field[y+piece->y_decline][x+piece->x_shift] == 1);
-}
-
-static bool piece_field_conflict(
-    const bool (*field)[field_width], int x, int y, const struct_piece *piece
-)
-{
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    const bool (*matrix)[piece->size] = piece->form.small;
-    return ((matrix[y][x] == 1) && (cell_occupied_by_(field, x, y, piece)));
-}
-
-bool piece_field_crossing_conflict(
-    const bool (*field)[field_width], const struct_piece *piece
-)
-{
-    int x, y;
-    for (y=0; y < piece->size; y++) {
-        for (x=0; x < piece->size; x++) {
-            if (piece_field_conflict(field, x, y, piece))
-                return true;
-        }
-    }
-    return false;
-}
-
-static bool regular_piece_rotation_conflict(
-    const bool (*field)[field_width], const struct_piece *piece, int x, int y
-)
-{
-    return ((field[piece->y_decline + y][piece->x_shift + x] == 1) &&
-        (piece->form.small[y][x] == 1));
+    return res;
 }
 
-static void handle_regular_piece_rotation_conflict(
-    const bool (*field)[field_width], const struct_piece *piece,
-    const int (*confl_coords)[2], int *amendment_1, int *amendment_2,
-    int default_change
+static void regular_piece_kick(
+    const piece_orientation *to, int conflicts, const int (*confl_coords)[2],
+    signed char *amendment_1, signed char *amendment_2, int default_change
 )
 {
     int confl_1_x = confl_coords[0][0], confl_1_y = confl_coords[0][1];
     int confl_2_x = confl_coords[1][0], confl_2_y = confl_coords[1][1];
     int confl_3_x = confl_coords[2][0], confl_3_y = confl_coords[2][1];
     /*  - double center conflict: no solution, roll the rotation back */
-    if (regular_piece_rotation_conflict(field, piece, confl_1_x, confl_1_y))
+    if (conflict_in_cell_(to, conflicts, confl_1_x, confl_1_y))
         return;
 
     /*  - center + corner conflict: if the conflicting cells are in the
     opposite rows/columns: move toward the only empty row/column */
-    if (regular_piece_rotation_conflict(field, piece, confl_2_x, confl_2_y)) {
+    if (conflict_in_cell_(to, conflicts, confl_2_x, confl_2_y)) {
         *amendment_1 += 1;
         return;
     } else
     /* the same center + corner conflict as the previous one.
     The difference - now the conflicting cell is in the opposite far corner */
-    if (regular_piece_rotation_conflict(field, piece, confl_3_x, confl_3_y)) {
+    if (conflict_in_cell_(to, conflicts, confl_3_x, confl_3_y)) {
         *amendment_1 -= 1;
         return;
     }
@@ -294,301 +257,150 @@ static void handle_regular_piece_rotation_conflict(
         . 2 .    . X .
 
 */
-static void regular_piece_rotation_conflicts_handling(
-    const bool (*field)[field_width], struct_piece *piece, int *dx, int *dy
+static kick regular_piece_rotation_kick(
+    const piece_orientation *to, int conflicts
 )
 {
-    int tmpdx = 0, tmpdy = 0;
+    kick res = { 0, 0 };
         /* top center conflict */
-    if (regular_piece_rotation_conflict(field, piece, 1, 0)) {
+    if (conflict_in_cell_(to, conflicts, 1, 0)) {
         int conflict_coordinates[][2] = { { 1, 2 }, { 0, 2 }, { 2, 2 } };
-        handle_regular_piece_rotation_conflict(
-            field, piece, conflict_coordinates, &tmpdx, &tmpdy, 1
+        regular_piece_kick(
+            to, conflicts, conflict_coordinates, &res.dx, &res.dy, 1
         );
     } else
         /* right center conflict */
-    if (regular_piece_rotation_conflict(field, piece, 2, 1)) {
+    if (conflict_in_cell_(to, conflicts, 2, 1)) {
         int conflict_coordinates[][2] = { { 0, 1 }, { 0, 0 }, { 0, 2 } };
-        handle_regular_piece_rotation_conflict(
-            field, piece, conflict_coordinates, &tmpdy, &tmpdx, -1
+        regular_piece_kick(
+            to, conflicts, conflict_coordinates, &res.dy, &res.dx, -1
         );
     } else
         /* bottom center conflict */
-    if (regular_piece_rotation_conflict(field, piece, 1, 2)) {
+    if (conflict_in_cell_(to, conflicts, 1, 2)) {
         int conflict_coordinates[][2] = { { 1, 0 }, { 0, 0 }, { 2, 0 } };
-        handle_regular_piece_rotation_conflict(
-            field, piece, conflict_coordinates, &tmpdx, &tmpdy, -1
+        regular_piece_kick(
+            to, conflicts, conflict_coordinates, &res.dx, &res.dy, -1
         );
     } else
         /* left center conflict */
-    if (regular_piece_rotation_conflict(field, piece, 0, 1)) {
+    if (conflict_in_cell_(to, conflicts, 0, 1)) {
         int conflict_coordinates[][2] = { { 2, 1 }, { 2, 0 }, { 2, 2 } };
-        handle_regular_piece_rotation_conflict(
-            field, piece, conflict_coordinates, &tmpdy, &tmpdx, 1
+        regular_piece_kick(
+            to, conflicts, conflict_coordinates, &res.dy, &res.dx, 1
         );
     } else
         /* top left corner conflict */
-    if (regular_piece_rotation_conflict(field, piece, 0, 0) ||
+    if (conflict_in_cell_(to, conflicts, 0, 0) ||
         /* bottom left corner conflict */
-        regular_piece_rotation_conflict(field, piece, 0, 2))
+        conflict_in_cell_(to, conflicts, 0, 2))
     {
-        tmpdx++;
+        res.dx++;
     }
     else
         /* top right corner conflict */
-    if (regular_piece_rotation_conflict(field, piece, 2, 0) ||
+    if (conflict_in_cell_(to, conflicts, 2, 0) ||
         /* bottom right corner conflict */
-        regular_piece_rotation_conflict(field, piece, 2, 2))
+        conflict_in_cell_(to, conflicts, 2, 2))
     {
-        tmpdx--;
+        res.dx--;
     }
-    piece->x_shift += tmpdx;
-    *dx += tmpdx;
-    piece->y_decline += tmpdy;
-    *dy += tmpdy;
-}
-
-static bool piece_left_boundary_conflict(
-    int x, int y, const struct_piece *piece
-)
-{
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    const bool (*matrix)[piece->size] = piece->form.small;
-    return (x + piece->x_shift < 0 && matrix[y][x] == 1);
-}
-
-static bool piece_right_boundary_conflict(
-    int x, int y, const struct_piece *piece
-)
-{
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    const bool (*matrix)[piece->size] = piece->form.small;
-    return ((x + piece->x_shift > field_width - 1 && matrix[y][x] == 1));
-}
-
-bool field_or_side_boundaries_conflict(
-    const bool (*field)[field_width], const struct_piece *piece
-)
-{
-    int y, x;
-    for (y=0; y < piece->size; y++) {
-        for (x=0; x < piece->size; x++) {
-            if (piece_left_boundary_conflict(x, y, piece) ||
-                piece_right_boundary_conflict(x, y, piece) ||
-                piece_field_conflict(field, x, y, piece))
-            {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-static bool out_of_bottom_field_boundary(const struct_piece *piece)
-{
-    return (piece->y_decline > field_height - piece->size);
+    return res;
 }
 
-static bool out_of_top_field_boundary(const struct_piece *piece)
+static signed char i_piece_pre_shift(position from)
 {
-    return (piece->y_decline < 0);
+    if (from == vertical_1)
+        return -1;
+    if (from == vertical_2)
+        return 1;
+    return 0;
 }
 
-static bool set_y_cycle_cond(
-    const struct_piece *piece, int *start_y, int *end_y, int *incr_y
+static void init_rotation_rule(
+    rotation_rule *rule, const struct_piece *piece, position from
 )
 {
-    if (out_of_top_field_boundary(piece)) {
-        /* loop forward */
-        *start_y = 0;
-        *end_y   = -piece->y_decline;
-        *incr_y  = 1;
-        return true;
-    }
-    else
-    if (out_of_bottom_field_boundary(piece)) {
-        /* loop back */
-        *start_y = piece->size-1;
-        *end_y   = field_height - piece->y_decline - 1;
-        *incr_y  = -1;
-        return true;
+    const piece_orientation *to;
+    int conflicts;
+    rule->rotates = (piece->kind != o_piece);
+    rule->to = next_orientation_of(from);
+    rule->pre_shift = (piece->i_form) ? i_piece_pre_shift(from) : 0;
+    to = get_piece_orientation(piece->kind, rule->to);
+    for (conflicts=0; conflicts < (1 << piece_cells); conflicts++) {
+        if (piece->i_form)
+            rule->kicks[conflicts] =
+                i_form_piece_rotation_kick(to, rule->to, conflicts);
+        else
+            rule->kicks[conflicts] = regular_piece_rotation_kick(to, conflicts);
     }
-    else
-        return false;
 }
 
-static bool vertical_orientation(const struct_piece *piece)
+void init_rotation_rules(const struct_piece *set_of_pieces)
 {
-    return ((piece->orientation == vertical_1) ||
-        (piece->orientation == vertical_2));
-}
-
-static bool special_i_piece_bottom_top_case(const struct_piece *piece)
-{
-    return ((piece->i_form) && vertical_orientation(piece));
-}
-
-static bool bottom_top_boundaries_crossing_(
-    crossing_action action, struct_piece *piece, int *dy
-)
-{
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    bool (*matrix)[piece->size] = piece->form.small;
-    bool res = false;
-    int x, y;
-    int start_y, end_y, incr_y;
-    if (!set_y_cycle_cond(piece, &start_y, &end_y, &incr_y))
-        return res;
-    for (y=start_y; y != end_y; y+=incr_y) {
-        for (x=0; x < piece->size; x++) {
-            if (matrix[y][x] == 1) {
-                res = true;
-                if (action == signal)
-                    return res;
-                piece->y_decline += incr_y;
-                *dy += incr_y;
-                if (special_i_piece_bottom_top_case(piece))
-                    continue;
-                else
-                    return res;
-            }
+    int kind;
+    position from;
+    for (kind=0; kind < num_of_pieces; kind++) {
+        for (from=0; from < orientation_count; from++) {
+            init_rotation_rule(
+                &rotation_rules[kind][from], &set_of_pieces[kind], from
+            );
         }
     }
-    return res;
 }
 
-static bool out_of_right_boundary(const struct_piece *piece)
-{
-    return (piece->x_shift > field_width - piece->size);
-}
-
-static bool out_of_left_boundary(const struct_piece *piece)
-{
-    return (piece->x_shift < 0);
-}
-
-static bool set_x_cycle_bound_cond(
-    const struct_piece *piece, int *start_x, int *end_x, int *incr_x
+static int field_conflicts(
+    const field_row *field, const piece_orientation *to, int x, int y
 )
 {
-    if (out_of_left_boundary(piece)) {
-        /* loop forward */
-        *start_x = 0;
-        *end_x   = -piece->x_shift;
-        *incr_x  = 1;
-        return true;
-    }
-    else
-    if (out_of_right_boundary(piece)) {
-        /* loop back */
-        *start_x = piece->size-1;
-        *end_x   = field_width - piece->x_shift - 1;
-        *incr_x  = -1;
-        return true;
+    int i, conflicts = 0;
+    for (i=0; i < piece_cells; i++) {
+        int cell = x + to->cells[i][0];
+        if ((field[y + to->cells[i][1]] >> cell) & 1)
+            conflicts |= 1 << i;
     }
-    else
-        return false;
-}
-
-static bool horizontal_orientation(const struct_piece *piece)
-{
-    return ((piece->orientation == horizontal_1) ||
-        (piece->orientation == horizontal_2));
-}
-
-static bool special_i_piece_side_case(const struct_piece *piece)
-{
-    return ((piece->i_form) && horizontal_orientation(piece));
+    return conflicts;
 }
 
-bool side_boundaries_crossing_(
-    crossing_action action, struct_piece *piece, int *dx
+bool handle_rotation_conflicts_on(
+    const field_kernels *kernels, const field_row *field, struct_piece *piece
 )
 {
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    bool (*matrix)[piece->size] = piece->form.small;
-    bool res = false;
-    int x, y;
-    int start_x, end_x, incr_x;
-    if (!set_x_cycle_bound_cond(piece, &start_x, &end_x, &incr_x))
-        return res;
-    for (y=0; y < piece->size; y++) {
-        for (x=start_x; x != end_x; x+=incr_x) {
-            if (matrix[y][x] == 1) {
-                res = true;
-                if (action == signal)
-                    return res;
-                piece->x_shift += incr_x;
-                if (dx)
-                    *dx += incr_x;
-                if (special_i_piece_side_case(piece))
-                    continue;
-                else
-                    return res;
-            }
-        }
-    }
-    return res;
-}
-
-static void next_orientation(struct_piece *piece)
-{
-    /* traversing a list of enumerated values cyclically (after the last
-    value, we get the 1st value again) */
-    piece->orientation = (piece->orientation + 1) % orientation_count;
-}
-
-static void handle_i_piece(struct_piece *piece, int *dx)
-{
-    /* after the rotation of the I piece, we need that both of it vertical
-    incarnations were at the same column */
-    if (piece->i_form) {
-        if (piece->orientation == vertical_1) {
-            piece->x_shift--;
-            (*dx)--;
-        } else
-        if (piece->orientation == vertical_2) {
-            piece->x_shift++;
-            (*dx)++;
+    const rotation_rule *rule = &rotation_rules[piece->kind][piece->orientation];
+    int x, y, push;
+    if (!rule->rotates)
+        return false;
+    x = piece->x_shift + rule->pre_shift;
+    y = piece->y_decline;
+    /* push the piece back inside the field if it crosses any boundary,
+    otherwise look up the shift resolving its piece/field cell crossings */
+    push = kernels->side_push(piece->kind, rule->to, x);
+    if (push)
+        x += push;
+    else {
+        push = kernels->bottom_top_push(piece->kind, rule->to, y);
+        if (push)
+            y += push;
+        else {
+            const piece_orientation *to =
+                get_piece_orientation(piece->kind, rule->to);
+            const kick *k = &rule->kicks[field_conflicts(field, to, x, y)];
+            x += k->dx;
+            y += k->dy;
         }
-        next_orientation(piece);
     }
+    /* if after all our efforts we still have conflicts - the piece keeps its
+    initial space orientation, `x_shift` and `y_decline` */
+    if (kernels->placement_conflict(field, piece->kind, rule->to, x, y))
+        return false;
+    piece->form = get_piece_orientation(piece->kind, rule->to)->form;
+    piece->x_shift = x;
+    piece->y_decline = y;
+    piece->orientation = rule->to;
+    return true;
 }
 
-void handle_rotation_conflicts(
-    const bool (*field)[field_width], struct_piece *piece, const void *backup
-)
+bool handle_rotation_conflicts(const field_row *field, struct_piece *piece)
 {
-    const bool (*backup_matrix)[piece->size] = backup;
-    int dx = 0, dy = 0;
-    if (o_piece(piece))
-        return;
-    handle_i_piece(piece, &dx);
-    /* prevent any boundaries crossing conflicts
-    and then look whether we have a piece/field cell crossing conflict now */
-    if (side_boundaries_crossing_(prevention, piece, &dx))
-        goto piece_field_cell_crossing_check;
-    if (bottom_top_boundaries_crossing_(prevention, piece, &dy))
-        goto piece_field_cell_crossing_check;
-    if (piece->i_form)
-        i_form_piece_rotation_conflicts_handling(field, piece, &dx, &dy);
-    else
-        regular_piece_rotation_conflicts_handling(field, piece, &dx, &dy);
-    /* if after all our efforts we still have conflicts - restore the initial
-    piece space orientation and its `x_shift` and `y_decline` */
-    if (side_boundaries_crossing_(signal, piece, NULL)) {
-        apply_backup(piece, backup_matrix, dx, dy);
-        return;
-    }
-    if (bottom_top_boundaries_crossing_(signal, piece, NULL)) {
-        apply_backup(piece, backup_matrix, dx, dy);
-        return;
-    }
-    piece_field_cell_crossing_check:
-    if (piece_field_crossing_conflict(field, piece))
-        apply_backup(piece, backup_matrix, dx, dy);
+    return handle_rotation_conflicts_on(standard_kernels(), field, piece);
 }
@@ -0,0 +1,234 @@
+/* field.c */
+
+#include "field.h"
+#include "piece_tables.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the wall bits of a piece row, and the field row with every cell occupied */
+#define FIELD_ROW_WALLS(WIDTH) \
+    (((1u << side_wall_cells) - 1) | \
+    (((1u << side_wall_cells) - 1) << (side_wall_cells + (WIDTH))))
+
+#define FIELD_ROW_FULL(WIDTH) \
+    ((field_row)((1u << (WIDTH)) - 1))
+
+/* the field row in the piece row bit order, with the side walls */
+#define WALLED_ROW(ROW, WIDTH) \
+    (((piece_row)(ROW) << side_wall_cells) | FIELD_ROW_WALLS(WIDTH))
+
+/* generates the engine kernels for a HEIGHT x WIDTH field and the dispatch
+table entry `NAME_kernels` referring to them */
+#define MAKE_FIELD_KERNELS(NAME, HEIGHT, WIDTH) \
+    static void NAME ## _init_field(field_row *field) \
+    { \
+        int y; \
+        for (y=0; y < (HEIGHT); y++) \
+            field[y] = empty_field_row; \
+    } \
+    \
+    static bool NAME ## _placement_conflict( \
+        const field_row *field, piece_kind kind, position orientation, \
+        int x_shift, int y_decline \
+    ) \
+    { \
+        const piece_masks *masks; \
+        int y; \
+        if (x_shift > (WIDTH)) \
+            return true; \
+        masks = get_piece_masks(kind, orientation, x_shift); \
+        if (!masks) \
+            return true; \
+        for (y=0; y < big_piece_size; y++) { \
+            if (!masks->rows[y]) \
+                continue; \
+            /* the rows above and below the field are as solid as walls */ \
+            if ((y + y_decline < 0) || (y + y_decline > (HEIGHT) - 1) || \
+                (WALLED_ROW(field[y + y_decline], WIDTH) & masks->rows[y])) \
+            { \
+                return true; \
+            } \
+        } \
+        return false; \
+    } \
+    \
+    static int NAME ## _landing_decline( \
+        const field_row *field, piece_kind kind, position orientation, \
+        int x_shift, int y_decline \
+    ) \
+    { \
+        while (!NAME ## _placement_conflict( \
+            field, kind, orientation, x_shift, y_decline + 1)) \
+        { \
+            y_decline++; \
+        } \
+        return y_decline; \
+    } \
+    \
+    static void NAME ## _lock_piece( \
+        field_row *field, piece_kind kind, position orientation, \
+        int x_shift, int y_decline \
+    ) \
+    { \
+        const piece_masks *masks = \
+            get_piece_masks(kind, orientation, x_shift); \
+        int y; \
+        for (y=0; y < big_piece_size; y++) { \
+            if (masks->rows[y]) \
+                field[y + y_decline] |= masks->rows[y] >> side_wall_cells; \
+        } \
+    } \
+    \
+    static int NAME ## _clear_completed_lines(field_row *field) \
+    { \
+        int y, dst, num_of_completed_lines = 0; \
+        for (y = dst = (HEIGHT) - 1; y >= 0; y--) { \
+            if (field[y] == FIELD_ROW_FULL(WIDTH)) \
+                num_of_completed_lines++; \
+            else \
+                field[dst--] = field[y]; \
+        } \
+        for (; dst >= 0; dst--) \
+            field[dst] = empty_field_row; \
+        return num_of_completed_lines; \
+    } \
+    \
+    static int NAME ## _clear_locked_lines( \
+        field_row *field, int first_row, int last_row, int top_row \
+    ) \
+    { \
+        int y, dst, num_of_completed_lines = 0; \
+        /* only the rows the piece was locked into can be completed */ \
+        for (y = last_row; y >= first_row; y--) { \
+            if (field[y] == FIELD_ROW_FULL(WIDTH)) \
+                break; \
+        } \
+        if (y < first_row) \
+            return 0; \
+        /* the rows above the stack top are empty, they stay in place */ \
+        for (dst = y; y >= top_row; y--) { \
+            if (field[y] == FIELD_ROW_FULL(WIDTH)) \
+                num_of_completed_lines++; \
+            else \
+                field[dst--] = field[y]; \
+        } \
+        for (; dst >= top_row; dst--) \
+            field[dst] = empty_field_row; \
+        return num_of_completed_lines; \
+    } \
+    \
+    static bool NAME ## _insert_bottom_rows( \
+        field_row *field, int num_of_rows, field_row row, int top_row \
+    ) \
+    { \
+        /* the rows above the stack top are empty, only the stack moves */ \
+        int first = (top_row > num_of_rows) ? top_row : num_of_rows; \
+        bool pushed_out = false; \
+        int y; \
+        for (y = top_row; y < first; y++) { \
+            if (field[y] != empty_field_row) \
+                pushed_out = true; \
+        } \
+        if (first < (HEIGHT)) { \
+            memmove( \
+                field + first - num_of_rows, field + first, \
+                ((HEIGHT) - first) * sizeof(field_row) \
+            ); \
+        } \
+        for (y = (HEIGHT) - num_of_rows; y < (HEIGHT); y++) \
+            field[y] = row; \
+        return pushed_out; \
+    } \
+    \
+    static int NAME ## _side_push( \
+        piece_kind kind, position orientation, int x_shift \
+    ) \
+    { \
+        const piece_orientation *piece = \
+            get_piece_orientation(kind, orientation); \
+        int left = x_shift + piece->min_x; \
+        int right = x_shift + piece->max_x - ((WIDTH) - 1); \
+        if (left < 0) \
+            return (piece->push_each_side_cell) ? -left : 1; \
+        if (right > 0) \
+            return (piece->push_each_side_cell) ? -right : -1; \
+        return 0; \
+    } \
+    \
+    static int NAME ## _bottom_top_push( \
+        piece_kind kind, position orientation, int y_decline \
+    ) \
+    { \
+        const piece_orientation *piece = \
+            get_piece_orientation(kind, orientation); \
+        int top = y_decline + piece->min_y; \
+        int bottom = y_decline + piece->max_y - ((HEIGHT) - 1); \
+        if (top < 0) \
+            return (piece->push_each_bottom_top_cell) ? -top : 1; \
+        if (bottom > 0) \
+            return (piece->push_each_bottom_top_cell) ? -bottom : -1; \
+        return 0; \
+    } \
+    \
+    static const field_kernels NAME ## _kernels = { \
+        .height = (HEIGHT), \
+        .width = (WIDTH), \
+        .spawn_x_shift = (WIDTH) / 2 - 1, \
+        .init_field = NAME ## _init_field, \
+        .placement_conflict = NAME ## _placement_conflict, \
+        .landing_decline = NAME ## _landing_decline, \
+        .lock_piece = NAME ## _lock_piece, \
+        .clear_completed_lines = NAME ## _clear_completed_lines, \
+        .clear_locked_lines = NAME ## _clear_locked_lines, \
+        .insert_bottom_rows = NAME ## _insert_bottom_rows, \
+        .side_push = NAME ## _side_push, \
+        .bottom_top_push = NAME ## _bottom_top_push \
+    };
+
+MAKE_FIELD_KERNELS(standard, field_height, field_width)
+
+MAKE_FIELD_KERNELS(buffered, 2 * field_height, field_width)
+
+MAKE_FIELD_KERNELS(narrow, field_height, 6)
+
+MAKE_FIELD_KERNELS(wide, field_height, max_field_width)
+
+static const field_kernels *const field_kernels_table[num_of_field_sizes] = {
+    [standard_field] = &standard_kernels,
+    [buffered_field] = &buffered_kernels,
+    [narrow_field] = &narrow_kernels,
+    [wide_field] = &wide_kernels
+};
+
+const field_kernels *get_field_kernels(field_size size)
+{
+    if ((unsigned int)size >= num_of_field_sizes) {
+        fprintf(
+            stderr, "%s:%d: incorrect field size %d\n",
+            __FILE__, __LINE__, size
+        );
+        exit(1);
+    }
+    return field_kernels_table[size];
+}
+
+void init_field(field_row *field)
+{
+    standard_kernels.init_field(field);
+}
+
+bool field_cell_is_occupied(const field_row *field, int x, int y)
+{
+    return (field[y] >> x) & 1;
+}
+
+bool field_row_is_completed(field_row row)
+{
+    return (row == full_field_row);
+}
+
+bool field_row_is_empty(field_row row)
+{
+    return (row == empty_field_row);
+}
@@ -0,0 +1,273 @@
+/* finesse.c */
+
+#include "finesse.h"
+#include "conflict_resolution.h"
+#include "piece_tables.h"
+#include <string.h>
+
+enum finesse_layout {
+    /* the `y_decline` range the search states are indexed by */
+    min_state_y_decline = -big_piece_size,
+    num_of_state_y_declines = max_field_height + 2 * big_piece_size,
+    num_of_states =
+        orientation_count * num_of_piece_x_shifts * num_of_state_y_declines,
+    no_state = -1,
+    /* the depth of a state the search hasn't reached */
+    unreached = 0xff
+};
+
+/* the actions a search state is expanded by */
+static const game_action finesse_actions[] = {
+    move_left, move_right, rotate_piece
+};
+
+enum {
+    num_of_finesse_actions =
+        sizeof(finesse_actions) / sizeof(finesse_actions[0])
+};
+
+/* a breadth-first search over the piece positions on one field; a state is
+an orientation, an `x_shift` and a `y_decline` packed into an index */
+typedef struct tag_finesse_search {
+    const field_kernels *kernels;
+    const field_row *field;
+    piece_kind kind;
+    /* the reached states in the order they were reached */
+    short queue[num_of_states];
+    int head, tail;
+    /* the state every reached state was reached from and the action it took,
+    the number of actions it took from the start */
+    short parent[num_of_states];
+    unsigned char action[num_of_states];
+    unsigned char depth[num_of_states];
+} finesse_search;
+
+/* the shortest paths from the spawn position on the empty field, by the
+orientation and the `x_shift` they end at (the length is 0 if the position
+can't be reached) */
+static finesse_path
+    empty_field_paths[num_of_field_sizes][num_of_pieces][orientation_count]
+        [num_of_piece_x_shifts];
+
+static int state_index(int orientation, int x_shift, int y_decline)
+{
+    if ((x_shift < min_piece_x_shift) || (x_shift > max_piece_x_shift) ||
+        (y_decline < min_state_y_decline) ||
+        (y_decline >= min_state_y_decline + num_of_state_y_declines))
+    {
+        return no_state;
+    }
+    return
+        ((orientation * num_of_piece_x_shifts) + x_shift - min_piece_x_shift) *
+        num_of_state_y_declines + y_decline - min_state_y_decline;
+}
+
+static void unpack_state(
+    int index, position *orientation, int *x_shift, int *y_decline
+)
+{
+    *y_decline = index % num_of_state_y_declines + min_state_y_decline;
+    index /= num_of_state_y_declines;
+    *x_shift = index % num_of_piece_x_shifts + min_piece_x_shift;
+    *orientation = index / num_of_piece_x_shifts;
+}
+
+static int next_state(const finesse_search *s, int from, game_action action)
+{
+    position orientation;
+    int x_shift, y_decline;
+    struct_piece piece;
+    unpack_state(from, &orientation, &x_shift, &y_decline);
+    switch (action) {
+        case move_left:
+        case move_right:
+            x_shift += (action == move_left) ? -1 : 1;
+            if (s->kernels->placement_conflict(
+                    s->field, s->kind, orientation, x_shift, y_decline
+                ))
+                return no_state;
+            return state_index(orientation, x_shift, y_decline);
+        case rotate_piece:
+            piece = game_piece_at(s->kind, orientation, x_shift, y_decline);
+            if (!handle_rotation_conflicts_on(s->kernels, s->field, &piece))
+                return no_state;
+            return state_index(
+                piece.orientation, piece.x_shift, piece.y_decline
+            );
+        default:
+            return no_state;
+    }
+}
+
+/* whether the piece dropped from the state covers the placement's cells */
+static bool lands_on(
+    const finesse_search *s, int state, const placement *target
+)
+{
+    const piece_orientation *a, *b;
+    position orientation;
+    int x_shift, y_decline, i;
+    unpack_state(state, &orientation, &x_shift, &y_decline);
+    y_decline = s->kernels->landing_decline(
+        s->field, s->kind, orientation, x_shift, y_decline
+    );
+    a = get_piece_orientation(s->kind, orientation);
+    b = get_piece_orientation(s->kind, target->orientation);
+    /* the cells are recorded row by row, so the same cells come in the same
+    order */
+    for (i=0; i < piece_cells; i++) {
+        if ((x_shift + a->cells[i][0] != target->x_shift + b->cells[i][0]) ||
+            (y_decline + a->cells[i][1] != target->y_decline + b->cells[i][1]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void start_search(
+    finesse_search *s, const field_kernels *kernels, const field_row *field,
+    piece_kind kind, int start
+)
+{
+    s->kernels = kernels;
+    s->field = field;
+    s->kind = kind;
+    memset(s->depth, unreached, sizeof(s->depth));
+    s->queue[0] = start;
+    s->parent[start] = no_state;
+    s->depth[start] = 0;
+    s->head = 0;
+    s->tail = 1;
+}
+
+/* returns the 1st reached state the piece lands on the target from, or
+`no_state`; with no target, reaches every state it can */
+static int run_search(finesse_search *s, const placement *target)
+{
+    while (s->head < s->tail) {
+        int state = s->queue[s->head++], i;
+        if (target && lands_on(s, state, target))
+            return state;
+        /* the hard drop takes one more action */
+        if (s->depth[state] + 2 > max_finesse_path_length)
+            continue;
+        for (i=0; i < num_of_finesse_actions; i++) {
+            int next = next_state(s, state, finesse_actions[i]);
+            if ((next == no_state) || (s->depth[next] != unreached))
+                continue;
+            s->parent[next] = state;
+            s->action[next] = finesse_actions[i];
+            s->depth[next] = s->depth[state] + 1;
+            s->queue[s->tail++] = next;
+        }
+    }
+    return no_state;
+}
+
+static void trace_path(const finesse_search *s, int state, finesse_path *path)
+{
+    int i;
+    path->length = s->depth[state] + 1;
+    path->actions[path->length - 1] = hard_drop;
+    for (i = path->length - 2; i >= 0; i--) {
+        path->actions[i] = s->action[state];
+        state = s->parent[state];
+    }
+}
+
+static int spawn_state(const field_kernels *kernels, piece_kind kind)
+{
+    /* the way `piece_spawn` puts the piece */
+    return state_index(
+        horizontal_1, kernels->spawn_x_shift,
+        -get_piece_orientation(kind, horizontal_1)->min_y
+    );
+}
+
+void init_finesse_tables()
+{
+    static finesse_search s;
+    field_row field[max_field_height];
+    int size, kind, i;
+    for (size=0; size < num_of_field_sizes; size++) {
+        const field_kernels *kernels = get_field_kernels(size);
+        kernels->init_field(field);
+        for (kind=0; kind < num_of_pieces; kind++) {
+            start_search(&s, kernels, field, kind, spawn_state(kernels, kind));
+            run_search(&s, NULL);
+            /* the states come in the order of their depth, so the 1st one
+            at an orientation and an `x_shift` is the closest one */
+            for (i=0; i < s.tail; i++) {
+                position orientation;
+                int x_shift, y_decline;
+                finesse_path *path;
+                unpack_state(s.queue[i], &orientation, &x_shift, &y_decline);
+                path = &empty_field_paths[size][kind][orientation]
+                    [x_shift - min_piece_x_shift];
+                if (path->length == 0)
+                    trace_path(&s, s.queue[i], path);
+            }
+        }
+    }
+}
+
+/* replays the empty field paths to every orientation covering the target
+cells on the real field, and picks the shortest one still landing there */
+static bool find_precomputed_path(
+    finesse_search *s, const game *g, const placement *target,
+    finesse_path *path
+)
+{
+    const piece_orientation *t =
+        get_piece_orientation(target->kind, target->orientation);
+    int start = spawn_state(s->kernels, s->kind);
+    position orientation;
+    bool found = false;
+    for (orientation=0; orientation < orientation_count; orientation++) {
+        const piece_orientation *o =
+            get_piece_orientation(target->kind, orientation);
+        int x_shift = target->x_shift + t->cells[0][0] - o->cells[0][0];
+        const finesse_path *p;
+        int state = start, i;
+        if ((x_shift < min_piece_x_shift) || (x_shift > max_piece_x_shift))
+            continue;
+        p = &empty_field_paths[g->size][target->kind][orientation]
+            [x_shift - min_piece_x_shift];
+        if ((p->length == 0) || (found && (p->length >= path->length)))
+            continue;
+        for (i=0; (i < p->length - 1) && (state != no_state); i++)
+            state = next_state(s, state, p->actions[i]);
+        if ((state != no_state) && lands_on(s, state, target)) {
+            *path = *p;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool find_finesse_path(
+    const game *g, const placement *target, finesse_path *path
+)
+{
+    /* too big for the stack of a thread playing many games */
+    static _Thread_local finesse_search s;
+    const field_kernels *kernels = game_kernels(g);
+    int start = state_index(
+        g->piece.orientation, g->piece.x_shift, g->piece.y_decline
+    );
+    int end;
+    if (!g->game_on || (target->kind != g->piece.kind) || (start == no_state))
+        return false;
+    start_search(&s, kernels, g->field, g->piece.kind, start);
+    if ((start == spawn_state(kernels, g->piece.kind)) &&
+        find_precomputed_path(&s, g, target, path))
+    {
+        return true;
+    }
+    end = run_search(&s, target);
+    if (end == no_state)
+        return false;
+    trace_path(&s, end, path);
+    return true;
+}
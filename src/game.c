@@ -0,0 +1,703 @@
+/* game.c */
+
+#include "game.h"
+#include "conflict_resolution.h"
+#include "piece_tables.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum game_consts {
+    /* replaces the zero seed, which the random piece generator can't use */
+    default_seed = 88675123
+};
+
+_Static_assert(
+    sizeof(game) <= 2 * cache_line_size, "a game record exceeds 2 cache lines"
+);
+
+static struct_piece set_of_pieces[num_of_pieces];
+
+void init_set_of_pieces(struct_piece *set_of_pieces)
+{
+    int i = 0;
+    struct_piece I_piece = {
+        .kind = i_piece,
+        .size = big_piece_size,
+        .form.big = {
+            { 0, 0, 0, 0 },
+            { 0, 0, 0, 0 },
+            { 1, 1, 1, 1 },
+            { 0, 0, 0, 0 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = true,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &I_piece, sizeof(struct_piece));
+    i++;
+    struct_piece O_piece = {
+        .kind = o_piece,
+        .size = big_piece_size,
+        .form.big = {
+            { 0, 0, 0, 0 },
+            { 0, 1, 1, 0 },
+            { 0, 1, 1, 0 },
+            { 0, 0, 0, 0 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &O_piece, sizeof(struct_piece));
+    i++;
+    struct_piece T_piece = {
+        .kind = t_piece,
+        .size = small_piece_size,
+        .form.small = {
+            { 0, 0, 0 },
+            { 1, 1, 1 },
+            { 0, 1, 0 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &T_piece, sizeof(struct_piece));
+    i++;
+    struct_piece S_piece = {
+        .kind = s_piece,
+        .size = small_piece_size,
+        .form.small = {
+            { 0, 0, 0 },
+            { 0, 1, 1 },
+            { 1, 1, 0 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &S_piece, sizeof(struct_piece));
+    i++;
+    struct_piece Z_piece = {
+        .kind = z_piece,
+        .size = small_piece_size,
+        .form.small = {
+            { 0, 0, 0 },
+            { 1, 1, 0 },
+            { 0, 1, 1 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &Z_piece, sizeof(struct_piece));
+    i++;
+    struct_piece J_piece = {
+        .kind = j_piece,
+        .size = small_piece_size,
+        .form.small = {
+            { 0, 0, 0 },
+            { 1, 1, 1 },
+            { 0, 0, 1 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &J_piece, sizeof(struct_piece));
+    i++;
+    struct_piece L_piece = {
+        .kind = l_piece,
+        .size = small_piece_size,
+        .form.small = {
+            { 0, 0, 0 },
+            { 1, 1, 1 },
+            { 1, 0, 0 }
+        },
+        .x_shift = initial_piece_shift,
+        .y_decline = 0, .ghost_decline = 0,
+        .i_form = false,
+        .orientation = horizontal_1
+    };
+    memcpy(&set_of_pieces[i], &L_piece, sizeof(struct_piece));
+}
+
+static void init_engine_tables()
+{
+    static bool initialized = false;
+    if (initialized)
+        return;
+    init_set_of_pieces(set_of_pieces);
+    init_piece_tables(set_of_pieces);
+    init_rotation_rules(set_of_pieces);
+    initialized = true;
+}
+
+static unsigned int next_random(game *g)
+{
+    /* xorshift32 */
+    unsigned int x = g->rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g->rng_state = x;
+    return x;
+}
+
+static piece_kind get_random_piece(game *g)
+{
+    return (piece_kind)
+        (((unsigned long long)next_random(g) * num_of_pieces) >> 32);
+}
+
+const field_kernels *game_kernels(const game *g)
+{
+    return get_field_kernels(g->size);
+}
+
+struct_piece game_piece_at(
+    piece_kind kind, position orientation, int x_shift, int y_decline
+)
+{
+    struct_piece piece = set_of_pieces[kind];
+    piece.form = get_piece_orientation(kind, orientation)->form;
+    piece.orientation = orientation;
+    piece.x_shift = x_shift;
+    piece.y_decline = y_decline;
+    piece.ghost_decline = y_decline;
+    return piece;
+}
+
+struct_piece game_piece(const game *g)
+{
+    struct_piece piece = game_piece_at(
+        g->piece.kind, g->piece.orientation, g->piece.x_shift,
+        g->piece.y_decline
+    );
+    piece.ghost_decline = g->piece.ghost_decline;
+    return piece;
+}
+
+piece_kind game_preview_kind(const game *g, int i)
+{
+    return g->preview[(g->preview_head + i) % g->num_of_previews];
+}
+
+struct_piece game_next_piece(const game *g)
+{
+    return set_of_pieces[game_preview_kind(g, 0)];
+}
+
+int gravity_delay(int level)
+{
+    speed_list speed[] = {
+        zero,     first,       second,      third,      fourth,    fifth,
+        sixth,    seventh,     eighth,      ninth,      tenth,     eleventh,
+        twelfth,  thirteenth,  fourteenth,  fifteenth
+    };
+    if (level > last_classic_gravity_level)
+        return gravity_frame_time;
+    return speed[level];
+}
+
+int gravity_rows(int level)
+{
+    high_gravity_list rows[] = {
+        sixteenth, seventeenth, eighteenth, nineteenth, twentieth
+    };
+    if (level <= last_classic_gravity_level)
+        return 1;
+    return rows[level - last_classic_gravity_level - 1];
+}
+
+static bool piece_conflict_at(const game *g, int x_shift, int y_decline)
+{
+    return game_kernels(g)->placement_conflict(
+        g->field, g->piece.kind, g->piece.orientation, x_shift, y_decline
+    );
+}
+
+static bool piece_has_fallen(const game *g)
+{
+    return piece_conflict_at(g, g->piece.x_shift, g->piece.y_decline + 1);
+}
+
+static void cast_ghost(game *g)
+{
+    g->piece.ghost_decline = game_kernels(g)->landing_decline(
+        g->field, g->piece.kind, g->piece.orientation,
+        g->piece.x_shift, g->piece.y_decline
+    );
+}
+
+/* 20G: the piece lands as soon as it spawns or moves */
+static void drop_at_high_gravity(game *g)
+{
+    if ((gravity_rows(g->level) >= twentieth) &&
+        (g->piece.y_decline != g->piece.ghost_decline))
+    {
+        g->piece.y_decline = g->piece.ghost_decline;
+        g->changes |= piece_changed;
+    }
+}
+
+static void piece_spawn(game *g)
+{
+    g->piece.kind = g->preview[g->preview_head];
+    g->piece.orientation = horizontal_1;
+    g->preview[g->preview_head] = get_random_piece(g);
+    g->preview_head = (g->preview_head + 1) % g->num_of_previews;
+    g->piece.x_shift = game_kernels(g)->spawn_x_shift;
+    /* the piece's empty upmost rows stay above the field */
+    g->piece.y_decline =
+        -get_piece_orientation(g->piece.kind, g->piece.orientation)->min_y;
+    g->piece.ghost_decline = g->piece.y_decline;
+    g->lock_resets = 0;
+    g->landed = false;
+    g->changes |= piece_changed | next_piece_changed;
+    if (piece_conflict_at(g, g->piece.x_shift, g->piece.y_decline)) {
+        g->game_on = false;
+        g->changes |= game_ended;
+        return;
+    }
+    cast_ghost(g);
+    drop_at_high_gravity(g);
+}
+
+int score_bonus(int level, int num_of_completed_lines)
+{
+    switch (num_of_completed_lines) {
+        case 1:
+            return level * one_line_score_bonus;
+        case 2:
+            return level * two_lines_score_bonus;
+        case 3:
+            return level * three_lines_score_bonus;
+        case 4:
+            return level * four_lines_score_bonus;
+        default:
+            fprintf(
+                stderr, "%s:%d: incorrect number of completed lines: %d\n",
+                __FILE__, __LINE__, num_of_completed_lines
+            );
+            exit(1);
+    }
+}
+
+static void level_up_if_necessary(game *g, int num_of_completed_lines)
+{
+    g->lines_since_level_up += num_of_completed_lines;
+    if (g->lines_since_level_up >= num_of_completed_lines_for_level_up) {
+        /* the lines lead up to the classic gravity only, a game started at
+        a high gravity level stays at it */
+        if (g->level < last_classic_gravity_level)
+            g->level++;
+        g->changes |= level_changed;
+        g->lines_since_level_up = 0;
+    }
+}
+
+static void field_absorbes_piece(game *g)
+{
+    int top = g->piece.y_decline +
+        get_piece_orientation(g->piece.kind, g->piece.orientation)->min_y;
+    game_kernels(g)->lock_piece(
+        g->field, g->piece.kind, g->piece.orientation,
+        g->piece.x_shift, g->piece.y_decline
+    );
+    if (top < g->stack_top)
+        g->stack_top = top;
+    g->changes |= field_changed;
+}
+
+static void clear_completed_lines_update_score_and_level_up(game *g)
+{
+    /* the piece is still where it was locked */
+    const piece_orientation *entry =
+        get_piece_orientation(g->piece.kind, g->piece.orientation);
+    const field_kernels *kernels = game_kernels(g);
+    field_row full_row = (1u << kernels->width) - 1;
+    int first_row = g->piece.y_decline + entry->min_y;
+    int last_row = g->piece.y_decline + entry->max_y;
+    int num_of_completed_lines, y;
+    g->cleared_top = first_row;
+    for (y=first_row; y <= last_row; y++) {
+        if (g->field[y] == full_row)
+            g->cleared_lines |= 1 << (y - first_row);
+    }
+    num_of_completed_lines = kernels->clear_locked_lines(
+        g->field, first_row, last_row, g->stack_top
+    );
+    if (num_of_completed_lines) {
+        g->stack_top += num_of_completed_lines;
+        g->lines += num_of_completed_lines;
+        g->score += score_bonus(g->level, num_of_completed_lines);
+        g->changes |= score_changed;
+        level_up_if_necessary(g, num_of_completed_lines);
+    }
+}
+
+static void lock_piece_and_spawn_next(game *g)
+{
+    field_absorbes_piece(g);
+    clear_completed_lines_update_score_and_level_up(g);
+    piece_spawn(g);
+}
+
+static void move_(game *g, int dx)
+{
+    if (piece_conflict_at(g, g->piece.x_shift + dx, g->piece.y_decline))
+        return;
+    g->piece.x_shift += dx;
+    cast_ghost(g);
+    g->changes |= piece_changed;
+}
+
+/* the farthest free column is found by the placement checks alone, the ghost
+is cast and the piece redrawn once; at 20G the piece drops into every gap it
+passes, as the moves one by one would drop it */
+static void shift_(game *g, int dx)
+{
+    int x_shift = g->piece.x_shift, y_decline = g->piece.y_decline;
+    bool lands_at_once = gravity_rows(g->level) >= twentieth;
+    while (!piece_conflict_at(g, x_shift + dx, y_decline)) {
+        x_shift += dx;
+        if (lands_at_once) {
+            y_decline = game_kernels(g)->landing_decline(
+                g->field, g->piece.kind, g->piece.orientation,
+                x_shift, y_decline
+            );
+        }
+    }
+    if (x_shift == g->piece.x_shift)
+        return;
+    g->piece.x_shift = x_shift;
+    g->piece.y_decline = y_decline;
+    cast_ghost(g);
+    g->changes |= piece_changed;
+}
+
+static void handle_rotation(game *g)
+{
+    struct_piece piece = game_piece(g);
+    if (!handle_rotation_conflicts_on(game_kernels(g), g->field, &piece))
+        return;
+    g->piece.orientation = piece.orientation;
+    g->piece.x_shift = piece.x_shift;
+    g->piece.y_decline = piece.y_decline;
+    cast_ghost(g);
+    g->changes |= piece_changed;
+}
+
+/* whether a landed piece waits for a lock delay: without one it locks at
+the next gravity step, the classic way */
+static bool has_lock_delay(const game *g)
+{
+    return g->lock_delay || (g->level > last_classic_gravity_level);
+}
+
+static int lock_delay_of(const game *g)
+{
+    if (g->lock_delay)
+        return g->lock_delay;
+    return (g->level > last_classic_gravity_level) ?
+        high_gravity_lock_delay : gravity_delay(g->level);
+}
+
+static void start_lock_delay(game *g, long time)
+{
+    g->landed = true;
+    g->gravity_deadline = time + lock_delay_of(g);
+}
+
+/* the next gravity step is a fall, or the lock once the piece has landed */
+static void set_gravity_deadline(game *g, long time)
+{
+    if (piece_has_fallen(g))
+        start_lock_delay(g, time);
+    else
+        g->gravity_deadline = time + gravity_delay(g->level);
+}
+
+static void lock_and_spawn_at(game *g, long time)
+{
+    lock_piece_and_spawn_next(g);
+    set_gravity_deadline(g, time);
+}
+
+/* the piece falls by up to `rows` cells in one step, the landing row known
+from its ghost, so a high gravity takes no more steps than a low one */
+static void apply_gravity(game *g, int rows, long time)
+{
+    int y_decline;
+    if (piece_has_fallen(g) && (g->landed || !has_lock_delay(g))) {
+        lock_and_spawn_at(g, time);
+        return;
+    }
+    y_decline = g->piece.y_decline + rows;
+    if (y_decline > g->piece.ghost_decline)
+        y_decline = g->piece.ghost_decline;
+    if (y_decline != g->piece.y_decline) {
+        g->piece.y_decline = y_decline;
+        g->changes |= piece_changed;
+    }
+    set_gravity_deadline(g, time);
+}
+
+/* a piece moved on its landing row restarts its lock delay, as many times as
+the game lets it; moved off the row, it falls again */
+static void after_move(game *g, long time)
+{
+    if (!(g->changes & piece_changed))
+        return;
+    drop_at_high_gravity(g);
+    if (!piece_has_fallen(g))
+        g->landed = false;
+    else if (!g->landed) {
+        if (has_lock_delay(g))
+            start_lock_delay(g, time);
+    } else if (g->lock_resets < g->move_reset_limit) {
+        g->lock_resets++;
+        start_lock_delay(g, time);
+    }
+}
+
+static int clamped(int value, int min, int max)
+{
+    return (value < min) ? min : (value > max) ? max : value;
+}
+
+void game_add_garbage(game *g, int num_of_rows, int hole_x)
+{
+    const field_kernels *kernels = game_kernels(g);
+    /* a row without a hole could never be cleared */
+    field_row garbage = ((1u << kernels->width) - 1) &
+        ~(1u << clamped(hole_x, 0, kernels->width - 1));
+    bool topped_out;
+    int lift;
+    g->changes = 0;
+    g->cleared_lines = 0;
+    if (!g->game_on || (num_of_rows <= 0))
+        return;
+    if (num_of_rows > kernels->height)
+        num_of_rows = kernels->height;
+    topped_out = kernels->insert_bottom_rows(
+        g->field, num_of_rows, garbage, g->stack_top
+    );
+    g->stack_top = (g->stack_top > num_of_rows) ?
+        g->stack_top - num_of_rows : 0;
+    g->changes |= field_changed | piece_changed;
+    lift = 0;
+    while ((lift <= num_of_rows) &&
+        piece_conflict_at(g, g->piece.x_shift, g->piece.y_decline - lift))
+    {
+        lift++;
+    }
+    if (topped_out || (lift > num_of_rows)) {
+        g->game_on = false;
+        g->changes |= game_ended;
+        return;
+    }
+    g->piece.y_decline -= lift;
+    cast_ghost(g);
+}
+
+static void process_action(game *g, game_action action, long time)
+{
+    switch (action) {
+        case move_left:
+            move_(g, -1);
+            after_move(g, time);
+            break;
+        case move_right:
+            move_(g, 1);
+            after_move(g, time);
+            break;
+        case shift_left:
+            shift_(g, -1);
+            after_move(g, time);
+            break;
+        case shift_right:
+            shift_(g, 1);
+            after_move(g, time);
+            break;
+        case rotate_piece:
+            handle_rotation(g);
+            after_move(g, time);
+            break;
+        case soft_drop:
+            apply_gravity(g, 1, time);
+            break;
+        case hard_drop:
+            g->piece.y_decline = g->piece.ghost_decline;
+            g->changes |= piece_changed;
+            lock_and_spawn_at(g, time);
+            break;
+        case quit_game:
+            g->game_on = false;
+            g->changes |= game_ended;
+            break;
+        case no_action:
+            break;
+        default:
+            fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
+            exit(1);
+    }
+}
+
+void init_game(game *g, field_size size, unsigned int seed, long time)
+{
+    init_engine_tables();
+    g->size = size;
+    game_kernels(g)->init_field(g->field);
+    g->stack_top = game_kernels(g)->height;
+    g->level = 1;
+    g->score = 0;
+    g->lines = 0;
+    g->lines_since_level_up = 0;
+    g->rng_state = (seed) ? seed : default_seed;
+    g->game_on = true;
+    g->changes = 0;
+    g->cleared_top = 0;
+    g->cleared_lines = 0;
+    g->lock_delay = 0;
+    g->move_reset_limit = 0;
+    g->preview[0] = get_random_piece(g);
+    g->preview_head = 0;
+    g->num_of_previews = 1;
+    piece_spawn(g);
+    g->gravity_deadline = time + gravity_delay(g->level);
+    g->changes |= field_changed | score_changed | level_changed;
+}
+
+/* the preview gets longer with the pieces drawn next, or shorter without
+its last pieces */
+static void set_num_of_previews(game *g, int num_of_previews)
+{
+    unsigned char kinds[max_preview_pieces];
+    int i;
+    if (num_of_previews == g->num_of_previews)
+        return;
+    for (i=0; i < num_of_previews; i++) {
+        kinds[i] = (i < g->num_of_previews) ?
+            game_preview_kind(g, i) : get_random_piece(g);
+    }
+    memcpy(g->preview, kinds, num_of_previews);
+    g->preview_head = 0;
+    g->num_of_previews = num_of_previews;
+    g->changes |= next_piece_changed;
+}
+
+void set_game_rules(game *g, const game_rules *rules, long time)
+{
+    int level = clamped(rules->start_level, 1, maximum_game_level);
+    if (level != g->level)
+        g->changes |= level_changed;
+    set_num_of_previews(
+        g, clamped(rules->previews, 1, max_preview_pieces)
+    );
+    g->level = level;
+    g->lock_delay = clamped(rules->lock_delay, 0, USHRT_MAX);
+    g->move_reset_limit = clamped(rules->move_reset_limit, 0, UCHAR_MAX);
+    if (!g->game_on)
+        return;
+    drop_at_high_gravity(g);
+    set_gravity_deadline(g, time);
+}
+
+void game_step(game *g, const game_event *event)
+{
+    g->changes = 0;
+    g->cleared_lines = 0;
+    if (!g->game_on)
+        return;
+    switch (event->kind) {
+        case input_event:
+            process_action(g, event->action, event->time);
+            break;
+        case gravity_event:
+            apply_gravity(g, gravity_rows(g->level), event->time);
+            break;
+        default:
+            fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
+            exit(1);
+    }
+}
+
+static bool placement_fits(const game *g, const placement *p)
+{
+    return g->game_on && (p->kind == g->piece.kind) &&
+        !game_kernels(g)->placement_conflict(
+            g->field, p->kind, p->orientation, p->x_shift, p->y_decline
+        );
+}
+
+bool game_place_piece(game *g, const placement *p)
+{
+    g->changes = 0;
+    g->cleared_lines = 0;
+    if (!placement_fits(g, p))
+        return false;
+    g->piece.orientation = p->orientation;
+    g->piece.x_shift = p->x_shift;
+    g->piece.y_decline = p->y_decline;
+    g->changes |= piece_changed;
+    lock_piece_and_spawn_next(g);
+    return true;
+}
+
+bool game_place_piece_journaled(
+    game *g, const placement *p, game_undo *undo
+)
+{
+    undo->score = g->score;
+    undo->lines = g->lines;
+    undo->rng_state = g->rng_state;
+    undo->piece = g->piece;
+    undo->preview_kind = g->preview[g->preview_head];
+    undo->preview_head = g->preview_head;
+    undo->level = g->level;
+    undo->lines_since_level_up = g->lines_since_level_up;
+    undo->stack_top = g->stack_top;
+    undo->lock_resets = g->lock_resets;
+    undo->game_on = g->game_on;
+    undo->landed = g->landed;
+    if (!placement_fits(g, p)) {
+        g->changes = 0;
+        g->cleared_lines = 0;
+        return false;
+    }
+    record_placement(game_kernels(g), g->field, p, &undo->field);
+    return game_place_piece(g, p);
+}
+
+void game_undo_placement(game *g, const game_undo *undo)
+{
+    undo_placement(game_kernels(g), g->field, &undo->field);
+    g->changes = field_changed | piece_changed | next_piece_changed;
+    g->cleared_lines = 0;
+    if (g->score != undo->score)
+        g->changes |= score_changed;
+    if (g->level != undo->level)
+        g->changes |= level_changed;
+    g->score = undo->score;
+    g->lines = undo->lines;
+    g->rng_state = undo->rng_state;
+    g->piece = undo->piece;
+    g->preview_head = undo->preview_head;
+    g->preview[g->preview_head] = undo->preview_kind;
+    g->level = undo->level;
+    g->lines_since_level_up = undo->lines_since_level_up;
+    g->stack_top = undo->stack_top;
+    g->lock_resets = undo->lock_resets;
+    g->game_on = undo->game_on;
+    g->landed = undo->landed;
+}
@@ -0,0 +1,88 @@
+/* key_repeat.c */
+
+#include "key_repeat.h"
+#include <limits.h>
+
+enum key_repeat_internal_consts {
+    /* a held key is taken as released when its repeat is this many gaps late,
+    plus the slack, so a slightly late repeat doesn't stop the piece */
+    missed_repeats = 2,
+    release_slack = 8
+};
+
+void init_key_repeat(key_repeat *k, int das, int arr)
+{
+    k->das = (das > 0) ? das : 0;
+    k->arr = (arr > 0) ? arr : 0;
+    k->direction = no_action;
+    k->pressed_at = k->last_seen = 0;
+    k->repeat_gap = max_terminal_repeat_gap;
+    k->held = false;
+    k->next_shift = LONG_MAX;
+}
+
+static long release_time(const key_repeat *k)
+{
+    return k->last_seen + missed_repeats * k->repeat_gap + release_slack;
+}
+
+game_action key_repeat_press(key_repeat *k, game_action action, long time)
+{
+    long gap = time - k->last_seen;
+    if ((action != move_left) && (action != move_right))
+        return action;
+    if ((action != k->direction) || (gap > max_terminal_repeat_delay)) {
+        /* a new press */
+        k->direction = action;
+        k->pressed_at = time;
+        k->held = false;
+    } else if (gap <= max_terminal_repeat_gap) {
+        /* the terminal repeats the key: it's been held since the press; the
+        1st repeat has moved the piece already (at `last_seen`), so the next
+        move is an ARR interval after it */
+        k->repeat_gap = gap;
+        if (!k->held) {
+            k->held = true;
+            k->next_shift = k->pressed_at + k->das;
+            if (k->next_shift < k->last_seen + k->arr)
+                k->next_shift = k->last_seen + k->arr;
+            if (k->next_shift < time)
+                k->next_shift = time;
+        }
+        k->last_seen = time;
+        return no_action;
+    } else {
+        /* the 1st repeat or a tap: the key may still turn out to be held
+        since the 1st press */
+        k->held = false;
+    }
+    k->last_seen = time;
+    return action;
+}
+
+long key_repeat_deadline(const key_repeat *k)
+{
+    long release;
+    if (!k->held)
+        return LONG_MAX;
+    release = release_time(k) + 1;
+    return (k->next_shift < release) ? k->next_shift : release;
+}
+
+game_action key_repeat_due(key_repeat *k, long time)
+{
+    if (!k->held)
+        return no_action;
+    if (time > release_time(k)) {
+        k->held = false;
+        return no_action;
+    }
+    if (time < k->next_shift)
+        return no_action;
+    if (!k->arr) {
+        k->next_shift = time + instant_repeat_interval;
+        return (k->direction == move_left) ? shift_left : shift_right;
+    }
+    k->next_shift += k->arr;
+    return k->direction;
+}
@@ -0,0 +1,74 @@
+/* ncurses_screen.c */
+
+#include "screen.h"
+#include "screen_backend.h"
+#include <ncurses.h>
+
+static void ncurses_init()
+{
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, 1);
+    ESCDELAY = 50;
+    curs_set(0);
+}
+
+static void ncurses_end()
+{
+    endwin();
+}
+
+static void ncurses_size(int *row, int *col)
+{
+    int r, c;
+    getmaxyx(stdscr, r, c);
+    *row = r;
+    *col = c;
+}
+
+static void ncurses_put_str(int y, int x, const char *str)
+{
+    mvaddstr(y, x, str);
+}
+
+static void ncurses_clear()
+{
+    clear();
+}
+
+static void ncurses_flush()
+{
+    curs_set(0);
+    refresh();
+}
+
+static int ncurses_get_key(int delay)
+{
+    int key;
+    timeout(delay);
+    key = getch();
+    switch (key) {
+        case KEY_LEFT:
+            return key_left;
+        case KEY_RIGHT:
+            return key_right;
+        case KEY_UP:
+            return key_up;
+        case KEY_DOWN:
+            return key_down;
+        case ERR:
+            return no_key;
+        default:
+            return key;
+    }
+}
+
+const screen_backend *get_ncurses_screen_backend()
+{
+    static const screen_backend ncurses_backend = {
+        ncurses_init, ncurses_end, ncurses_size, ncurses_put_str,
+        ncurses_clear, ncurses_flush, ncurses_get_key, read_terminal_key
+    };
+    return &ncurses_backend;
+}
@@ -0,0 +1,150 @@
+/* piece_tables.c */
+
+#include "piece_tables.h"
+#include "rotation.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static piece_orientation orientations[num_of_pieces][orientation_count];
+
+position next_orientation_of(position orientation)
+{
+    return (orientation + 1) % orientation_count;
+}
+
+static void record_cells(piece_orientation *entry, int size)
+{
+    /* `form.small` and `form.big` share the same address,
+    so we handle both scenarios here */
+    const bool (*matrix)[size] = entry->form.small;
+    int x, y, i = 0;
+    for (y=0; y < size; y++) {
+        for (x=0; x < size; x++) {
+            if (matrix[y][x] == 0)
+                continue;
+            if (i == piece_cells) {
+                fprintf(
+                    stderr, "%s:%d: a piece has more than %d cells\n",
+                    __FILE__, __LINE__, piece_cells
+                );
+                exit(1);
+            }
+            entry->cells[i][0] = x;
+            entry->cells[i][1] = y;
+            i++;
+        }
+    }
+    if (i != piece_cells) {
+        fprintf(
+            stderr, "%s:%d: a piece has %d cells instead of %d\n",
+            __FILE__, __LINE__, i, piece_cells
+        );
+        exit(1);
+    }
+}
+
+static bool horizontal_(position orientation)
+{
+    return ((orientation == horizontal_1) || (orientation == horizontal_2));
+}
+
+static void record_extents(
+    piece_orientation *entry, piece_kind kind, position orientation
+)
+{
+    int i;
+    entry->min_x = entry->max_x = entry->cells[0][0];
+    entry->min_y = entry->max_y = entry->cells[0][1];
+    for (i=1; i < piece_cells; i++) {
+        if (entry->cells[i][0] < entry->min_x)
+            entry->min_x = entry->cells[i][0];
+        if (entry->cells[i][0] > entry->max_x)
+            entry->max_x = entry->cells[i][0];
+        if (entry->cells[i][1] < entry->min_y)
+            entry->min_y = entry->cells[i][1];
+        if (entry->cells[i][1] > entry->max_y)
+            entry->max_y = entry->cells[i][1];
+    }
+    entry->push_each_side_cell = (kind == i_piece) && horizontal_(orientation);
+    entry->push_each_bottom_top_cell =
+        (kind == i_piece) && !horizontal_(orientation);
+}
+
+static void record_masks(piece_orientation *entry)
+{
+    int x_shift, i;
+    for (x_shift=min_piece_x_shift; x_shift <= max_piece_x_shift; x_shift++) {
+        piece_masks *masks = &entry->masks[x_shift - min_piece_x_shift];
+        for (i=0; i < big_piece_size; i++)
+            masks->rows[i] = 0;
+        for (i=0; i < piece_cells; i++) {
+            int x = x_shift + entry->cells[i][0] + side_wall_cells;
+            masks->rows[entry->cells[i][1]] |= 1u << x;
+        }
+    }
+}
+
+static bool same_shifted_cells(
+    const piece_orientation *a, const piece_orientation *b
+)
+{
+    /* the cells are recorded row by row, so a shifted copy keeps their order */
+    int i;
+    for (i=0; i < piece_cells; i++) {
+        if (a->cells[i][0] - a->min_x != b->cells[i][0] - b->min_x)
+            return false;
+        if (a->cells[i][1] - a->min_y != b->cells[i][1] - b->min_y)
+            return false;
+    }
+    return true;
+}
+
+static void record_duplicates(piece_orientation *entries)
+{
+    int i, j;
+    for (i=0; i < orientation_count; i++) {
+        entries[i].duplicate = false;
+        for (j=0; j < i; j++) {
+            if (same_shifted_cells(&entries[i], &entries[j])) {
+                entries[i].duplicate = true;
+                break;
+            }
+        }
+    }
+}
+
+void init_piece_tables(const struct_piece *set_of_pieces)
+{
+    int kind;
+    position orientation;
+    for (kind=0; kind < num_of_pieces; kind++) {
+        const struct_piece *piece = &set_of_pieces[kind];
+        union tag_form form = piece->form;
+        for (orientation=0; orientation < orientation_count; orientation++) {
+            orientations[kind][orientation].form = form;
+            record_cells(&orientations[kind][orientation], piece->size);
+            record_extents(&orientations[kind][orientation], kind, orientation);
+            record_masks(&orientations[kind][orientation]);
+            /* `form.small` and `form.big` share the same address,
+            so we handle both scenarios here */
+            rotate(form.small, piece->size);
+        }
+        record_duplicates(orientations[kind]);
+    }
+}
+
+const piece_orientation *get_piece_orientation(
+    piece_kind kind, position orientation
+)
+{
+    return &orientations[kind][orientation];
+}
+
+const piece_masks *get_piece_masks(
+    piece_kind kind, position orientation, int x_shift
+)
+{
+    if ((x_shift < min_piece_x_shift) || (x_shift > max_piece_x_shift))
+        return NULL;
+    return &orientations[kind][orientation].masks[x_shift - min_piece_x_shift];
+}
@@ -0,0 +1,126 @@
+/* placement.c */
+
+#include "placement.h"
+#include "piece_tables.h"
+#include <string.h>
+
+placement *enumerate_placements(
+    const field_kernels *kernels, const field_row *field, piece_kind kind,
+    arena *a, int *num_of_placements
+)
+{
+    placement *list = arena_alloc(a, max_num_of_placements * sizeof(placement));
+    position orientation;
+    int n = 0;
+    for (orientation=0; orientation < orientation_count; orientation++) {
+        const piece_orientation *entry =
+            get_piece_orientation(kind, orientation);
+        int x_shift, spawn_decline = -entry->min_y;
+        if (entry->duplicate)
+            continue;
+        for (
+            x_shift = -entry->min_x;
+            x_shift + entry->max_x < kernels->width;
+            x_shift++
+        )
+        {
+            if (kernels->placement_conflict(
+                    field, kind, orientation, x_shift, spawn_decline
+                ))
+                continue;
+            list[n].kind = kind;
+            list[n].orientation = orientation;
+            list[n].x_shift = x_shift;
+            list[n].y_decline = kernels->landing_decline(
+                field, kind, orientation, x_shift, spawn_decline
+            );
+            n++;
+        }
+    }
+    *num_of_placements = n;
+    return list;
+}
+
+field_row *snapshot_field(
+    const field_kernels *kernels, const field_row *field, arena *a
+)
+{
+    field_row *copy = arena_alloc(a, kernels->height * sizeof(field_row));
+    memcpy(copy, field, kernels->height * sizeof(field_row));
+    return copy;
+}
+
+int apply_placement(
+    const field_kernels *kernels, field_row *field, const placement *p
+)
+{
+    const piece_orientation *entry =
+        get_piece_orientation(p->kind, p->orientation);
+    kernels->lock_piece(
+        field, p->kind, p->orientation, p->x_shift, p->y_decline
+    );
+    /* the field's stack top isn't tracked here, every row above the piece
+    is moved */
+    return kernels->clear_locked_lines(
+        field, p->y_decline + entry->min_y, p->y_decline + entry->max_y, 0
+    );
+}
+
+void record_placement(
+    const field_kernels *kernels, const field_row *field, const placement *p,
+    placement_undo *undo
+)
+{
+    const piece_orientation *entry =
+        get_piece_orientation(p->kind, p->orientation);
+    const piece_masks *masks =
+        get_piece_masks(p->kind, p->orientation, p->x_shift);
+    const field_row full_row = (1u << kernels->width) - 1;
+    int y;
+    undo->first_row = p->y_decline + entry->min_y;
+    undo->num_of_rows = entry->max_y - entry->min_y + 1;
+    undo->num_of_cleared = 0;
+    for (y=0; y < undo->num_of_rows; y++) {
+        field_row row = field[undo->first_row + y];
+        undo->rows[y] = row;
+        /* only a row the piece is locked into can get completed */
+        row |= masks->rows[entry->min_y + y] >> side_wall_cells;
+        if (row == full_row)
+            undo->cleared[undo->num_of_cleared++] = undo->first_row + y;
+    }
+}
+
+int apply_placement_journaled(
+    const field_kernels *kernels, field_row *field, const placement *p,
+    placement_undo *undo
+)
+{
+    record_placement(kernels, field, p, undo);
+    return apply_placement(kernels, field, p);
+}
+
+void undo_placement(
+    const field_kernels *kernels, field_row *field, const placement_undo *undo
+)
+{
+    const field_row full_row = (1u << kernels->width) - 1;
+    int y, i;
+    if (undo->num_of_cleared) {
+        /* the row `y` had moved down by the number of the lines cleared
+        under it, so it's taken from there; the rows are put back top down,
+        every one is read before it's overwritten */
+        int under = undo->num_of_cleared, c = 0;
+        int bottom = undo->cleared[undo->num_of_cleared - 1];
+        for (y=0; y <= bottom; y++) {
+            if (y == undo->cleared[c]) {
+                field[y] = full_row;
+                c++;
+                under--;
+            } else {
+                field[y] = field[y + under];
+            }
+        }
+    }
+    for (i=0; i < undo->num_of_rows; i++)
+        field[undo->first_row + i] = undo->rows[i];
+}
@@ -0,0 +1,86 @@
+/* policy.c */
+
+#include "policy.h"
+
+static bool choose_by_search(
+    const player_policy *policy, const game *g, arena *a, placement *move
+)
+{
+    piece_kind pieces[max_search_policy_depth];
+    int depth = (policy->depth > 1 + g->num_of_previews) ?
+        1 + g->num_of_previews : policy->depth;
+    int i;
+    pieces[0] = g->piece.kind;
+    for (i=1; i < depth; i++)
+        pieces[i] = game_preview_kind(g, i - 1);
+    return search_best_placement(
+        game_kernels(g), g->field, pieces, depth, policy->weights, a, move
+    );
+}
+
+static bool choose_by_net(
+    const player_policy *policy, const game *g, arena *a, placement *move
+)
+{
+    return net_best_placement(
+        policy->net, game_kernels(g), g->field, g->piece.kind, a, move
+    );
+}
+
+static bool choose_by_rollouts(
+    const player_policy *policy, const game *g, arena *a, placement *move
+)
+{
+    size_t mark = arena_mark(a);
+    rollout_stats *stats =
+        arena_alloc(a, max_num_of_placements * sizeof(rollout_stats));
+    const rollout_stats *best = best_rollout_stats(
+        stats, evaluate_placements(g, policy->rollouts, stats)
+    );
+    if (best)
+        *move = best->move;
+    arena_release(a, mark);
+    return best != NULL;
+}
+
+void init_search_policy(
+    player_policy *policy, const heuristic_weights *weights, int depth
+)
+{
+    policy->name = "search";
+    policy->choose = choose_by_search;
+    policy->weights = weights;
+    policy->depth = (depth < 1) ? 1 :
+        (depth > max_search_policy_depth) ? max_search_policy_depth : depth;
+    policy->net = NULL;
+    policy->rollouts = NULL;
+}
+
+void init_net_policy(player_policy *policy, const board_net *net)
+{
+    policy->name = "net";
+    policy->choose = choose_by_net;
+    policy->weights = NULL;
+    policy->depth = 1;
+    policy->net = net;
+    policy->rollouts = NULL;
+}
+
+void init_rollout_policy(player_policy *policy, const rollout_config *config)
+{
+    policy->name = "rollout";
+    policy->choose = choose_by_rollouts;
+    policy->weights = config->weights;
+    policy->depth = 1;
+    policy->net = NULL;
+    policy->rollouts = config;
+}
+
+bool policy_move(const player_policy *policy, game *g, arena *a)
+{
+    placement move;
+    g->changes = 0;
+    if (!g->game_on || !policy->choose(policy, g, a, &move))
+        return false;
+    return game_place_piece(g, &move);
+}
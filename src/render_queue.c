@@ -0,0 +1,113 @@
+/* render_queue.c */
+
+#include "render_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* sleeps until the next frame starts; a frame drawn too slowly makes the
+next one start right away, the missed ones are skipped */
+static void wait_next_frame(struct timespec *frame_start, int interval)
+{
+    struct timespec now;
+    frame_start->tv_nsec += interval * 1000000L;
+    while (frame_start->tv_nsec >= 1000000000L) {
+        frame_start->tv_sec++;
+        frame_start->tv_nsec -= 1000000000L;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec > frame_start->tv_sec) ||
+        ((now.tv_sec == frame_start->tv_sec) &&
+        (now.tv_nsec > frame_start->tv_nsec)))
+    {
+        *frame_start = now;
+        return;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, frame_start, NULL);
+}
+
+/* draws the latest published state, if the last frame didn't */
+static void draw_published_state(render_queue *q)
+{
+    unsigned int published;
+    if (!(atomic_load_explicit(&q->published, memory_order_acquire) &
+        fresh_state))
+    {
+        return;
+    }
+    /* the drawn state is handed back to the producer */
+    published = atomic_exchange_explicit(
+        &q->published, q->front, memory_order_acq_rel
+    );
+    q->front = published & ~fresh_state;
+    q->draw(&q->states[q->front], q->ctx);
+    q->drawn = true;
+}
+
+static void *run_render_thread(void *arg)
+{
+    render_queue *q = arg;
+    struct timespec frame_start;
+    clock_gettime(CLOCK_MONOTONIC, &frame_start);
+    while (atomic_load_explicit(&q->running, memory_order_acquire)) {
+        draw_published_state(q);
+        if (q->animate && q->drawn)
+            q->animate(&q->states[q->front], q->ctx);
+        wait_next_frame(&frame_start, q->frame_interval);
+    }
+    /* the state posted before the stop */
+    draw_published_state(q);
+    return NULL;
+}
+
+void start_render_thread(
+    render_queue *q, render_callback draw, render_callback animate, void *ctx,
+    int frame_interval
+)
+{
+    atomic_init(&q->published, 0);
+    q->back = 1;
+    q->front = 2;
+    atomic_init(&q->running, true);
+    q->draw = draw;
+    q->animate = animate;
+    q->drawn = false;
+    q->ctx = ctx;
+    q->frame_interval = frame_interval;
+    if (pthread_create(&q->thread, NULL, run_render_thread, q) != 0) {
+        fprintf(
+            stderr, "%s:%d: the render thread can't be started\n",
+            __FILE__, __LINE__
+        );
+        exit(1);
+    }
+}
+
+void post_game_state(render_queue *q, const game *g)
+{
+    unsigned char changes = g->changes;
+    for (;;) {
+        unsigned int replaced;
+        q->states[q->back] = *g;
+        q->states[q->back].changes = changes;
+        replaced = atomic_exchange_explicit(
+            &q->published, q->back | fresh_state, memory_order_acq_rel
+        );
+        q->back = replaced & ~fresh_state;
+        /* a replaced state nobody took is the producer's again: if it had
+        changes the new one lacks, the state is published once more with
+        them (the 2nd time it replaces itself, so that's the last one) */
+        if (!(replaced & fresh_state) ||
+            !(q->states[q->back].changes & ~changes))
+        {
+            return;
+        }
+        changes |= q->states[q->back].changes;
+    }
+}
+
+void stop_render_thread(render_queue *q)
+{
+    atomic_store_explicit(&q->running, false, memory_order_release);
+    pthread_join(q->thread, NULL);
+}
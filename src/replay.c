@@ -0,0 +1,202 @@
+/* replay.c */
+
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum replay_layout {
+    /* the events and the keyframes the arrays start with, doubled when full */
+    initial_events_capacity = 1024,
+    initial_keyframes_capacity = 64
+};
+
+/* the header of a recording file; the events and then the keyframes follow
+it, both written as they are in memory */
+typedef struct tag_recording_header {
+    char magic[4];
+    /* `sizeof(game)` and `sizeof(keyframe)`, so the file of another build
+    isn't taken */
+    unsigned int game_size, keyframe_size;
+    unsigned int keyframe_interval;
+    unsigned int num_of_events, num_of_keyframes;
+    long long start_time;
+} recording_header;
+
+static const char recording_magic[4] = { 'T', 'R', 'P', '1' };
+
+static void *grow_array(void *array, unsigned int *capacity, size_t item_size)
+{
+    *capacity *= 2;
+    array = realloc(array, *capacity * item_size);
+    if (!array) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+    return array;
+}
+
+static void allocate_arrays(recording *r)
+{
+    r->events = malloc(r->events_capacity * sizeof(recorded_event));
+    r->keyframes = malloc(r->keyframes_capacity * sizeof(keyframe));
+    if (!r->events || !r->keyframes) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+}
+
+static void add_keyframe(recording *r)
+{
+    keyframe *k;
+    if (r->num_of_keyframes == r->keyframes_capacity) {
+        r->keyframes =
+            grow_array(r->keyframes, &r->keyframes_capacity, sizeof(keyframe));
+    }
+    k = &r->keyframes[r->num_of_keyframes++];
+    k->state = r->last_state;
+    k->first_event = r->num_of_events;
+}
+
+void init_recording(
+    recording *r, const game *g, long time, unsigned int keyframe_interval
+)
+{
+    r->start_time = time;
+    r->keyframe_interval =
+        keyframe_interval ? keyframe_interval : default_keyframe_interval;
+    r->num_of_events = 0;
+    r->events_capacity = initial_events_capacity;
+    r->num_of_keyframes = 0;
+    r->keyframes_capacity = initial_keyframes_capacity;
+    allocate_arrays(r);
+    r->last_state = *g;
+    add_keyframe(r);
+}
+
+void free_recording(recording *r)
+{
+    free(r->events);
+    free(r->keyframes);
+}
+
+void record_step(recording *r, const game_event *event, const game *g)
+{
+    long time = event->time - r->start_time;
+    recorded_event *e;
+    /* the keyframes of the time passed since the last event */
+    while (time >= (long)r->num_of_keyframes * r->keyframe_interval)
+        add_keyframe(r);
+    if (r->num_of_events == r->events_capacity) {
+        r->events = grow_array(
+            r->events, &r->events_capacity, sizeof(recorded_event)
+        );
+    }
+    e = &r->events[r->num_of_events++];
+    e->time = time;
+    e->kind = event->kind;
+    e->action = event->action;
+    r->last_state = *g;
+}
+
+void save_recording(const recording *r, const char *file_name)
+{
+    recording_header header;
+    FILE *f = fopen(file_name, "wb");
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, recording_magic, sizeof(recording_magic));
+    header.game_size = sizeof(game);
+    header.keyframe_size = sizeof(keyframe);
+    header.keyframe_interval = r->keyframe_interval;
+    header.num_of_events = r->num_of_events;
+    header.num_of_keyframes = r->num_of_keyframes;
+    header.start_time = r->start_time;
+    if (!f ||
+        (fwrite(&header, sizeof(header), 1, f) != 1) ||
+        (fwrite(r->events, sizeof(recorded_event), r->num_of_events, f) !=
+            r->num_of_events) ||
+        (fwrite(r->keyframes, sizeof(keyframe), r->num_of_keyframes, f) !=
+            r->num_of_keyframes) ||
+        (fclose(f) != 0))
+    {
+        perror(file_name);
+        exit(1);
+    }
+}
+
+static void recording_error(const char *file_name, const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", file_name, msg);
+    exit(1);
+}
+
+void load_recording(recording *r, const char *file_name)
+{
+    recording_header header;
+    FILE *f = fopen(file_name, "rb");
+    if (!f) {
+        perror(file_name);
+        exit(1);
+    }
+    if ((fread(&header, sizeof(header), 1, f) != 1) ||
+        (memcmp(header.magic, recording_magic, sizeof(recording_magic)) != 0))
+    {
+        recording_error(file_name, "not a recording");
+    }
+    if ((header.game_size != sizeof(game)) ||
+        (header.keyframe_size != sizeof(keyframe)) ||
+        (header.num_of_keyframes == 0) || (header.keyframe_interval == 0))
+    {
+        recording_error(file_name, "the recording of another build");
+    }
+    r->start_time = header.start_time;
+    r->keyframe_interval = header.keyframe_interval;
+    r->num_of_events = header.num_of_events;
+    r->events_capacity = header.num_of_events ? header.num_of_events : 1;
+    r->num_of_keyframes = header.num_of_keyframes;
+    r->keyframes_capacity = header.num_of_keyframes;
+    allocate_arrays(r);
+    if ((fread(r->events, sizeof(recorded_event), r->num_of_events, f) !=
+            r->num_of_events) ||
+        (fread(r->keyframes, sizeof(keyframe), r->num_of_keyframes, f) !=
+            r->num_of_keyframes))
+    {
+        recording_error(file_name, "the recording is cut short");
+    }
+    fclose(f);
+    /* recording can go on from the end */
+    seek_recording(r, recording_duration(r), &r->last_state);
+}
+
+long recording_duration(const recording *r)
+{
+    return r->num_of_events ? r->events[r->num_of_events - 1].time : 0;
+}
+
+unsigned int seek_recording(const recording *r, long time, game *g)
+{
+    unsigned int k, i;
+    if (time < 0)
+        time = 0;
+    k = time / r->keyframe_interval;
+    if (k >= r->num_of_keyframes)
+        k = r->num_of_keyframes - 1;
+    *g = r->keyframes[k].state;
+    for (
+        i = r->keyframes[k].first_event;
+        (i < r->num_of_events) && (r->events[i].time <= time);
+        i++
+    )
+    {
+        game_event event = {
+            r->events[i].kind, r->events[i].action,
+            r->start_time + r->events[i].time
+        };
+        game_step(g, &event);
+    }
+    return i;
+}
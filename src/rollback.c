@@ -0,0 +1,113 @@
+/* rollback.c */
+
+#include "rollback.h"
+
+/* every flag a redraw of the whole board needs */
+enum {
+    board_redrawn = piece_changed | field_changed | score_changed |
+        level_changed | next_piece_changed
+};
+
+void init_rollback_session(
+    rollback_session *s, field_size size, unsigned int seed
+)
+{
+    int p;
+    init_versus_match(&s->match, size, seed);
+    for (p=0; p < num_of_versus_players; p++)
+        s->confirmed[p] = 0;
+    s->rollback_from = 0;
+    s->rollback_due = false;
+    s->rollbacks = 0;
+    s->resimulated_frames = 0;
+    s->max_rollback_depth = 0;
+}
+
+static unsigned int min_confirmed(const rollback_session *s)
+{
+    return (s->confirmed[0] < s->confirmed[1]) ?
+        s->confirmed[0] : s->confirmed[1];
+}
+
+game_action rollback_input(
+    const rollback_session *s, int player, unsigned int frame
+)
+{
+    if (frame >= s->confirmed[player])
+        return no_action;
+    return s->inputs[frame % rollback_input_frames][player];
+}
+
+bool set_rollback_input(
+    rollback_session *s, int player, unsigned int frame, game_action action
+)
+{
+    /* the slot taken mustn't hold an input a rollback may need */
+    if ((frame != s->confirmed[player]) ||
+        (frame >= min_confirmed(s) + rollback_input_frames))
+    {
+        return false;
+    }
+    s->inputs[frame % rollback_input_frames][player] = action;
+    s->confirmed[player]++;
+    /* the frame was simulated with no action predicted */
+    if ((frame < s->match.frame) && (action != no_action) &&
+        (!s->rollback_due || (frame < s->rollback_from)))
+    {
+        s->rollback_from = frame;
+        s->rollback_due = true;
+    }
+    return true;
+}
+
+static void simulate_frame(rollback_session *s)
+{
+    unsigned int frame = s->match.frame;
+    game_action inputs[num_of_versus_players];
+    int p;
+    s->snapshots[frame % max_rollback_frames] = s->match;
+    for (p=0; p < num_of_versus_players; p++)
+        inputs[p] = rollback_input(s, p, frame);
+    versus_frame(&s->match, inputs);
+}
+
+static void roll_back(rollback_session *s)
+{
+    unsigned int frame = s->match.frame,
+        depth = frame - s->rollback_from;
+    unsigned char changes[num_of_versus_players];
+    int p;
+    for (p=0; p < num_of_versus_players; p++)
+        changes[p] = s->match.changes[p];
+    s->match = s->snapshots[s->rollback_from % max_rollback_frames];
+    while (s->match.frame < frame)
+        simulate_frame(s);
+    for (p=0; p < num_of_versus_players; p++)
+        s->match.changes[p] |= changes[p] | board_redrawn;
+    s->rollback_due = false;
+    s->rollbacks++;
+    s->resimulated_frames += depth;
+    if (depth > s->max_rollback_depth)
+        s->max_rollback_depth = depth;
+}
+
+bool advance_rollback(rollback_session *s)
+{
+    if (s->rollback_due)
+        roll_back(s);
+    if (s->match.frame >= min_confirmed(s) + max_rollback_frames)
+        return false;
+    simulate_frame(s);
+    return true;
+}
+
+versus_result rollback_outcome(const rollback_session *s)
+{
+    unsigned int frame = min_confirmed(s);
+    if (s->rollback_due)
+        return match_goes_on;
+    /* the match after the confirmed frames */
+    if (frame < s->match.frame)
+        return versus_outcome(&s->snapshots[frame % max_rollback_frames]);
+    return versus_outcome(&s->match);
+}
@@ -0,0 +1,201 @@
+/* rollout.c */
+
+#include "rollout.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum rollout_defaults {
+    default_rollout_depth = 10,
+    default_rollout_budget_ms = 100
+};
+
+/* the sums one thread gathers for one placement */
+typedef struct tag_rollout_sums {
+    long n;
+    double sum, sum_of_squares;
+} rollout_sums;
+
+typedef struct tag_rollout_worker {
+    pthread_t thread;
+    int id;
+    const game *g;
+    const rollout_config *config;
+    const placement *placements;
+    int num_of_placements;
+    /* the time the rollouts stop at, in nanoseconds */
+    double deadline;
+    /* the state of the thread's own random stream */
+    unsigned long long rng_state;
+    rollout_sums sums[max_num_of_placements];
+} rollout_worker;
+
+static double current_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static unsigned int next_stream_random(unsigned long long *state)
+{
+    /* splitmix64: every seed gives an independent stream */
+    unsigned long long z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+void init_rollout_config(rollout_config *config)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    config->num_of_threads = (cpus < 1) ? 1 :
+        (cpus > max_rollout_threads) ? max_rollout_threads : cpus;
+    config->depth = default_rollout_depth;
+    config->budget_ms = default_rollout_budget_ms;
+    config->max_rollouts = 0;
+    config->seed = 1;
+    config->weights = default_heuristic_weights();
+}
+
+static double rollout(rollout_worker *w, const placement *move, arena *a)
+{
+    game g = *w->g;
+    int score = g.score, i;
+    /* the pieces after the previewed ones are unknown: the one the spawn
+    after this placement puts into the preview is drawn from the rollout's
+    own stream too, not the game's */
+    g.rng_state = next_stream_random(&w->rng_state) | 1;
+    game_place_piece(&g, move);
+    for (i=0; (i < w->config->depth) && g.game_on; i++) {
+        piece_kind kind = g.piece.kind;
+        placement best;
+        reset_arena(a);
+        if (!search_best_placement(
+                game_kernels(&g), g.field, &kind, 1, w->config->weights, a,
+                &best
+            ))
+            break;
+        game_place_piece(&g, &best);
+    }
+    return g.score - score;
+}
+
+static bool rollouts_are_over(const rollout_worker *w, long rounds)
+{
+    long limit = w->config->max_rollouts;
+    if (w->config->budget_ms && (current_time_ns() >= w->deadline))
+        return true;
+    /* the threads share the rollouts limit evenly, the 1st ones take the
+    remainder */
+    if (limit) {
+        long share = limit / w->config->num_of_threads +
+            (w->id < limit % w->config->num_of_threads);
+        return rounds >= share;
+    }
+    /* no limits at all - a single round */
+    return !w->config->budget_ms;
+}
+
+static void *run_rollout_worker(void *arg)
+{
+    rollout_worker *w = arg;
+    arena *a = get_thread_arena();
+    long rounds = 0;
+    int i;
+    memset(w->sums, 0, sizeof(w->sums));
+    do {
+        /* one rollout per placement a round, so every placement gets the
+        same number of them */
+        for (i=0; i < w->num_of_placements; i++) {
+            double reward = rollout(w, &w->placements[i], a);
+            w->sums[i].n++;
+            w->sums[i].sum += reward;
+            w->sums[i].sum_of_squares += reward * reward;
+        }
+        rounds++;
+    } while (!rollouts_are_over(w, rounds));
+    free_thread_arena();
+    return NULL;
+}
+
+static void sum_up(
+    const rollout_worker *workers, int num_of_threads,
+    const placement *placements, int num_of_placements, rollout_stats *stats
+)
+{
+    int i, t;
+    for (i=0; i < num_of_placements; i++) {
+        rollout_sums total = { 0, 0, 0 };
+        for (t=0; t < num_of_threads; t++) {
+            total.n += workers[t].sums[i].n;
+            total.sum += workers[t].sums[i].sum;
+            total.sum_of_squares += workers[t].sums[i].sum_of_squares;
+        }
+        stats[i].move = placements[i];
+        stats[i].num_of_rollouts = total.n;
+        stats[i].mean = (total.n) ? total.sum / total.n : 0;
+        stats[i].variance = (total.n > 1) ?
+            (total.sum_of_squares - total.sum * stats[i].mean) /
+            (total.n - 1) : 0;
+    }
+}
+
+int evaluate_placements(
+    const game *g, const rollout_config *config, rollout_stats *stats
+)
+{
+    rollout_worker *workers;
+    arena *a = get_thread_arena();
+    size_t mark = arena_mark(a);
+    placement *placements;
+    int num_of_placements, num_of_threads, t;
+    double deadline = current_time_ns() + config->budget_ms * 1e6;
+    if (!g->game_on)
+        return 0;
+    placements = enumerate_placements(
+        game_kernels(g), g->field, g->piece.kind, a, &num_of_placements
+    );
+    num_of_threads = config->num_of_threads;
+    if (num_of_threads < 1)
+        num_of_threads = 1;
+    if (num_of_threads > max_rollout_threads)
+        num_of_threads = max_rollout_threads;
+    workers = arena_alloc(a, num_of_threads * sizeof(rollout_worker));
+    for (t=0; t < num_of_threads; t++) {
+        rollout_worker *w = &workers[t];
+        w->id = t;
+        w->g = g;
+        w->config = config;
+        w->placements = placements;
+        w->num_of_placements = num_of_placements;
+        w->deadline = deadline;
+        w->rng_state = ((unsigned long long)config->seed << 32) | t;
+        if (pthread_create(&w->thread, NULL, run_rollout_worker, w) != 0) {
+            fprintf(
+                stderr, "%s:%d: a rollout thread can't be started\n",
+                __FILE__, __LINE__
+            );
+            exit(1);
+        }
+    }
+    for (t=0; t < num_of_threads; t++)
+        pthread_join(workers[t].thread, NULL);
+    sum_up(workers, num_of_threads, placements, num_of_placements, stats);
+    arena_release(a, mark);
+    return num_of_placements;
+}
+
+const rollout_stats *best_rollout_stats(const rollout_stats *stats, int n)
+{
+    const rollout_stats *best = NULL;
+    int i;
+    for (i=0; i < n; i++) {
+        if (!best || (stats[i].mean > best->mean))
+            best = &stats[i];
+    }
+    return best;
+}
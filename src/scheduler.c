@@ -0,0 +1,188 @@
+/* scheduler.c */
+
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void *allocate(size_t size)
+{
+    /* the game records are aligned to the cache lines */
+    void *ptr = aligned_alloc(
+        cache_line_size,
+        (size + cache_line_size - 1) / cache_line_size * cache_line_size
+    );
+    if (!ptr) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+    return ptr;
+}
+
+static long deadline_at(const scheduler *s, int heap_index)
+{
+    return s->games[s->deadline_heap[heap_index]].gravity_deadline;
+}
+
+static void heap_swap(scheduler *s, int i, int j)
+{
+    int id = s->deadline_heap[i];
+    s->deadline_heap[i] = s->deadline_heap[j];
+    s->deadline_heap[j] = id;
+    s->slots[s->deadline_heap[i]].heap_index = i;
+    s->slots[s->deadline_heap[j]].heap_index = j;
+}
+
+static void sift_up(scheduler *s, int i)
+{
+    while ((i > 0) && (deadline_at(s, (i-1) / 2) > deadline_at(s, i))) {
+        heap_swap(s, i, (i-1) / 2);
+        i = (i-1) / 2;
+    }
+}
+
+static void sift_down(scheduler *s, int i)
+{
+    for (;;) {
+        int smallest = i, left = 2*i + 1, right = 2*i + 2;
+        if ((left < s->heap_size) &&
+            (deadline_at(s, left) < deadline_at(s, smallest)))
+        {
+            smallest = left;
+        }
+        if ((right < s->heap_size) &&
+            (deadline_at(s, right) < deadline_at(s, smallest)))
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+            return;
+        heap_swap(s, i, smallest);
+        i = smallest;
+    }
+}
+
+static void heap_remove(scheduler *s, int game_id)
+{
+    int i = s->slots[game_id].heap_index;
+    s->heap_size--;
+    if (i != s->heap_size) {
+        heap_swap(s, i, s->heap_size);
+        sift_up(s, i);
+        sift_down(s, i);
+    }
+    s->slots[game_id].heap_index = -1;
+}
+
+void init_scheduler(
+    scheduler *s, int num_of_games, field_size size, unsigned int seed,
+    long time
+)
+{
+    int i;
+    s->games = allocate(num_of_games * sizeof(game));
+    s->slots = allocate(num_of_games * sizeof(game_slot));
+    s->deadline_heap = allocate(num_of_games * sizeof(int));
+    s->woken_games = allocate(num_of_games * sizeof(int));
+    s->num_of_games = num_of_games;
+    s->heap_size = 0;
+    s->num_of_woken = 0;
+    for (i=0; i < num_of_games; i++) {
+        game_slot *slot = &s->slots[i];
+        /* a distinct seed per game (the golden ratio increment) */
+        init_game(&s->games[i], size, seed + i * 0x9e3779b9u, time);
+        slot->first_pending = 0;
+        slot->num_of_pending = 0;
+        slot->woken = false;
+        slot->heap_index = s->heap_size;
+        s->deadline_heap[s->heap_size++] = i;
+        sift_up(s, slot->heap_index);
+    }
+}
+
+void free_scheduler(scheduler *s)
+{
+    free(s->games);
+    free(s->slots);
+    free(s->deadline_heap);
+    free(s->woken_games);
+}
+
+bool post_action(scheduler *s, int game_id, game_action action)
+{
+    game_slot *slot = &s->slots[game_id];
+    if (!s->games[game_id].game_on ||
+        (slot->num_of_pending == max_pending_actions))
+    {
+        return false;
+    }
+    slot->pending[
+        (slot->first_pending + slot->num_of_pending) % max_pending_actions
+    ] = action;
+    slot->num_of_pending++;
+    if (!slot->woken) {
+        slot->woken = true;
+        s->woken_games[s->num_of_woken++] = game_id;
+    }
+    return true;
+}
+
+static void step_(
+    scheduler *s, int game_id, const game_event *event,
+    step_callback on_step, void *ctx
+)
+{
+    game_slot *slot = &s->slots[game_id];
+    game_step(&s->games[game_id], event);
+    if (on_step)
+        on_step(game_id, &s->games[game_id], ctx);
+    if (!s->games[game_id].game_on) {
+        slot->num_of_pending = 0;
+        if (slot->heap_index >= 0)
+            heap_remove(s, game_id);
+    } else {
+        /* the step may have moved the gravity deadline either way */
+        sift_up(s, slot->heap_index);
+        sift_down(s, slot->heap_index);
+    }
+}
+
+static int process_woken_games(
+    scheduler *s, long now, step_callback on_step, void *ctx
+)
+{
+    int i, steps = 0;
+    game_event event = { input_event, no_action, now };
+    for (i=0; i < s->num_of_woken; i++) {
+        int game_id = s->woken_games[i];
+        game_slot *slot = &s->slots[game_id];
+        while (slot->num_of_pending > 0) {
+            event.action = slot->pending[slot->first_pending];
+            slot->first_pending =
+                (slot->first_pending + 1) % max_pending_actions;
+            slot->num_of_pending--;
+            step_(s, game_id, &event, on_step, ctx);
+            steps++;
+        }
+        slot->woken = false;
+    }
+    s->num_of_woken = 0;
+    return steps;
+}
+
+int run_scheduler(scheduler *s, long now, step_callback on_step, void *ctx)
+{
+    int steps = process_woken_games(s, now, on_step, ctx);
+    game_event event = { gravity_event, no_action, now };
+    while ((s->heap_size > 0) && (deadline_at(s, 0) <= now)) {
+        step_(s, s->deadline_heap[0], &event, on_step, ctx);
+        steps++;
+    }
+    return steps;
+}
+
+long next_deadline(const scheduler *s)
+{
+    return (s->heap_size > 0) ? deadline_at(s, 0) : -1;
+}
@@ -0,0 +1,110 @@
+/* screen.c */
+
+#include "screen.h"
+#include "constants.h"
+#include "screen_backend.h"
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+enum screen_consts {
+    /* the time to wait for the rest of an escape sequence in milliseconds */
+    escape_sequence_delay = 50
+};
+
+static const screen_backend *backend = NULL;
+
+void screen_init(screen_backend_kind kind)
+{
+    switch (kind) {
+        case ncurses_screen:
+            backend = get_ncurses_screen_backend();
+            break;
+        case ansi_screen:
+            backend = get_ansi_screen_backend();
+            break;
+        default:
+            fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
+            exit(1);
+    }
+    backend->init();
+}
+
+void screen_end()
+{
+    backend->end();
+}
+
+void screen_size(int *row, int *col)
+{
+    backend->size(row, col);
+}
+
+void screen_put_str(int y, int x, const char *str)
+{
+    backend->put_str(y, x, str);
+}
+
+void screen_clear()
+{
+    backend->clear();
+}
+
+void screen_flush()
+{
+    backend->flush();
+}
+
+int screen_get_key(int delay)
+{
+    return backend->get_key(delay);
+}
+
+int screen_read_key(int delay)
+{
+    return backend->read_key(delay);
+}
+
+static bool key_is_waiting(int delay)
+{
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    return (poll(&pfd, 1, delay) > 0);
+}
+
+static int read_char()
+{
+    unsigned char c;
+    return (read(STDIN_FILENO, &c, 1) == 1) ? c : no_key;
+}
+
+static int escape_sequence_key()
+{
+    int c;
+    if (!key_is_waiting(escape_sequence_delay))
+        return key_esc;
+    c = read_char();
+    if ((c != '[') && (c != 'O'))
+        return c;
+    switch (c = read_char()) {
+        case 'A':
+            return key_up;
+        case 'B':
+            return key_down;
+        case 'C':
+            return key_right;
+        case 'D':
+            return key_left;
+        default:
+            return c;
+    }
+}
+
+int read_terminal_key(int delay)
+{
+    int c;
+    if (!key_is_waiting(delay))
+        return no_key;
+    c = read_char();
+    return (c == key_esc) ? escape_sequence_key() : c;
+}
@@ -0,0 +1,208 @@
+/* search.c */
+
+#include "search.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const heuristic_weights default_weights = {
+    .aggregate_height = -0.510066,
+    .completed_lines = 0.760666,
+    .holes = -0.35663,
+    .bumpiness = -0.184483
+};
+
+const heuristic_weights *default_heuristic_weights()
+{
+    return &default_weights;
+}
+
+/* the names the weights are stored by */
+static const struct {
+    const char *name;
+    size_t offset;
+} weight_names[] = {
+    { "aggregate_height", offsetof(heuristic_weights, aggregate_height) },
+    { "completed_lines", offsetof(heuristic_weights, completed_lines) },
+    { "holes", offsetof(heuristic_weights, holes) },
+    { "bumpiness", offsetof(heuristic_weights, bumpiness) }
+};
+
+enum { num_of_weights = sizeof(weight_names) / sizeof(weight_names[0]) };
+
+static double *weight_at(heuristic_weights *weights, int i)
+{
+    return (double *)((char *)weights + weight_names[i].offset);
+}
+
+void save_heuristic_weights(
+    const char *file_name, const heuristic_weights *weights
+)
+{
+    heuristic_weights w = *weights;
+    FILE *f = fopen(file_name, "w");
+    int i;
+    if (!f) {
+        perror(file_name);
+        exit(1);
+    }
+    for (i=0; i < num_of_weights; i++)
+        fprintf(f, "%s %.9g\n", weight_names[i].name, *weight_at(&w, i));
+    if (fclose(f) != 0) {
+        perror(file_name);
+        exit(1);
+    }
+}
+
+static void weights_file_error(const char *file_name, const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", file_name, msg);
+    exit(1);
+}
+
+void load_heuristic_weights(const char *file_name, heuristic_weights *weights)
+{
+    char name[32];
+    double value;
+    bool found[num_of_weights] = { false };
+    int i;
+    FILE *f = fopen(file_name, "r");
+    if (!f) {
+        perror(file_name);
+        exit(1);
+    }
+    while (fscanf(f, "%31s %lf", name, &value) == 2) {
+        for (i=0; i < num_of_weights; i++) {
+            if (strcmp(name, weight_names[i].name) == 0)
+                break;
+        }
+        if (i == num_of_weights)
+            weights_file_error(file_name, "unknown weight");
+        *weight_at(weights, i) = value;
+        found[i] = true;
+    }
+    if (!feof(f))
+        weights_file_error(file_name, "not a weights file");
+    fclose(f);
+    for (i=0; i < num_of_weights; i++) {
+        if (!found[i])
+            weights_file_error(file_name, "a weight is missing");
+    }
+}
+
+void measure_field(
+    const field_kernels *kernels, const field_row *field,
+    field_profile *profile
+)
+{
+    const unsigned int cells_mask = (1u << kernels->width) - 1;
+    int y, x;
+    /* the columns having an occupied cell above the current row */
+    unsigned int covered = 0;
+    for (x=0; x < max_field_width; x++) {
+        profile->heights[x] = 0;
+        profile->column_holes[x] = 0;
+    }
+    profile->holes = 0;
+    for (y=0; y < kernels->height; y++) {
+        unsigned int cells = field[y];
+        unsigned int tops = cells & ~covered;
+        unsigned int holes = ~cells & covered & cells_mask;
+        covered |= cells;
+        while (tops) {
+            profile->heights[__builtin_ctz(tops)] = kernels->height - y;
+            tops &= tops - 1;
+        }
+        profile->holes += __builtin_popcount(holes);
+        while (holes) {
+            profile->column_holes[__builtin_ctz(holes)]++;
+            holes &= holes - 1;
+        }
+    }
+    profile->aggregate_height = profile->max_height = profile->bumpiness = 0;
+    for (x=0; x < kernels->width; x++) {
+        profile->aggregate_height += profile->heights[x];
+        if (profile->heights[x] > profile->max_height)
+            profile->max_height = profile->heights[x];
+        if (x > 0) {
+            profile->bumpiness +=
+                abs(profile->heights[x] - profile->heights[x-1]);
+        }
+    }
+}
+
+double evaluate_field(
+    const field_kernels *kernels, const field_row *field,
+    int completed_lines, const heuristic_weights *weights
+)
+{
+    field_profile profile;
+    measure_field(kernels, field, &profile);
+    return
+        weights->aggregate_height * profile.aggregate_height +
+        weights->completed_lines * completed_lines +
+        weights->holes * profile.holes +
+        weights->bumpiness * profile.bumpiness;
+}
+
+static double search_(
+    const field_kernels *kernels, field_row *field,
+    const piece_kind *pieces, int depth, int completed_lines,
+    const heuristic_weights *weights, arena *a, placement *best, bool *found
+)
+{
+    size_t mark = arena_mark(a);
+    double best_value = -INFINITY;
+    int num_of_placements, i;
+    placement *placements = enumerate_placements(
+        kernels, field, pieces[0], a, &num_of_placements
+    );
+    search_node *node = arena_alloc(a, sizeof(search_node));
+    for (i=0; i < num_of_placements; i++) {
+        node->move = placements[i];
+        node->field = field;
+        node->completed_lines = completed_lines + apply_placement_journaled(
+            kernels, node->field, &node->move, &node->undo
+        );
+        if (depth > 1) {
+            node->value = search_(
+                kernels, node->field, pieces + 1, depth - 1,
+                node->completed_lines, weights, a, NULL, NULL
+            );
+        } else {
+            node->value = evaluate_field(
+                kernels, node->field, node->completed_lines, weights
+            );
+        }
+        undo_placement(kernels, node->field, &node->undo);
+        /* the 1st placement is taken even if every one of them ends the game
+        deeper in the search */
+        if ((node->value > best_value) || (i == 0)) {
+            best_value = node->value;
+            if (best)
+                *best = node->move;
+        }
+    }
+    if (found)
+        *found = (num_of_placements > 0);
+    arena_release(a, mark);
+    return best_value;
+}
+
+bool search_best_placement(
+    const field_kernels *kernels, const field_row *field,
+    const piece_kind *pieces, int num_of_known_pieces,
+    const heuristic_weights *weights, arena *a, placement *best
+)
+{
+    size_t mark = arena_mark(a);
+    bool found;
+    search_(
+        kernels, snapshot_field(kernels, field, a), pieces,
+        num_of_known_pieces, 0, weights, a, best, &found
+    );
+    arena_release(a, mark);
+    return found;
+}
@@ -1,47 +1,72 @@
 /* tetris.c */
 
-#include "conflict_resolution.h"
+#include "bot_link.h"
 #include "constants.h"
+#include "field.h"
+#include "finesse.h"
 #include "frontend.h"
-#include "rotation.h"
-#include <ncurses.h>
+#include "game.h"
+#include "key_repeat.h"
+#include "policy.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "rollback.h"
+#include "screen.h"
+#include "versus.h"
+#include "versus_link.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
 #include <time.h>
-#include <unistd.h>
 
 typedef enum tag_piece_action {
     hide_piece, print_piece, hide_ghost, print_ghost
 } piece_action;
 
 typedef enum tag_type_of_cell {
-    empty, occupied, ghost
+    empty, occupied, ghost, cleared
 } type_of_cell;
 
 typedef enum tag_boundary_side {
     bottom, top, left_side, right_side
 } boundary_side;
 
-void time_start(struct timeval *tv1, struct timezone *tz)
+/* what the screen shows, the render thread's own copy: the pieces and the
+field cells, so only the cells which change are drawn */
+typedef struct tag_shown_state {
+    struct_piece piece;
+    /* the kinds of the previewed pieces, `num_of_pieces` in an empty slot */
+    unsigned char previews[max_preview_pieces];
+    field_row field[max_field_height];
+    /* cleared until the whole field with its boundaries is drawn */
+    bool field_shown;
+    /* whether the line clears are animated (a render thread draws the
+    frames between the states) */
+    bool animated;
+    /* the line clear being shown: the field is shown as it was before the
+    clear, the cleared lines emptying from the middle outwards, while the
+    game goes on */
+    bool clearing;
+    long clear_started;
+    int clear_top, clear_lines;
+    /* the columns of the cleared lines on either side of the middle which
+    are shown empty */
+    int wiped_columns;
+} shown_state;
+
+/* the recording of the game, if it's recorded */
+static recording *game_recording = NULL;
+
+/* a versus match shows two boards side by side, every board is drawn shifted
+from the centered one by `board_shift` columns */
+static bool two_boards_shown = false;
+static int board_shift = 0;
+
+long current_time()
 {
-    gettimeofday(tv1, tz);
-}
-
-int time_stop(
-    const struct timeval *tv1, struct timeval *tv2, struct timezone *tz
-)
-{
-    struct timeval dtv;
-    gettimeofday(tv2, tz);
-    dtv.tv_sec = tv2->tv_sec - tv1->tv_sec;
-    dtv.tv_usec = tv2->tv_usec - tv1->tv_usec;
-    /* in case time difference was less than a second: */
-    if (dtv.tv_usec < 0) {
-        dtv.tv_sec--;
-        dtv.tv_usec += 1000000;
-    }
-    return dtv.tv_sec*1000 + dtv.tv_usec/1000;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000 + ts.tv_nsec/1000000;
 }
 
 int get_init_x()
@@ -50,10 +75,10 @@ int get_init_x()
     if (init_x < 0) {
         int row, col;
         (void)row;
-        getmaxyx(stdscr, row, col);
+        screen_size(&row, &col);
         init_x = (col - field_width * cell_width) / 2;
     }
-    return init_x;
+    return init_x + board_shift;
 }
 
 int get_init_y()
@@ -62,7 +87,7 @@ int get_init_y()
     if (init_y < 0) {
         int row, col;
         (void)col;
-        getmaxyx(stdscr, row, col);
+        screen_size(&row, &col);
         init_y = row - field_height * cell_height - 1;
     }
     return init_y;
@@ -72,16 +97,18 @@ void print_cell_(type_of_cell type, int x, int y)
 {
     int i;
     for (i=0; i < cell_height; i++, y++) {
-        move(y, x);
         switch (type) {
             case empty:
-                addstr(EMPTY_CELL_ROW);
+                screen_put_str(y, x, EMPTY_CELL_ROW);
                 break;
             case occupied:
-                addstr(OCCUPIED_CELL_ROW);
+                screen_put_str(y, x, OCCUPIED_CELL_ROW);
                 break;
             case ghost:
-                addstr(GHOST_CELL_ROW);
+                screen_put_str(y, x, GHOST_CELL_ROW);
+                break;
+            case cleared:
+                screen_put_str(y, x, CLEARED_CELL_ROW);
                 break;
             default:
                 fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
@@ -90,20 +117,18 @@ void print_cell_(type_of_cell type, int x, int y)
     }
 }
 
-void print_bottom_top_boundary()
+void print_bottom_top_boundary(int x, int y)
 {
     int i;
-    for (i=0; i < field_width*cell_width + 2*side_boundary_width; i++)
-        addstr(BOTTOM_TOP_BOUNDARY);
+    for (i=0; i < field_width*cell_width + 2*side_boundary_width; i++, x++)
+        screen_put_str(y, x, BOTTOM_TOP_BOUNDARY);
 }
 
 void print_side_boundary(int x, int y)
 {
     int i;
-    for (i=0; i < cell_height; i++, y++) {
-        move(y, x);
-        addstr(SIDE_BOUNDARY);
-    }
+    for (i=0; i < cell_height; i++, y++)
+        screen_put_str(y, x, SIDE_BOUNDARY);
 }
 
 void print_field_boundary(
@@ -112,12 +137,12 @@ void print_field_boundary(
 {
     switch (side) {
         case top:
-            move(get_init_y()-1, get_init_x()-1);
-            print_bottom_top_boundary();
+            print_bottom_top_boundary(get_init_x()-1, get_init_y()-1);
             break;
         case bottom:
-            move(get_init_y()+field_height*cell_height, get_init_x()-1);
-            print_bottom_top_boundary();
+            print_bottom_top_boundary(
+                get_init_x()-1, get_init_y()+field_height*cell_height
+            );
             break;
         case left_side:
             print_side_boundary(*screen_x, *screen_y);
@@ -137,7 +162,7 @@ int init_screen_x()
     return get_init_x() - side_boundary_width;
 }
 
-void print_field(const bool (*field)[field_width])
+void print_field(const field_row *field)
 {
     int field_x, field_y, screen_x, screen_y;
     print_field_boundary(top, NULL, NULL);
@@ -149,18 +174,37 @@ void print_field(const bool (*field)[field_width])
     {
         print_field_boundary(left_side, &screen_x, &screen_y);
         for (field_x=0; field_x < field_width; field_x++) {
-            if (field[field_y][field_x] == 0)
+            if (!field_cell_is_occupied(field, field_x, field_y))
                 print_cell_(empty, screen_x, screen_y);
             else
                 print_cell_(occupied, screen_x, screen_y);
             screen_x += cell_width;
-            move(screen_y, screen_x);
         }
         print_field_boundary(right_side, &screen_x, &screen_y);
     }
     print_field_boundary(bottom, NULL, NULL);
-    curs_set(0);
-    refresh();
+}
+
+/* draws only the field cells which differ from the shown ones: a garbage
+burst or a line clear moves every row, but most of the cells stay as they
+were */
+void print_field_changes(const field_row *field, field_row *shown_field)
+{
+    int field_x, field_y;
+    for (field_y=0; field_y < field_height; field_y++) {
+        field_row changed = field[field_y] ^ shown_field[field_y];
+        for (field_x=0; changed; field_x++, changed >>= 1) {
+            if (!(changed & 1))
+                continue;
+            print_cell_(
+                field_cell_is_occupied(field, field_x, field_y) ?
+                occupied : empty,
+                get_init_x() + field_x * cell_width,
+                get_init_y() + field_y * cell_height
+            );
+        }
+        shown_field[field_y] = field[field_y];
+    }
 }
 
 void take_(piece_action action, int x, int y)
@@ -206,7 +250,7 @@ void piece_(piece_action action, const struct_piece *piece)
     for (y=0; y < piece->size; y++) {
         for (x=0; x < piece->size; x++) {
             if (matrix[y][x] == 1) {
-                if (action == hide_ghost)
+                if ((action == hide_ghost) || (action == print_ghost))
                     take_(action, curr_x(piece, x), ghost_y(piece, y));
                 else
                     take_(action, curr_x(piece, x), curr_y(piece, y));
@@ -215,699 +259,994 @@ void piece_(piece_action action, const struct_piece *piece)
     }
 }
 
-void truncate_piece(struct_piece *piece)
+int game_info_y(int y)
 {
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    bool (*matrix)[piece->size] = piece->form.small;
-    int x, y;
-    /* checking if the piece's upmost row is empty */
-    while (true) {
-        for (y=0; y < piece->size; y++) {
-            for (x=0; x < piece->size; x++) {
-                if (matrix[y][x] == 1)
-                    return;
-            }
-            /* if so - correcting the initial piece's 'y' coordinate */
-            piece->y_decline--;
-        }
-    }
+    return get_init_y() + y * cell_height;
 }
 
-bool field_has_ended(const struct_piece *piece, int y)
+int game_info_x()
 {
-    return (y + piece->y_decline + 1 == field_height) ? true : false;
+    return get_init_x() + (field_width + game_info_gap) * cell_width;
 }
 
-bool lower_field_cell_is_occupied(
-    const bool (*field)[field_width], const struct_piece *piece, int x, int y
-)
+void print_labels()
 {
-    return (field_has_ended(piece, y) ||
-        field[y + piece->y_decline + 1][x + piece->x_shift] == 1);
+    screen_put_str(game_info_y(level_label_row), game_info_x(), "LEVEL");
+    screen_put_str(game_info_y(score_label_row), game_info_x(), "SCORE");
+    screen_put_str(
+        game_info_y(next_label_row)+cell_height-1, game_info_x(), "NEXT"
+    );
+    screen_flush();
 }
 
-bool piece_has_fallen(const bool (*field)[field_width], const struct_piece *piece)
+void print_game_info(int info, int position)
+{
+    char info_str[max_msg_str_size];
+    sprintf(info_str, "%d", info);
+    screen_put_str(game_info_y(position), game_info_x(), info_str);
+}
+
+/* the cells of a previewed piece in its spawn orientation as the bits of a
+`big_piece_size` square, row by row, its top row moved to the square's top */
+unsigned int preview_cells(int kind)
+{
+    struct_piece piece;
+    unsigned int cells = 0;
+    int x, y, top = -1;
+    if (kind == num_of_pieces)
+        return 0;
+    piece = game_piece_at(kind, horizontal_1, 0, 0);
+    const bool (*matrix)[piece.size] = piece.form.small;
+    for (y=0; y < piece.size; y++) {
+        for (x=0; x < piece.size; x++) {
+            if (!matrix[y][x])
+                continue;
+            if (top < 0)
+                top = y;
+            cells |= 1u << ((y - top) * big_piece_size + x);
+        }
+    }
+    return cells;
+}
+
+void print_preview_cells(type_of_cell type, unsigned int cells, int slot)
 {
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    const bool (*matrix)[piece->size] = piece->form.small;
     int x, y;
-    /* fall_checks: looking for every lowest cell in each column */
-    for (y=piece->size-1; y >= 0; y--) {
-        for (x=0; x < piece->size; x++) {
-            if (matrix[y][x] == 1) {
-                if (lower_field_cell_is_occupied(field, piece, x, y))
-                    return true;
-            }
+    for (y=0; y < big_piece_size; y++) {
+        for (x=0; x < big_piece_size; x++) {
+            if (!(cells & (1u << (y * big_piece_size + x))))
+                continue;
+            print_cell_(
+                type, game_info_x() + x * cell_width,
+                game_info_y(next_row) + slot * preview_slot_height +
+                    y * cell_height
+            );
         }
     }
-    return false;
 }
 
-void cast_ghost(
-    const bool (*field)[field_width], struct_piece piece,
-    signed char *ghost_decline
+/* a slot keeping its piece isn't drawn, a slot getting another one has only
+the cells the pieces don't share drawn */
+void show_preview(const game *g, unsigned char *shown)
+{
+    int slot;
+    for (slot=0; slot < max_preview_pieces; slot++) {
+        int kind = (slot < g->num_of_previews) ?
+            (int)game_preview_kind(g, slot) : num_of_pieces;
+        unsigned int shown_cells, cells;
+        if (kind == shown[slot])
+            continue;
+        shown_cells = preview_cells(shown[slot]);
+        cells = preview_cells(kind);
+        print_preview_cells(empty, shown_cells & ~cells, slot);
+        print_preview_cells(occupied, cells & ~shown_cells, slot);
+        shown[slot] = kind;
+    }
+}
+
+void print_centered_format_msg(
+    int *y, int col, const char *msg, int format_1, int format_2
 )
 {
-    while (!piece_has_fallen(field, &piece))
-        piece.y_decline++;
-    piece_(print_ghost, &piece);
-    *ghost_decline = piece.y_decline;
+    char assist_str[max_msg_str_size];
+    sprintf(assist_str, msg, format_1, format_2);
+    msg = assist_str;
+    int x = (col - strlen(msg)) / 2;
+    screen_put_str(*y, x, msg);
+    (*y)++;
 }
 
-void piece_spawn(const bool (*field)[field_width], struct_piece *piece)
+void print_score_message(int score)
 {
-    truncate_piece(piece);
-    cast_ghost(field, *piece, &piece->ghost_decline);
-    piece_(print_piece, piece);
-    curs_set(0);
-    refresh();
+    int row, col;
+    int y;
+    screen_size(&row, &col);
+    y = row / 2;
+    print_centered_format_msg(&y, col, FINAL_SCORE_MSG, score, 0);
 }
 
-void field_absorbes_piece(bool (*field)[field_width], const struct_piece *piece)
+void wait_until_esc_is_pressed_then_exit()
 {
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    const bool (*matrix)[piece->size] = piece->form.small;
-    int x, y;
-    /* `piece` cells become `field` cells */
-    for (y=0; y < piece->size; y++) {
-        for (x=0; x < piece->size; x++) {
-            if (matrix[y][x] == 1)
-                field[y + piece->y_decline][x + piece->x_shift] = 1;
-        }
-    }
+    while (screen_get_key(-1) != key_esc)
+        ;
+    screen_end();
+    exit(0);
 }
 
-void move_(
-    move_direction direction, const bool (*field)[field_width],
-    struct_piece *piece
-)
+void end_game(int score)
 {
-    int x_shift_backup = piece->x_shift;
-    piece_(hide_ghost, piece);
-    piece_(hide_piece, piece);
-    switch (direction) {
-        case left:
-            piece->x_shift--;
-            break;
-        case right:
-            piece->x_shift++;
-            break;
-        default:
-            fprintf(stderr, "%s:%d: incorrect value", __FILE__, __LINE__);
-            exit(1);
+    screen_clear();
+    print_score_message(score);
+    wait_until_esc_is_pressed_then_exit();
+}
+
+/* the columns one board takes with its game info */
+int board_width()
+{
+    return (field_width + game_info_gap + big_piece_size) * cell_width;
+}
+
+int min_screen_width()
+{
+    if (two_boards_shown) {
+        return
+            2 * board_width() + versus_board_gap * cell_width +
+            side_boundary_width;
     }
-    if (field_or_side_boundaries_conflict(field, piece))
-        piece->x_shift = x_shift_backup;
-    cast_ghost(field, *piece, &piece->ghost_decline);
-    piece_(print_piece, piece);
+    return
+        (game_info_gap + big_piece_size) * cell_width * 2 +
+        field_width * cell_width - 1;
 }
 
-void piece_fall_step(struct_piece *piece)
+int min_screen_height()
 {
-    piece_(hide_piece, piece);
-    piece->y_decline++;
-    piece_(print_piece, piece);
-    curs_set(0);
-    refresh();
+    return 2*top_boundary_height + cell_height*field_height;
 }
 
-void handle_rotation(const bool (*field)[field_width], struct_piece *piece)
+int init_resize_screen_y(int row)
 {
-    bool backup_matrix[piece->size][piece->size];
-    make_backup(backup_matrix, piece);
-    piece_(hide_ghost, piece);
-    piece_(hide_piece, piece);
-    /* `piece->form.small` and `piece->form.big` share the same address,
-    so we handle both scenarios here */
-    rotate(piece->form.small, piece->size);
-    handle_rotation_conflicts(field, piece, backup_matrix);
-    cast_ghost(field, *piece, &piece->ghost_decline);
-    piece_(print_piece, piece);
+    return (row - num_of_resize_msg_lines) / 2;
 }
 
-void process_key(
-    int key_pressed, const bool (*field)[field_width],
-    struct_piece *piece, bool *hard_drop, bool *game_on
-)
+void print_resize_request_msg(int row, int col)
 {
-    switch (key_pressed) {
-        case KEY_LEFT:
-            move_(left, field, piece);
-            break;
-        case KEY_RIGHT:
-            move_(right, field, piece);
-            break;
-        /* rotate */
-        case KEY_UP:
-            handle_rotation(field, piece);
-            break;
-        /* hard drop */
-        case ' ':
-            while (!piece_has_fallen(field, piece))
-                piece_fall_step(piece);
-            *hard_drop = true;
-            break;
-        /* exit the game (Esc) */
-        case key_esc:
-            *game_on = false;
-            break;
-        case KEY_DOWN:
-        case ERR:
-            ;
+    int y;
+    y = init_resize_screen_y(row);
+    print_centered_format_msg(&y, col, RESIZE_WARNING_MSG, 0, 0);
+    print_centered_format_msg(&y, col, CURR_TERMINAL_SIZE_MSG, col, row);
+    print_centered_format_msg(
+        &y, col, REQUIRED_TERMINAL_SIZE_MSG,
+        min_screen_width(), min_screen_height()
+    );
+    print_centered_format_msg(&y, col, RESIZE_REQUEST_MSG_1, 0, 0);
+    print_centered_format_msg(&y, col, RESIZE_REQUEST_MSG_2, 0, 0);
+    print_centered_format_msg(&y, col, CLOSE_WINDOW_MSG, 0, 0);
+    screen_flush();
+}
+
+void screen_size_check()
+{
+    int row, col;
+    screen_size(&row, &col);
+    if ((col < min_screen_width()) || (row < min_screen_height())) {
+        print_resize_request_msg(row, col);
+        wait_until_esc_is_pressed_then_exit();
     }
 }
 
-void process_input(
-    const bool (*field)[field_width], struct_piece *piece,
-    int level, bool *game_on
-)
+int option_index(int argc, char **argv, const char *option)
 {
-    struct timeval tv1, tv2;
-    struct timezone tz;
-    speed_list speed[] = {
-        zero,     first,       second,      third,      fourth,    fifth,
-        sixth,    seventh,     eighth,      ninth,      tenth,     eleventh,
-        twelfth,  thirteenth,  fourteenth,  fifteenth
-    };
-    int key_pressed, delay = speed[level];
-    for (;;) {
-        bool hard_drop = false;
-        timeout(delay);
-        time_start(&tv1, &tz);
-        key_pressed = getch();
-        process_key(key_pressed, field, piece, &hard_drop, game_on);
-        if (
-            (key_pressed == ERR) || (key_pressed == KEY_DOWN) ||
-            (hard_drop) || (!*game_on)
-        )
-        {
-            break;
-        }
-        /* new delay value calculation */
-        delay -= time_stop(&tv1, &tv2, &tz);
-        if (delay < 0)
-            break;
-        else
-            continue;
+    int i;
+    for (i=1; i < argc; i++) {
+        if (strcmp(argv[i], option) == 0)
+            return i;
     }
+    return 0;
 }
 
-void piece_falls(
-    bool (*field)[field_width], struct_piece *piece, int level, bool *game_on
-)
+/* the number given after the option, `value` if the option isn't given */
+int option_value(int argc, char **argv, const char *option, int value)
 {
-    while ((*game_on)) {
-        process_input(field, piece, level, game_on);
-        if (piece_has_fallen(field, piece)) {
-            field_absorbes_piece(field, piece);
-            break;
+    int i = option_index(argc, argv, option);
+    if (!i)
+        return value;
+    if (i + 1 >= argc) {
+        fprintf(stderr, "%s: the value is missing\n", option);
+        exit(1);
+    }
+    return atoi(argv[i + 1]);
+}
+
+screen_backend_kind chosen_screen_backend(int argc, char **argv)
+{
+    if (option_index(argc, argv, ANSI_SCREEN_OPTION))
+        return ansi_screen;
+    return ncurses_screen;
+}
+
+/* returns NULL if the player plays themselves */
+const player_policy *chosen_policy(int argc, char **argv)
+{
+    static player_policy policy;
+    static board_net net;
+    static heuristic_weights weights;
+    static rollout_config rollouts;
+    int i = option_index(argc, argv, NET_OPTION);
+    if (i) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "%s: the weights file is missing\n", NET_OPTION);
+            exit(1);
+        }
+        load_board_net(&net, argv[i + 1]);
+        init_net_policy(&policy, &net);
+        return &policy;
+    }
+    if (option_index(argc, argv, BOT_OPTION)) {
+        weights = *default_heuristic_weights();
+        i = option_index(argc, argv, WEIGHTS_OPTION);
+        if (i) {
+            if (i + 1 >= argc) {
+                fprintf(
+                    stderr, "%s: the weights file is missing\n",
+                    WEIGHTS_OPTION
+                );
+                exit(1);
+            }
+            load_heuristic_weights(argv[i + 1], &weights);
         }
-        piece_fall_step(piece);
-    }
-}
-
-void init_set_of_pieces(struct_piece *set_of_pieces)
-{
-    int i = 0;
-    struct_piece I_piece = {
-        .size = big_piece_size,
-        .form.big = {
-            { 0, 0, 0, 0 },
-            { 0, 0, 0, 0 },
-            { 1, 1, 1, 1 },
-            { 0, 0, 0, 0 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = true,
-        .orientation = horizontal_1
-    };
-    memcpy(&set_of_pieces[i], &I_piece, sizeof(struct_piece));
-    i++;
-    struct_piece O_piece = {
-        .size = big_piece_size,
-        .form.big = {
-            { 0, 0, 0, 0 },
-            { 0, 1, 1, 0 },
-            { 0, 1, 1, 0 },
-            { 0, 0, 0, 0 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &O_piece, sizeof(struct_piece));
-    i++;
-    struct_piece T_piece = {
-        .size = small_piece_size,
-        .form.small = {
-            { 0, 0, 0 },
-            { 1, 1, 1 },
-            { 0, 1, 0 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &T_piece, sizeof(struct_piece));
-    i++;
-    struct_piece S_piece = {
-        .size = small_piece_size,
-        .form.small = {
-            { 0, 0, 0 },
-            { 0, 1, 1 },
-            { 1, 1, 0 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &S_piece, sizeof(struct_piece));
-    i++;
-    struct_piece Z_piece = {
-        .size = small_piece_size,
-        .form.small = {
-            { 0, 0, 0 },
-            { 1, 1, 0 },
-            { 0, 1, 1 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &Z_piece, sizeof(struct_piece));
-    i++;
-    struct_piece J_piece = {
-        .size = small_piece_size,
-        .form.small = {
-            { 0, 0, 0 },
-            { 1, 1, 1 },
-            { 0, 0, 1 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &J_piece, sizeof(struct_piece));
-    i++;
-    struct_piece L_piece = {
-        .size = small_piece_size,
-        .form.small = {
-            { 0, 0, 0 },
-            { 1, 1, 1 },
-            { 1, 0, 0 }
-        },
-        .x_shift = initial_piece_shift,
-        .y_decline = 0, .ghost_decline = 0,
-        .i_form = false
-    };
-    memcpy(&set_of_pieces[i], &L_piece, sizeof(struct_piece));
-}
-
-struct_piece get_random_piece(const struct_piece *set_of_pieces)
-{
-    int i = (int)(((double)num_of_pieces) * rand() / (RAND_MAX+1.0));
-    return set_of_pieces[i];
+        if (option_index(argc, argv, ROLLOUTS_OPTION)) {
+            init_rollout_config(&rollouts);
+            rollouts.budget_ms = option_value(
+                argc, argv, ROLLOUTS_OPTION, rollouts.budget_ms
+            );
+            rollouts.weights = &weights;
+            init_rollout_policy(&policy, &rollouts);
+            return &policy;
+        }
+        init_search_policy(
+            &policy, &weights,
+            option_value(argc, argv, DEPTH_OPTION, search_policy_depth)
+        );
+        return &policy;
+    }
+    return NULL;
 }
 
-int game_info_y(int y)
+/* returns NULL if no external bot plays */
+bot_link *chosen_bot_link(int argc, char **argv)
 {
-    return get_init_y() + y * cell_height;
+    static bot_link link;
+    int i = option_index(argc, argv, BOT_LINK_OPTION);
+    if (!i)
+        return NULL;
+    if (i + 1 >= argc) {
+        fprintf(stderr, "%s: the segment name is missing\n", BOT_LINK_OPTION);
+        exit(1);
+    }
+    create_bot_link(&link, argv[i + 1]);
+    return &link;
 }
 
-int game_info_x()
+/* returns NULL if the game isn't recorded */
+const char *chosen_recording_file(int argc, char **argv)
 {
-    return get_init_x() + (field_width + game_info_gap) * cell_width;
+    int i = option_index(argc, argv, RECORD_OPTION);
+    if (!i)
+        return NULL;
+    if (i + 1 >= argc) {
+        fprintf(stderr, "%s: the recording file is missing\n", RECORD_OPTION);
+        exit(1);
+    }
+    return argv[i + 1];
 }
 
-void print_labels()
+/* the classic rules unless the options change them */
+void chosen_game_rules(int argc, char **argv, game_rules *rules)
 {
-    mvprintw(game_info_y(level_label_row), game_info_x(), "LEVEL");
-    mvprintw(game_info_y(score_label_row), game_info_x(), "SCORE");
-    mvprintw(game_info_y(next_label_row)+cell_height-1, game_info_x(), "NEXT");
-    curs_set(0);
-    refresh();
+    rules->start_level = option_value(argc, argv, LEVEL_OPTION, 1);
+    rules->previews = option_value(argc, argv, PREVIEWS_OPTION, 1);
+    rules->lock_delay = option_value(argc, argv, LOCK_DELAY_OPTION, 0);
+    rules->move_reset_limit = option_value(
+        argc, argv, MOVE_RESETS_OPTION,
+        rules->lock_delay ? default_move_reset_limit : 0
+    );
 }
 
-void print_game_info(int info, int position)
+/* every step is made here, so a recorded game can be replayed */
+void step_game(game *g, const game_event *event)
 {
-    mvprintw(game_info_y(position), game_info_x(), "%d", info);
-    curs_set(0);
-    refresh();
+    game_step(g, event);
+    if (game_recording)
+        record_step(game_recording, event, g);
 }
 
-void show_next_piece_preview(struct_piece piece, struct_piece next_piece)
+game_action process_key(int key_pressed)
 {
-    piece.x_shift = field_width + game_info_gap;
-    next_piece.x_shift = field_width + game_info_gap;
-    piece.y_decline = next_row;
-    next_piece.y_decline = next_row;
-    piece_(hide_piece, &piece);
-    piece_(print_piece, &next_piece);
-    curs_set(0);
-    refresh();
+    switch (key_pressed) {
+        case key_left:
+            return move_left;
+        case key_right:
+            return move_right;
+        /* rotate */
+        case key_up:
+            return rotate_piece;
+        case key_down:
+            return soft_drop;
+        /* hard drop */
+        case ' ':
+            return hard_drop;
+        /* exit the game (Esc) */
+        case key_esc:
+            return quit_game;
+        default:
+            return no_action;
+    }
 }
 
-void print_centered_format_msg(
-    int *y, int col, const char *msg, int format_1, int format_2
-)
+void process_input(game *g, key_repeat *keys)
 {
-    char assist_str[max_msg_str_size];
-    sprintf(assist_str, msg, format_1, format_2);
-    msg = assist_str;
-    int x = (col - strlen(msg)) / 2;
-    mvprintw(*y, x, "%s", msg);
-    (*y)++;
+    game_event event = { gravity_event, no_action, current_time() };
+    long deadline = key_repeat_deadline(keys);
+    /* a wait ending without a step changes nothing: the last step's changes
+    mustn't be posted again */
+    g->changes = 0;
+    if (deadline > g->gravity_deadline)
+        deadline = g->gravity_deadline;
+    /* the keys are waited for only until the gravity deadline or the next
+    move of the held key */
+    if (event.time < deadline) {
+        int key_pressed = screen_read_key((int)(deadline - event.time));
+        event.time = current_time();
+        if (key_pressed != no_key) {
+            event.kind = input_event;
+            event.action =
+                key_repeat_press(keys, process_key(key_pressed), event.time);
+            if (event.action != no_action)
+                step_game(g, &event);
+            return;
+        }
+    }
+    if (event.time >= key_repeat_deadline(keys)) {
+        event.kind = input_event;
+        event.action = key_repeat_due(keys, event.time);
+        if (event.action != no_action)
+            step_game(g, &event);
+        return;
+    }
+    if (event.time >= g->gravity_deadline)
+        step_game(g, &event);
 }
 
-void print_score_message(int score)
+void process_policy_move(game *g, const player_policy *policy)
 {
-    int row, col;
-    int y;
-    getmaxyx(stdscr, row, col);
-    y = row / 2;
-    print_centered_format_msg(&y, col, FINAL_SCORE_MSG, score, 0);
+    /* the placement the policy chose for the falling piece */
+    static placement target;
+    static bool has_target = false;
+    game_event event = { gravity_event, no_action, current_time() };
+    finesse_path path;
+    long wait = g->gravity_deadline - event.time;
+    if (g->changes & next_piece_changed)
+        has_target = policy->choose(policy, g, get_thread_arena(), &target);
+    if (wait > policy_key_delay)
+        wait = policy_key_delay;
+    /* the player can only watch or leave */
+    if (screen_read_key((wait > 0) ? (int)wait : 0) == key_esc) {
+        event.kind = input_event;
+        event.action = quit_game;
+        step_game(g, &event);
+        return;
+    }
+    event.time = current_time();
+    if (event.time < g->gravity_deadline) {
+        /* the keys are pressed one at a time and the path is found again
+        every time, as the gravity may have moved the piece meanwhile */
+        event.kind = input_event;
+        event.action =
+            (has_target && find_finesse_path(g, &target, &path)) ?
+            path.actions[0] : hard_drop;
+    }
+    step_game(g, &event);
 }
 
-void wait_until_esc_is_pressed_then_exit()
+/* the external bot's actions take the place of the keys */
+void process_bot_link_input(game *g, bot_link *link)
 {
-    timeout(-1);
-    while (getch() != key_esc)
-        ;
-    endwin();
-    exit(0);
+    /* the time the keyboard is checked for Esc at */
+    static long key_check_time = 0;
+    game_event event = { input_event, no_action, current_time() };
+    long wait = g->gravity_deadline - event.time;
+    if (event.time >= key_check_time) {
+        key_check_time = event.time + bot_link_key_check;
+        if (screen_read_key(0) == key_esc) {
+            event.action = quit_game;
+            step_game(g, &event);
+            publish_bot_link_state(link, g);
+            return;
+        }
+    }
+    if (wait > key_check_time - event.time)
+        wait = key_check_time - event.time;
+    event.action = wait_bot_link_action(link, (wait > 0) ? (int)wait : 0);
+    event.time = current_time();
+    if (event.action == no_action) {
+        if (event.time < g->gravity_deadline) {
+            /* nothing happened */
+            g->changes = 0;
+            return;
+        }
+        event.kind = gravity_event;
+        step_game(g, &event);
+        if (g->changes)
+            publish_bot_link_state(link, g);
+        return;
+    }
+    step_game(g, &event);
+    /* even an action changing nothing is answered, it's taken */
+    publish_bot_link_state(link, g);
 }
 
-void end_game(int score)
+bool line_is_cleared(int top, int lines, int y)
 {
-    clear();
-    print_score_message(score);
-    wait_until_esc_is_pressed_then_exit();
+    return (y >= top) && (y < top + big_piece_size) && (lines & 1 << (y - top));
 }
 
-void process_uncompleted_line(
-    bool we_are_checking_block_with_completed_lines,
-    bool **sequence_of_completed_lines
-)
+/* the field right before the lines were cleared: the cleared lines full
+again, the rows above them back where they were */
+void field_before_clear(const game *g, field_row *field)
 {
-    if (we_are_checking_block_with_completed_lines)
-        (*sequence_of_completed_lines)++;
+    field_row full_row = (1u << field_width) - 1;
+    int from = field_height - 1, y;
+    for (y=field_height - 1; y >= 0; y--) {
+        if (line_is_cleared(g->cleared_top, g->cleared_lines, y))
+            field[y] = full_row;
+        else
+            field[y] = g->field[from--];
+    }
 }
 
-void process_completed_line(
-    int *num_of_completed_lines, bool **sequence_of_completed_lines,
-    int *row_num_of_first_completed_line, int y
+void print_cleared_cells(
+    const shown_state *shown, int field_x, type_of_cell type
 )
 {
-    (*num_of_completed_lines)++;
-    **sequence_of_completed_lines = 1;
-    (*sequence_of_completed_lines)++;
-    if (!(*row_num_of_first_completed_line))
-        *row_num_of_first_completed_line = y;
+    int field_y;
+    for (field_y=0; field_y < field_height; field_y++) {
+        if (!line_is_cleared(shown->clear_top, shown->clear_lines, field_y))
+            continue;
+        print_cell_(
+            type, get_init_x() + field_x * cell_width,
+            get_init_y() + field_y * cell_height
+        );
+    }
+}
+
+/* the game has cleared the lines and gone on, the screen shows them going
+for a while */
+void start_line_clear(const game *g, shown_state *shown)
+{
+    field_row field[max_field_height];
+    int field_x;
+    field_before_clear(g, field);
+    print_field_changes(field, shown->field);
+    shown->clearing = true;
+    shown->clear_started = current_time();
+    shown->clear_top = g->cleared_top;
+    shown->clear_lines = g->cleared_lines;
+    shown->wiped_columns = 0;
+    for (field_x=0; field_x < field_width; field_x++)
+        print_cleared_cells(shown, field_x, cleared);
 }
 
-bool there_are_completed_lines(
-    const bool (*field)[field_width], int *num_of_completed_lines,
-    int *row_num_of_first_completed_line, bool *sequence_of_completed_lines
+/* the falling piece over the field shown before the clear: the rows above
+the cleared lines haven't fallen on the screen yet, so neither has the piece;
+its cells over the shown stack or above the field are left out, and its ghost
+isn't shown */
+void clearing_piece_(
+    piece_action action, const struct_piece *piece, const shown_state *shown
 )
 {
-    int x, y;
-    bool we_are_checking_block_with_completed_lines = false;
-    /* searching for completed lines from the bottom to the top */
-    for (y=field_height-1; y > 0; y--) {
-        bool completed_line = true, empty_line = true;
-        for (x=0; x < field_width; x++) {
-            if (field[y][x] == 1)
-                empty_line = false;
-            else
-                completed_line = false;
-        }
-        if (completed_line) {
-            we_are_checking_block_with_completed_lines = true;
-            process_completed_line(
-                num_of_completed_lines, &sequence_of_completed_lines,
-                row_num_of_first_completed_line, y
-            );
-        } else {
-            process_uncompleted_line(
-                we_are_checking_block_with_completed_lines,
-                &sequence_of_completed_lines
+    const bool (*matrix)[piece->size] = piece->form.small;
+    int rows = __builtin_popcount(shown->clear_lines), x, y;
+    for (y=0; y < piece->size; y++) {
+        for (x=0; x < piece->size; x++) {
+            int field_y = piece->y_decline + y - rows;
+            if ((matrix[y][x] != 1) || (field_y < 0) ||
+                field_cell_is_occupied(
+                    shown->field, piece->x_shift + x, field_y
+                ))
+            {
+                continue;
+            }
+            take_(
+                action, curr_x(piece, x), get_init_y() + field_y * cell_height
             );
         }
-        if (empty_line ||
-            /* since we met 1st completed line we looked through the maximum
-            number of possibly completed lines and can break now */
-            (*row_num_of_first_completed_line - y ==
-            max_num_of_completed_lines - 1))
-        {
-            break;
-        }
     }
-    return (*num_of_completed_lines) ? true : false;
 }
 
-void shift_down_upper_not_empty_lines_for_num_positions(
-    bool (*field)[field_width], int init_row_to_replace,
-    int num, int *field_y, int *screen_y
-)
+/* the rows above the cleared lines fall: the field is drawn anew, as the
+falling piece may have been drawn over the field shown before the clear */
+void end_line_clear(const game *g, shown_state *shown)
 {
-    int field_x, screen_x;
-    for(*field_y = init_row_to_replace,
-            *screen_y = get_init_y() + init_row_to_replace * cell_height;
-        *field_y > 0;
-        (*field_y)--, *screen_y -= cell_height)
-    {
-        bool empty_line = true;
-        for(field_x = 0, screen_x = get_init_x();
-            field_x < field_width;
-            field_x++, screen_x += cell_width)
-        {
-            field[*field_y][field_x] = field[*field_y-num][field_x];
-            if (field[*field_y][field_x] == 1) {
-                empty_line = false;
-                print_cell_(occupied, screen_x, *screen_y);
-            } else
-                print_cell_(empty, screen_x, *screen_y);
-        }
-        if (empty_line)
-            break;
-    }
+    shown->clearing = false;
+    print_field(g->field);
+    memcpy(shown->field, g->field, sizeof(shown->field));
+    piece_(print_ghost, &shown->piece);
+    piece_(print_piece, &shown->piece);
 }
 
-void replace_upmost_not_empty_lines_with_empty_cells(
-    bool (*field)[field_width], int num, int field_y, int screen_y
-)
+void show_changes(const game *g, shown_state *shown)
 {
-    int field_x, screen_x;
-    for(num--, field_y--, screen_y -= cell_height;
-        num > 0;
-        num--, field_y--, screen_y -= cell_height)
-    {
-        for(field_x = 0, screen_x = get_init_x();
-            field_x < field_width;
-            field_x++, screen_x += cell_width)
+    struct_piece piece = game_piece(g);
+    if (g->changes & (piece_changed | field_changed)) {
+        if (shown->clearing)
+            clearing_piece_(hide_piece, &shown->piece, shown);
+        else {
+            piece_(hide_ghost, &shown->piece);
+            piece_(hide_piece, &shown->piece);
+        }
+        /* a field changing again ends the line clear shown */
+        if ((g->changes & field_changed) && shown->clearing) {
+            shown->clearing = false;
+            shown->field_shown = false;
+        }
+        /* the locked piece and the shifted lines */
+        if ((g->changes & field_changed) && !shown->field_shown) {
+            print_field(g->field);
+            memcpy(shown->field, g->field, sizeof(shown->field));
+            shown->field_shown = true;
+        }
+        if ((g->changes & field_changed) && shown->animated &&
+            g->cleared_lines)
         {
-            field[field_y][field_x] = 0;
-            print_cell_(empty, screen_x, screen_y);
+            start_line_clear(g, shown);
+        } else if (g->changes & field_changed)
+            print_field_changes(g->field, shown->field);
+        if (shown->clearing)
+            clearing_piece_(print_piece, &piece, shown);
+        else {
+            piece_(print_ghost, &piece);
+            piece_(print_piece, &piece);
         }
+        shown->piece = piece;
     }
+    if (g->changes & next_piece_changed)
+        show_preview(g, shown->previews);
+    if (g->changes & score_changed)
+        print_game_info(g->score, score_row);
+    if (g->changes & level_changed)
+        print_game_info(g->level, level_row);
+    screen_flush();
 }
 
-void delete_completed_lines(
-    bool (*field)[field_width], int init_row_to_replace, int num
-)
+void init_shown_state(shown_state *shown, const game *g, bool animated)
 {
-    int field_y, screen_y;
-    shift_down_upper_not_empty_lines_for_num_positions(
-        field, init_row_to_replace, num, &field_y, &screen_y
-    );
-    replace_upmost_not_empty_lines_with_empty_cells(
-        field, num, field_y, screen_y
-    );
+    shown->animated = animated;
+    shown->clearing = false;
+    shown->piece = game_piece(g);
+    memset(shown->previews, num_of_pieces, sizeof(shown->previews));
+    shown->field_shown = false;
 }
 
-bool curr_line_is_completed(int num)
+/* the render thread's callback */
+void draw_game_state(const game *g, void *shown)
 {
-    return (num) ? true : false;
+    show_changes(g, shown);
 }
 
-void find_continuous_block_of_completed_lines(
-    bool *sequence_of_completed_lines, int *i, int *num_of_deleted_lines
-)
+/* the render thread's callback for every frame: the cleared lines empty from
+the middle outwards, a pair of columns at a time */
+void animate_game_state(const game *g, void *ctx)
 {
-    while ((*i < max_num_of_completed_lines) && sequence_of_completed_lines[*i])
-    {
-        (*num_of_deleted_lines)++;
-        (*i)++;
+    shown_state *shown = ctx;
+    int half = (field_width + 1) / 2;
+    long elapsed;
+    int columns;
+    if (!shown->clearing)
+        return;
+    elapsed = current_time() - shown->clear_started;
+    columns = (elapsed >= line_clear_time) ?
+        half : (int)(elapsed * (half + 1) / line_clear_time);
+    if (columns > half)
+        columns = half;
+    for (; shown->wiped_columns < columns; shown->wiped_columns++) {
+        print_cleared_cells(
+            shown, (field_width - 1) / 2 - shown->wiped_columns, empty
+        );
+        print_cleared_cells(
+            shown, field_width / 2 + shown->wiped_columns, empty
+        );
     }
+    if (elapsed >= line_clear_time)
+        end_line_clear(g, shown);
+    screen_flush();
 }
 
-void field_matrix_rearrangement(
-    bool (*field)[field_width], int init_row_to_replace,
-    bool *sequence_of_completed_lines
-)
+/* a side of a versus match played by this program */
+typedef struct tag_versus_player {
+    /* NULL if the player plays themselves */
+    const player_policy *policy;
+    /* the placement the policy chose for the falling piece */
+    placement target;
+    bool has_target;
+    /* set when a piece spawns (or the board is simulated again), so the
+    target is chosen anew */
+    bool new_piece;
+    /* the frame of the computer player's last key press: the next one waits
+    until the match has simulated it, so the path is found from the state it
+    led to */
+    unsigned int pressed_at;
+    bool pressed;
+    /* the key presses not taken by a frame yet */
+    game_action keys[max_versus_keys];
+    int num_of_keys;
+} versus_player;
+
+/* a board of a versus match as the screen shows it */
+typedef struct tag_shown_board {
+    shown_state state;
+    int pending_garbage;
+} shown_board;
+
+void show_board(int player)
 {
-    int i = 0, num_of_deleted_lines = 0;
-    for(;
-        i < max_num_of_completed_lines;
-        i++, num_of_deleted_lines = 0, init_row_to_replace--)
-    {
-        find_continuous_block_of_completed_lines(
-            sequence_of_completed_lines, &i, &num_of_deleted_lines
+    int row, col;
+    (void)row;
+    screen_size(&row, &col);
+    board_shift = 0;
+    board_shift =
+        (col - min_screen_width()) / 2 + side_boundary_width +
+        player * (board_width() + versus_board_gap * cell_width) -
+        get_init_x();
+}
+
+void print_versus_labels(const versus_match *m, shown_board *boards)
+{
+    int p;
+    for (p=0; p < num_of_versus_players; p++) {
+        show_board(p);
+        screen_put_str(
+            game_info_y(garbage_label_row), game_info_x(), "GARBAGE"
         );
-        if (curr_line_is_completed(num_of_deleted_lines))
-            delete_completed_lines(
-                field, init_row_to_replace, num_of_deleted_lines
-            );
-        else
-            /* it's an uncompleted line in the block of completed lines */
-            continue;
+        print_labels();
+        init_shown_state(&boards[p].state, &m->games[p], false);
+        boards[p].pending_garbage = -1;
     }
 }
 
-int score_bonus(int level, int num_of_completed_lines)
+/* draws what the frames since the last call changed */
+void show_versus_changes(versus_match *m, shown_board *boards)
 {
-    switch (num_of_completed_lines) {
-        case 1:
-            return level * one_line_score_bonus;
-        case 2:
-            return level * two_lines_score_bonus;
-        case 3:
-            return level * three_lines_score_bonus;
-        case 4:
-            return level * four_lines_score_bonus;
-        default:
-            fprintf(
-                stderr, "%s:%d: incorrect number of completed lines: %d\n", 
-                __FILE__, __LINE__, num_of_completed_lines
+    int p;
+    for (p=0; p < num_of_versus_players; p++) {
+        game shown = m->games[p];
+        show_board(p);
+        shown.changes = m->changes[p];
+        show_changes(&shown, &boards[p].state);
+        m->changes[p] = 0;
+        if (boards[p].pending_garbage != m->pending_garbage[p]) {
+            char garbage_str[max_msg_str_size];
+            boards[p].pending_garbage = m->pending_garbage[p];
+            sprintf(garbage_str, "%-3d", boards[p].pending_garbage);
+            screen_put_str(
+                game_info_y(garbage_row), game_info_x(), garbage_str
             );
-            exit(1);
+        }
     }
+    board_shift = 0;
+    screen_flush();
 }
 
-void score_increase(int *score, int level, int num_of_completed_lines)
+void init_versus_player(versus_player *player, const player_policy *policy)
 {
-    *score += score_bonus(level, num_of_completed_lines);
+    player->policy = policy;
+    player->has_target = false;
+    player->new_piece = true;
+    player->pressed = false;
+    player->num_of_keys = 0;
 }
 
-void level_up_if_necessary(int *level, int num_of_completed_lines)
+void press_versus_key(versus_player *player, int key_pressed)
 {
-    static int total_num_of_completed_lines;
-    total_num_of_completed_lines += num_of_completed_lines;
-    if (total_num_of_completed_lines >= num_of_completed_lines_for_level_up) {
-        (*level)++;
-        if ((*level) > maximum_game_level) (*level) = maximum_game_level;
-        print_game_info(*level, level_row);
-        total_num_of_completed_lines = 0;
-    }
+    game_action action = process_key(key_pressed);
+    if ((action != no_action) && (player->num_of_keys < max_versus_keys))
+        player->keys[player->num_of_keys++] = action;
 }
 
-void clear_completed_lines_update_score_and_level_up(
-    bool (*field)[field_width], int *level, int *score
+/* the action the player takes at the frame: one key press a frame, the
+computer player's presses paced like its keys outside a match; `g` is the
+game after the match's `simulated` frames */
+game_action versus_player_action(
+    versus_player *player, const game *g, unsigned int frame,
+    unsigned int simulated
 )
 {
-    (void)score;
-    int num_of_completed_lines = 0, row_num_of_first_completed_line = 0;
-    /* completed lines may not be continuous and may contain breaks */
-    /* the following array records this sequence */
-    bool sequence_of_completed_lines[max_num_of_completed_lines] = { 0 };
-    if (there_are_completed_lines(
-            field, &num_of_completed_lines, &row_num_of_first_completed_line,
-            sequence_of_completed_lines
-        )
-    )
-    {
-        field_matrix_rearrangement(
-            field, row_num_of_first_completed_line, sequence_of_completed_lines
+    finesse_path path;
+    if (!player->policy) {
+        game_action action = no_action;
+        if (player->num_of_keys) {
+            action = player->keys[0];
+            player->num_of_keys--;
+            memmove(
+                player->keys, player->keys + 1,
+                player->num_of_keys * sizeof(game_action)
+            );
+        }
+        return action;
+    }
+    if (player->new_piece) {
+        player->new_piece = false;
+        player->has_target = player->policy->choose(
+            player->policy, g, get_thread_arena(), &player->target
         );
-        score_increase(score, *level, num_of_completed_lines);
-        print_game_info(*score, score_row);
-        level_up_if_necessary(level, num_of_completed_lines);
     }
+    if (!g->game_on || (frame % (policy_key_delay / versus_frame_time)) ||
+        (player->pressed && (player->pressed_at >= simulated)))
+    {
+        return no_action;
+    }
+    player->pressed = true;
+    player->pressed_at = frame;
+    return
+        (player->has_target && find_finesse_path(g, &player->target, &path)) ?
+        path.actions[0] : hard_drop;
 }
 
-int min_screen_width()
+void end_versus_match(versus_result outcome, int local_player, int score)
 {
-    return
-        (game_info_gap + big_piece_size) * cell_width * 2 +
-        field_width * cell_width - 1;
+    int row, col;
+    int y;
+    const char *msg = PEER_LOST_MSG;
+    screen_clear();
+    screen_size(&row, &col);
+    y = row / 2 - 1;
+    if (outcome == match_drawn)
+        msg = VERSUS_DRAW_MSG;
+    else if (outcome == (versus_result)local_player)
+        msg = VERSUS_WIN_MSG;
+    else if (outcome != match_goes_on)
+        msg = VERSUS_LOSS_MSG;
+    print_centered_format_msg(&y, col, msg, 0, 0);
+    print_centered_format_msg(&y, col, FINAL_SCORE_MSG, score, 0);
+    wait_until_esc_is_pressed_then_exit();
 }
 
-int min_screen_height()
+/* the player against the computer on one screen: both boards are simulated
+here, a frame at a time, so no input is ever late */
+void play_local_versus(const player_policy *policy)
 {
-    return 2*top_boundary_height + cell_height*field_height;
+    static versus_match m;
+    shown_board boards[num_of_versus_players];
+    versus_player players[num_of_versus_players];
+    versus_result outcome;
+    long start_time;
+    init_versus_player(&players[0], NULL);
+    init_versus_player(&players[1], policy);
+    init_versus_match(&m, standard_field, time(NULL));
+    init_finesse_tables();
+    print_versus_labels(&m, boards);
+    show_versus_changes(&m, boards);
+    start_time = current_time();
+    while ((outcome = versus_outcome(&m)) == match_goes_on) {
+        game_action inputs[num_of_versus_players];
+        long frame_time = start_time + (m.frame + 1) * versus_frame_time;
+        long wait;
+        int p;
+        /* the keys are read until the frame time */
+        while ((wait = frame_time - current_time()) > 0) {
+            int key_pressed = screen_read_key((int)wait);
+            if (key_pressed != no_key)
+                press_versus_key(&players[0], key_pressed);
+        }
+        for (p=0; p < num_of_versus_players; p++) {
+            inputs[p] = versus_player_action(
+                &players[p], &m.games[p], m.frame, m.frame
+            );
+        }
+        versus_frame(&m, inputs);
+        players[1].new_piece |= (m.changes[1] & next_piece_changed) != 0;
+        show_versus_changes(&m, boards);
+    }
+    end_versus_match(outcome, 0, m.games[0].score);
 }
 
-int init_resize_screen_y(int row)
+/* calls the other side until it answers; the player may leave meanwhile */
+void wait_for_versus_peer(versus_link *link)
 {
-    return (row - num_of_resize_msg_lines) / 2;
+    while (!link->peer_seen) {
+        send_versus_packet(link, NULL);
+        if (screen_read_key(versus_hello_interval) == key_esc) {
+            screen_end();
+            exit(0);
+        }
+        receive_versus_packets(link, NULL, current_time());
+    }
+    /* the other side learns the local seed from this packet even if it has
+    missed all the previous ones */
+    send_versus_packet(link, NULL);
 }
 
-void print_resize_request_msg(int row, int col)
+/* the local inputs are confirmed `versus_input_delay` frames ahead of the
+match, but never ahead of the frames the local clock has reached */
+void confirm_local_inputs(
+    rollback_session *s, int local, versus_player *player, unsigned int frame
+)
 {
-    int y;
-    y = init_resize_screen_y(row);
-    print_centered_format_msg(&y, col, RESIZE_WARNING_MSG, 0, 0);
-    print_centered_format_msg(&y, col, CURR_TERMINAL_SIZE_MSG, col, row);
-    print_centered_format_msg(
-        &y, col, REQUIRED_TERMINAL_SIZE_MSG,
-        min_screen_width(), min_screen_height()
+    unsigned int last =
+        ((frame < s->match.frame) ? frame : s->match.frame) +
+        versus_input_delay;
+    while (s->confirmed[local] <= last) {
+        unsigned int input_frame = s->confirmed[local];
+        game_action action = versus_player_action(
+            player, &s->match.games[local], input_frame, s->match.frame
+        );
+        if (!set_rollback_input(s, local, input_frame, action))
+            return;
+    }
+}
+
+/* sends the last local inputs until the other side confirms them, so it can
+tell the outcome too */
+void linger_versus_link(versus_link *link, rollback_session *s)
+{
+    long deadline = current_time() + versus_link_linger;
+    while ((link->inputs_confirmed < s->confirmed[link->local_player]) &&
+        (current_time() < deadline))
+    {
+        send_versus_packet(link, s);
+        screen_read_key(versus_frame_time);
+        receive_versus_packets(link, s, current_time());
+    }
+}
+
+/* a match against another game over the loopback interface, rolled back
+whenever the other side's input comes late */
+void play_udp_versus(versus_link *link, const player_policy *policy)
+{
+    static rollback_session s;
+    shown_board boards[num_of_versus_players];
+    versus_player player;
+    versus_result outcome;
+    int local = link->local_player;
+    long start_time, send_time = 0;
+    init_versus_player(&player, policy);
+    wait_for_versus_peer(link);
+    init_rollback_session(&s, standard_field, versus_link_seed(link));
+    init_finesse_tables();
+    print_versus_labels(&s.match, boards);
+    start_time = current_time();
+    link->last_heard = start_time;
+    while ((outcome = rollback_outcome(&s)) == match_goes_on) {
+        long time = current_time();
+        unsigned int frame = (time - start_time) / versus_frame_time;
+        long wait = start_time + (frame + 1) * versus_frame_time - time;
+        int key_pressed;
+        unsigned int confirmed = s.confirmed[local];
+        confirm_local_inputs(&s, local, &player, frame);
+        receive_versus_packets(link, &s, time);
+        if (time - link->last_heard > versus_link_timeout)
+            break;
+        if ((s.confirmed[local] != confirmed) || (time >= send_time)) {
+            send_versus_packet(link, &s);
+            send_time = time + versus_frame_time;
+        }
+        while (((s.match.frame <= frame) || s.rollback_due) &&
+            advance_rollback(&s))
+        {
+            ;
+        }
+        player.new_piece |=
+            (s.match.changes[local] & next_piece_changed) != 0;
+        show_versus_changes(&s.match, boards);
+        key_pressed = screen_read_key(
+            (wait < versus_poll_interval) ? (int)wait : versus_poll_interval
+        );
+        if (key_pressed != no_key)
+            press_versus_key(&player, key_pressed);
+    }
+    linger_versus_link(link, &s);
+    close_versus_link(link);
+    end_versus_match(outcome, local, s.match.games[local].score);
+}
+
+/* the computer player of a match on one screen, by the search unless
+another one is chosen */
+const player_policy *opponent_policy(const player_policy *policy)
+{
+    static player_policy search;
+    if (policy)
+        return policy;
+    init_search_policy(
+        &search, default_heuristic_weights(), search_policy_depth
     );
-    print_centered_format_msg(&y, col, RESIZE_REQUEST_MSG_1, 0, 0);
-    print_centered_format_msg(&y, col, RESIZE_REQUEST_MSG_2, 0, 0);
-    print_centered_format_msg(&y, col, CLOSE_WINDOW_MSG, 0, 0);
-    refresh();
-    curs_set(0);
+    return &search;
 }
 
-void screen_size_check()
+/* returns NULL if no match over the loopback interface is played */
+versus_link *chosen_versus_link(int argc, char **argv)
 {
-    int row, col;
-    getmaxyx(stdscr, row, col);
-    if ((col < min_screen_width()) || (row < min_screen_height())) {
-        print_resize_request_msg(row, col);
-        wait_until_esc_is_pressed_then_exit();
+    static versus_link link;
+    int i = option_index(argc, argv, VERSUS_UDP_OPTION);
+    if (!i)
+        return NULL;
+    if (i + 2 >= argc) {
+        fprintf(stderr, "%s: the UDP ports are missing\n", VERSUS_UDP_OPTION);
+        exit(1);
     }
+    open_versus_link(&link, atoi(argv[i + 1]), atoi(argv[i + 2]));
+    return &link;
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    /* ncurses */
-    initscr();
-    cbreak();
-    noecho();
-    keypad(stdscr, 1);
-    ESCDELAY = 50;
+    /* the computer player, if any (the weights file is checked before the
+    screen is taken) */
+    const player_policy *policy = chosen_policy(argc, argv);
+    bot_link *link = chosen_bot_link(argc, argv);
+    const char *recording_file = chosen_recording_file(argc, argv);
+    versus_link *versus = chosen_versus_link(argc, argv);
+    bool local_versus = option_index(argc, argv, VERSUS_OPTION) != 0;
+    game_rules rules;
+    key_repeat keys;
+    chosen_game_rules(argc, argv, &rules);
+    init_key_repeat(
+        &keys, option_value(argc, argv, DAS_OPTION, default_das),
+        option_value(argc, argv, ARR_OPTION, default_arr)
+    );
+
+    /* screen */
+    screen_init(chosen_screen_backend(argc, argv));
+    if (versus || local_versus) {
+        two_boards_shown = true;
+        screen_size_check();
+        if (versus)
+            play_udp_versus(versus, policy);
+        play_local_versus(opponent_policy(policy));
+    }
 
     /* variables */
-    int level = 1, score = 0;
-    bool field[field_height][field_width] = { 0 };
-    struct_piece set_of_pieces[num_of_pieces];
-    init_set_of_pieces(set_of_pieces);
-    struct_piece piece, next_piece;
+    static render_queue renderer;
+    static recording r;
+    game g;
+    shown_state shown;
+    long start_time;
 
     /* MAIN */
     screen_size_check();
-    srand(time(NULL));
-    print_field(field);
+    start_time = current_time();
+    init_game(&g, standard_field, time(NULL), start_time);
+    set_game_rules(&g, &rules, start_time);
+    init_finesse_tables();
+    if (recording_file) {
+        init_recording(&r, &g, start_time, default_keyframe_interval);
+        game_recording = &r;
+    }
     print_labels();
-    print_game_info(level, level_row);
-    print_game_info(score, score_row);
+    init_shown_state(&shown, &g, true);
+    /* from now on only the render thread draws, until the game ends */
+    start_render_thread(
+        &renderer, draw_game_state, animate_game_state, &shown,
+        frame_interval
+    );
+    post_game_state(&renderer, &g);
+    if (link)
+        publish_bot_link_state(link, &g);
     /* print_dude */
-    next_piece = get_random_piece(set_of_pieces);
-    bool game_on = true;
-    while (game_on) {
-        piece = next_piece;
-        next_piece = get_random_piece(set_of_pieces);
-        show_next_piece_preview(piece, next_piece);
-        piece_spawn(field, &piece);
-        if (piece_field_crossing_conflict(field, &piece))
-            game_on = false;
-        piece_falls(field, &piece, level, &game_on);
-        clear_completed_lines_update_score_and_level_up(field, &level, &score);
-    }
-    end_game(score);
+    while (g.game_on) {
+        if (link)
+            process_bot_link_input(&g, link);
+        else if (policy)
+            process_policy_move(&g, policy);
+        else
+            process_input(&g, &keys);
+        if (g.changes)
+            post_game_state(&renderer, &g);
+    }
+    stop_render_thread(&renderer);
+    if (link)
+        close_bot_link(link);
+    if (recording_file) {
+        save_recording(&r, recording_file);
+        free_recording(&r);
+    }
+    end_game(g.score);
 }
@@ -0,0 +1,220 @@
+/* training_data.c */
+
+#include "training_data.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum training_data_layout {
+    training_data_version = 1,
+    /* the bytes the one byte columns take per record: the pieces, the
+    placement, the lines and the game over flag */
+    byte_columns = 7
+};
+
+static const char training_data_magic[4] = { 'T', 'T', 'D', '1' };
+static const char chunk_magic[4] = { 'T', 'C', 'H', 'K' };
+
+static void training_data_error(const char *file_name, const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", file_name, msg);
+    exit(1);
+}
+
+static unsigned int chunk_size(int field_height)
+{
+    return training_data_header_size + training_data_chunk_records *
+        (field_height * sizeof(field_row) + 2 * sizeof(int) + byte_columns);
+}
+
+/* writes the whole block, the kernel may take it in parts */
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+static void check_header(
+    training_data_file *f, const char *file_name, off_t file_size
+)
+{
+    training_data_header header;
+    training_data_chunk_header last;
+    if ((pread(f->fd, &header, sizeof(header), 0) != sizeof(header)) ||
+        (memcmp(header.magic, training_data_magic, 4) != 0) ||
+        (header.version != training_data_version))
+    {
+        training_data_error(file_name, "not a training data file");
+    }
+    if ((header.field_height != (unsigned int)f->field_height) ||
+        (header.field_width != (unsigned int)f->field_width) ||
+        (header.chunk_records != training_data_chunk_records) ||
+        (header.chunk_size != f->chunk_size))
+    {
+        training_data_error(
+            file_name, "the file holds another field size or chunk layout"
+        );
+    }
+    if ((file_size - training_data_header_size) % f->chunk_size != 0)
+        training_data_error(file_name, "the file ends with a partial chunk");
+    if (file_size == training_data_header_size)
+        return;
+    /* the records go on from the end of the last chunk */
+    if ((pread(
+            f->fd, &last, sizeof(last), file_size - f->chunk_size
+        ) != sizeof(last)) || (memcmp(last.magic, chunk_magic, 4) != 0))
+    {
+        training_data_error(file_name, "the last chunk is damaged");
+    }
+    f->num_of_records = last.first_record + last.num_of_records;
+}
+
+void open_training_data(
+    training_data_file *f, const char *file_name, field_size size
+)
+{
+    const field_kernels *kernels = get_field_kernels(size);
+    struct stat st;
+    f->field_height = kernels->height;
+    f->field_width = kernels->width;
+    f->chunk_size = chunk_size(kernels->height);
+    f->num_of_records = 0;
+    f->fd = open(file_name, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if ((f->fd == -1) || (fstat(f->fd, &st) == -1)) {
+        perror(file_name);
+        exit(1);
+    }
+    if (st.st_size == 0) {
+        training_data_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, training_data_magic, 4);
+        header.version = training_data_version;
+        header.field_height = f->field_height;
+        header.field_width = f->field_width;
+        header.chunk_records = training_data_chunk_records;
+        header.chunk_size = f->chunk_size;
+        if (!write_all(f->fd, &header, sizeof(header))) {
+            perror(file_name);
+            exit(1);
+        }
+    } else {
+        check_header(f, file_name, st.st_size);
+    }
+    pthread_mutex_init(&f->lock, NULL);
+}
+
+void close_training_data(training_data_file *f)
+{
+    pthread_mutex_destroy(&f->lock);
+    close(f->fd);
+}
+
+/* lays the columns out one after another, each `training_data_chunk_records`
+values long */
+static void empty_buffer(training_data_buffer *b)
+{
+    unsigned char *column = b->chunk + training_data_header_size;
+    memset(b->chunk, 0, b->file->chunk_size);
+    memcpy(b->chunk, chunk_magic, 4);
+    b->field = (field_row *)column;
+    column += training_data_chunk_records * b->file->field_height *
+        sizeof(field_row);
+    b->game_id = (unsigned int *)column;
+    column += training_data_chunk_records * sizeof(unsigned int);
+    b->score_delta = (int *)column;
+    column += training_data_chunk_records * sizeof(int);
+    b->piece = column;
+    b->next_piece = b->piece + training_data_chunk_records;
+    b->orientation = b->next_piece + training_data_chunk_records;
+    b->x_shift = (signed char *)(b->orientation + training_data_chunk_records);
+    b->y_decline = b->x_shift + training_data_chunk_records;
+    b->lines = (unsigned char *)(b->y_decline + training_data_chunk_records);
+    b->game_over = b->lines + training_data_chunk_records;
+    b->num_of_records = 0;
+}
+
+void init_training_data_buffer(
+    training_data_buffer *b, training_data_file *f
+)
+{
+    b->file = f;
+    /* the columns stay aligned for the vector loads of a reader copying a
+    chunk as it is */
+    b->chunk = aligned_alloc(
+        cache_line_size,
+        (f->chunk_size + cache_line_size - 1) / cache_line_size *
+        cache_line_size
+    );
+    if (!b->chunk) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+    empty_buffer(b);
+}
+
+void record_decision(
+    training_data_buffer *b, unsigned int game_id, const game *before,
+    const placement *move, const game *after
+)
+{
+    int i = b->num_of_records, lines = after->lines - before->lines;
+    memcpy(
+        b->field + i * b->file->field_height, before->field,
+        b->file->field_height * sizeof(field_row)
+    );
+    b->game_id[i] = game_id;
+    b->score_delta[i] = lines ? score_bonus(before->level, lines) : 0;
+    b->piece[i] = before->piece.kind;
+    b->next_piece[i] = game_preview_kind(before, 0);
+    b->orientation[i] = move->orientation;
+    b->x_shift[i] = move->x_shift;
+    b->y_decline[i] = move->y_decline;
+    b->lines[i] = lines;
+    b->game_over[i] = !after->game_on;
+    b->num_of_records++;
+    if (b->num_of_records == training_data_chunk_records)
+        flush_training_data(b);
+}
+
+void flush_training_data(training_data_buffer *b)
+{
+    training_data_file *f = b->file;
+    training_data_chunk_header *header = (training_data_chunk_header *)b->chunk;
+    bool written;
+    if (b->num_of_records == 0)
+        return;
+    header->num_of_records = b->num_of_records;
+    /* the chunks of the threads sharing the file go one after another */
+    pthread_mutex_lock(&f->lock);
+    header->first_record = f->num_of_records;
+    written = write_all(f->fd, b->chunk, f->chunk_size);
+    f->num_of_records += b->num_of_records;
+    pthread_mutex_unlock(&f->lock);
+    if (!written) {
+        perror("training data");
+        exit(1);
+    }
+    empty_buffer(b);
+}
+
+void free_training_data_buffer(training_data_buffer *b)
+{
+    flush_training_data(b);
+    free(b->chunk);
+}
@@ -0,0 +1,125 @@
+/* versus.c */
+
+#include "versus.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+enum versus_internal_consts {
+    /* replaces the zero seed, which the garbage hole generator can't use */
+    default_garbage_seed = 362436069
+};
+
+/* the xorshift generator, the way the games draw their pieces */
+static unsigned int next_garbage_hole(versus_match *m, int width)
+{
+    unsigned int x = m->garbage_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m->garbage_rng = x;
+    return x % width;
+}
+
+void init_versus_match(versus_match *m, field_size size, unsigned int seed)
+{
+    int p;
+    for (p=0; p < num_of_versus_players; p++) {
+        init_game(&m->games[p], size, seed, 0);
+        m->pending_garbage[p] = 0;
+        m->changes[p] = m->games[p].changes | next_piece_changed;
+    }
+    m->garbage_rng = (seed) ? seed : default_garbage_seed;
+    m->frame = 0;
+}
+
+int garbage_rows_sent(int num_of_completed_lines)
+{
+    switch (num_of_completed_lines) {
+        case 0:
+        case 1:
+            return 0;
+        case 2:
+            return 1;
+        case 3:
+            return 2;
+        case 4:
+            return 4;
+        default:
+            fprintf(
+                stderr, "%s:%d: incorrect number of completed lines: %d\n",
+                __FILE__, __LINE__, num_of_completed_lines
+            );
+            exit(1);
+    }
+}
+
+/* the garbage a lock sends cancels the player's own pending garbage first */
+static void send_garbage(versus_match *m, int player, int rows)
+{
+    int cancelled = (rows < m->pending_garbage[player]) ?
+        rows : m->pending_garbage[player];
+    int opponent = 1 - player;
+    m->pending_garbage[player] -= cancelled;
+    rows -= cancelled;
+    if (rows > max_pending_garbage - m->pending_garbage[opponent])
+        rows = max_pending_garbage - m->pending_garbage[opponent];
+    m->pending_garbage[opponent] += rows;
+}
+
+static void versus_step(versus_match *m, int player, const game_event *event)
+{
+    game *g = &m->games[player];
+    int lines = g->lines;
+    game_step(g, event);
+    m->changes[player] |= g->changes;
+    /* only a lock spawns the next piece */
+    if (!g->game_on || !(g->changes & next_piece_changed))
+        return;
+    lines = g->lines - lines;
+    if (lines)
+        send_garbage(m, player, garbage_rows_sent(lines));
+    else if (m->pending_garbage[player]) {
+        game_add_garbage(
+            g, m->pending_garbage[player],
+            next_garbage_hole(m, game_kernels(g)->width)
+        );
+        m->pending_garbage[player] = 0;
+        m->changes[player] |= g->changes;
+    }
+}
+
+void versus_frame(
+    versus_match *m, const game_action inputs[num_of_versus_players]
+)
+{
+    long time = (long)(m->frame + 1) * versus_frame_time;
+    int p;
+    for (p=0; p < num_of_versus_players; p++) {
+        game *g = &m->games[p];
+        if (inputs[p] != no_action) {
+            game_event event = { input_event, inputs[p], time };
+            versus_step(m, p, &event);
+        }
+        /* the gravity steps are made at their deadlines, not at the frame
+        time, so the frame length doesn't change the fall speed */
+        while (g->game_on && (g->gravity_deadline <= time)) {
+            game_event event = {
+                gravity_event, no_action, g->gravity_deadline
+            };
+            versus_step(m, p, &event);
+        }
+    }
+    m->frame++;
+}
+
+versus_result versus_outcome(const versus_match *m)
+{
+    bool first_on = m->games[0].game_on, second_on = m->games[1].game_on;
+    if (first_on && second_on)
+        return match_goes_on;
+    if (first_on)
+        return first_player_won;
+    if (second_on)
+        return second_player_won;
+    return match_drawn;
+}
@@ -0,0 +1,150 @@
+/* versus_link.c */
+
+#include "versus_link.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char versus_magic[4] = { 'T', 'V', 'S', '1' };
+
+static void loopback_address(struct sockaddr_in *address, int port)
+{
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+    address->sin_port = htons(port);
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static unsigned int random_seed()
+{
+    struct timespec ts;
+    unsigned int seed;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    seed = (unsigned int)ts.tv_nsec ^ ((unsigned int)ts.tv_sec << 16) ^
+        ((unsigned int)getpid() << 8);
+    return (seed) ? seed : 1;
+}
+
+void open_versus_link(versus_link *link, int local_port, int peer_port)
+{
+    struct sockaddr_in address;
+    if ((local_port == peer_port) || (local_port <= 0) || (peer_port <= 0) ||
+        (local_port > 65535) || (peer_port > 65535))
+    {
+        fprintf(stderr, "incorrect ports: %d and %d\n", local_port, peer_port);
+        exit(1);
+    }
+    link->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    loopback_address(&address, local_port);
+    if ((link->socket < 0) ||
+        (bind(link->socket, (struct sockaddr *)&address, sizeof(address)) <
+            0) ||
+        (fcntl(link->socket, F_SETFL, O_NONBLOCK) < 0))
+    {
+        perror("versus link");
+        exit(1);
+    }
+    loopback_address(&link->peer, peer_port);
+    link->local_player = (local_port < peer_port) ? 0 : 1;
+    link->local_seed = random_seed();
+    link->peer_seed = 0;
+    link->peer_seen = false;
+    link->inputs_confirmed = 0;
+    link->last_heard = 0;
+}
+
+void close_versus_link(versus_link *link)
+{
+    close(link->socket);
+}
+
+void send_versus_packet(versus_link *link, const rollback_session *s)
+{
+    versus_packet packet;
+    unsigned int frame, last = 0;
+    memcpy(packet.magic, versus_magic, sizeof(versus_magic));
+    packet.seed = link->local_seed;
+    packet.inputs_confirmed = 0;
+    packet.first_frame = 0;
+    packet.num_of_inputs = 0;
+    if (s) {
+        packet.inputs_confirmed = s->confirmed[1 - link->local_player];
+        last = s->confirmed[link->local_player];
+        packet.first_frame = link->inputs_confirmed;
+        if (last - packet.first_frame > versus_link_inputs)
+            packet.first_frame = last - versus_link_inputs;
+    }
+    for (frame = packet.first_frame; frame < last; frame++) {
+        packet.inputs[packet.num_of_inputs++] =
+            rollback_input(s, link->local_player, frame);
+    }
+    /* a full socket buffer only loses the packet, the next one repeats it */
+    sendto(
+        link->socket, &packet,
+        offsetof(versus_packet, inputs) + packet.num_of_inputs, 0,
+        (struct sockaddr *)&link->peer, sizeof(link->peer)
+    );
+}
+
+static void take_packet(
+    versus_link *link, rollback_session *s, const versus_packet *packet
+)
+{
+    unsigned int i, confirmed;
+    if (s) {
+        /* the other side is trusted with nothing but the actions */
+        for (i=0; i < packet->num_of_inputs; i++) {
+            set_rollback_input(
+                s, 1 - link->local_player, packet->first_frame + i,
+                (packet->inputs[i] <= shift_right) ?
+                packet->inputs[i] : no_action
+            );
+        }
+        /* it can't have confirmed the inputs not sent yet */
+        confirmed = packet->inputs_confirmed;
+        if (confirmed > s->confirmed[link->local_player])
+            confirmed = s->confirmed[link->local_player];
+        if (confirmed > link->inputs_confirmed)
+            link->inputs_confirmed = confirmed;
+    }
+}
+
+bool receive_versus_packets(versus_link *link, rollback_session *s, long time)
+{
+    versus_packet packet;
+    bool received = false;
+    ssize_t size;
+    while (
+        (size = recv(link->socket, &packet, sizeof(packet), 0)) >=
+        (ssize_t)offsetof(versus_packet, inputs)
+    )
+    {
+        if ((memcmp(packet.magic, versus_magic, sizeof(versus_magic)) != 0) ||
+            (packet.num_of_inputs > versus_link_inputs) ||
+            (size != (ssize_t)(
+                offsetof(versus_packet, inputs) + packet.num_of_inputs
+            )) ||
+            /* a packet of another match */
+            (link->peer_seen && (packet.seed != link->peer_seed)))
+        {
+            continue;
+        }
+        link->peer_seed = packet.seed;
+        link->peer_seen = true;
+        link->last_heard = time;
+        received = true;
+        take_packet(link, s, &packet);
+    }
+    return received;
+}
+
+unsigned int versus_link_seed(const versus_link *link)
+{
+    return link->local_seed ^ link->peer_seed;
+}
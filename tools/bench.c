@@ -0,0 +1,1064 @@
+/* bench.c */
+
+#include "arena.h"
+#include "board_net.h"
+#include "conflict_resolution.h"
+#include "finesse.h"
+#include "game.h"
+#include "policy.h"
+#include "rollback.h"
+#include "rollout.h"
+#include "rotation.h"
+#include "scheduler.h"
+#include "search.h"
+#include "versus.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum bench_consts {
+    /* a benchmark is repeated with twice the iterations until it runs for at
+    least this time */
+    min_bench_time_ns = 100000000,
+    /* then it's run this many times more and the fastest run is reported, the
+    slower ones were disturbed by the rest of the system */
+    num_of_bench_runs = 5,
+    /* the falling piece and the next piece */
+    bench_search_depth = 2,
+    /* the number of hosted games the memory footprint is reported for */
+    num_of_hosted_games = 1000000,
+    /* the slowdown in percent a comparison fails on, if not given */
+    default_threshold = 10,
+    /* the number of boards `net_eval` scores in one batch (a typical number
+    of placements) */
+    net_eval_batch = 32,
+    /* the moves played before the placements are tried, so the field isn't
+    empty */
+    finesse_warmup_moves = 20,
+    /* the games one scheduler runs in the `scheduled_step` benchmark and in
+    the scheduler check */
+    num_of_scheduled_games = 1024,
+    /* the simulated time the scheduler check runs for, in milliseconds, and
+    the time between its runs of the scheduler */
+    scheduler_check_time = 60000,
+    scheduler_check_tick = 16,
+    /* the matches the rollback check plays, the frames each one is cut at
+    and the most frames the other player's inputs come late by */
+    rollback_check_matches = 16,
+    rollback_check_frames = 4000,
+    max_check_input_delay = 7,
+    /* the rollouts per placement one evaluation of the `rollout` benchmark
+    makes */
+    bench_rollouts_per_placement = 4,
+    max_bench_name_size = 40,
+    max_csv_line_size = 512
+};
+
+/* runs the benchmarked operation `iterations` times */
+typedef void (*bench_body)(long iterations);
+
+typedef struct tag_bench_result {
+    const char *name;
+    long iterations;
+    double ns_per_op;
+} bench_result;
+
+typedef struct tag_bench_options {
+    const char *results_file, *history_file, *baseline_file, *net_file;
+    const char *commit, *flags;
+    double threshold;
+} bench_options;
+
+/* the benchmarks write here, so their work isn't optimized away */
+static volatile long sink;
+
+static struct_piece set_of_pieces[num_of_pieces];
+
+/* the field the piece benchmarks run on: the bottom rows are uneven */
+static field_row bench_field[max_field_height];
+
+/* the board net the net benchmarks run, if it's given */
+static board_net bench_net;
+
+static double current_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static unsigned int next_random(unsigned int *state)
+{
+    /* xorshift32 */
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void init_bench_field()
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    unsigned int state = 12345;
+    int y;
+    kernels->init_field(bench_field);
+    for (y = field_height - 6; y < field_height; y++) {
+        /* every row keeps at least one hole */
+        bench_field[y] = next_random(&state) & full_field_row;
+        bench_field[y] &= ~(1u << (next_random(&state) % field_width));
+    }
+}
+
+static void bench_rotate(long iterations)
+{
+    struct_piece t = set_of_pieces[t_piece], i = set_of_pieces[i_piece];
+    long n;
+    for (n=0; n < iterations; n++) {
+        /* `form.small` and `form.big` share the same address */
+        if (n & 1)
+            rotate(i.form.small, i.size);
+        else
+            rotate(t.form.small, t.size);
+    }
+    sink = t.form.small[1][1] + i.form.big[2][1];
+}
+
+static void bench_handle_rotation_conflicts(long iterations)
+{
+    long n, rotated = 0;
+    for (n=0; n < iterations; n++) {
+        struct_piece piece = set_of_pieces[n % num_of_pieces];
+        /* the rotated pieces reach the uneven rows */
+        piece.x_shift = (n >> 3) % (field_width - 3);
+        piece.y_decline = field_height - 12 + (n >> 2) % 4;
+        rotated += handle_rotation_conflicts(bench_field, &piece);
+    }
+    sink = rotated;
+}
+
+static void bench_cast_ghost(long iterations)
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    long n, declines = 0;
+    for (n=0; n < iterations; n++) {
+        piece_kind kind = n % num_of_pieces;
+        declines += kernels->landing_decline(
+            bench_field, kind, horizontal_1, (n >> 3) % (field_width - 3), 0
+        );
+    }
+    sink = declines;
+}
+
+static void bench_clear_lines(long iterations)
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    field_row lines_field[max_field_height], work[max_field_height];
+    long n, cleared = 0;
+    memcpy(lines_field, bench_field, sizeof(lines_field));
+    /* a tetris: 4 completed lines between the uneven ones */
+    lines_field[field_height - 1] = full_field_row;
+    lines_field[field_height - 3] = full_field_row;
+    lines_field[field_height - 4] = full_field_row;
+    lines_field[field_height - 6] = full_field_row;
+    for (n=0; n < iterations; n++) {
+        memcpy(work, lines_field, field_height * sizeof(field_row));
+        cleared += kernels->clear_completed_lines(work);
+    }
+    sink = cleared;
+}
+
+/* one operation is a burst of 4 garbage rows pushed under the bench field */
+static void bench_insert_garbage(long iterations)
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    field_row work[max_field_height];
+    long n, pushed_out = 0;
+    for (n=0; n < iterations; n++) {
+        memcpy(work, bench_field, field_height * sizeof(field_row));
+        pushed_out += kernels->insert_bottom_rows(
+            work, 4, full_field_row & ~(1u << (n % field_width)),
+            field_height - 6
+        );
+    }
+    sink = pushed_out + work[0];
+}
+
+/* the usual lock: the piece's rows are checked and none of them is completed,
+the full scan `clear_lines` makes isn't needed */
+static void bench_check_locked_lines(long iterations)
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    long n, cleared = 0;
+    for (n=0; n < iterations; n++) {
+        int last_row = field_height - 1 - (n & 1);
+        cleared += kernels->clear_locked_lines(
+            bench_field, last_row - 3, last_row, field_height - 6
+        );
+    }
+    sink = cleared;
+}
+
+static void bench_game_step(long iterations)
+{
+    const game_action actions[] = {
+        move_left, move_right, rotate_piece, soft_drop, hard_drop
+    };
+    const int num_of_actions = sizeof(actions) / sizeof(*actions);
+    unsigned int state = 2024, seed = 1;
+    game g;
+    long n, time = 0, score = 0;
+    init_game(&g, standard_field, seed, time);
+    for (n=0; n < iterations; n++) {
+        unsigned int r = next_random(&state);
+        game_event event = { gravity_event, no_action, ++time };
+        if (r % 4) {
+            event.kind = input_event;
+            event.action = actions[(r >> 8) % num_of_actions];
+        }
+        game_step(&g, &event);
+        if (!g.game_on) {
+            score += g.score;
+            init_game(&g, standard_field, ++seed, time);
+        }
+    }
+    sink = score + g.score;
+}
+
+/* one operation is a spawned piece moved to a wall in one step, the way a
+key held with the instant repeat rate moves it */
+static void bench_shift_to_wall(long iterations)
+{
+    game g;
+    long n, shifted = 0;
+    init_game(&g, standard_field, 1, 0);
+    for (n=0; n < iterations; n++) {
+        game_event event = {
+            input_event, (n & 1) ? shift_right : shift_left, 0
+        };
+        int x_shift = g.piece.x_shift;
+        game_step(&g, &event);
+        shifted += g.piece.x_shift - x_shift;
+        g.piece.x_shift = x_shift;
+    }
+    sink = shifted;
+}
+
+static void play_policy_moves(const player_policy *policy, long iterations)
+{
+    arena *a = get_thread_arena();
+    unsigned int seed = 1;
+    game g;
+    long n;
+    init_game(&g, standard_field, seed, 0);
+    for (n=0; n < iterations; n++) {
+        /* every move starts with an empty arena */
+        reset_arena(a);
+        if (!policy_move(policy, &g, a) || !g.game_on)
+            init_game(&g, standard_field, ++seed, 0);
+    }
+    sink = g.lines;
+}
+
+static void bench_search_move(long iterations)
+{
+    player_policy policy;
+    init_search_policy(
+        &policy, default_heuristic_weights(), search_policy_depth
+    );
+    play_policy_moves(&policy, iterations);
+}
+
+static void bench_net_move(long iterations)
+{
+    player_policy policy;
+    init_net_policy(&policy, &bench_net);
+    play_policy_moves(&policy, iterations);
+}
+
+/* one operation is one board scored */
+static void bench_net_eval(long iterations)
+{
+    const field_kernels *kernels = get_field_kernels(standard_field);
+    arena *a = get_thread_arena();
+    size_t mark = arena_mark(a);
+    float *features =
+        arena_alloc(a, net_eval_batch * board_net_inputs * sizeof(float));
+    float values[net_eval_batch], total = 0;
+    long n;
+    int i;
+    for (i=0; i < net_eval_batch; i++) {
+        board_features(
+            kernels, bench_field, i % 3, features + i * board_net_inputs
+        );
+        /* the boards differ a little */
+        features[i * board_net_inputs] += i * 0.01f;
+    }
+    for (n=0; n < iterations; n += net_eval_batch) {
+        evaluate_boards(&bench_net, features, net_eval_batch, values);
+        total += values[n % net_eval_batch];
+    }
+    arena_release(a, mark);
+    sink = total;
+}
+
+/* one operation is one placement of the falling piece applied to the game
+and reverted by its journal */
+static void bench_place_and_undo(long iterations)
+{
+    arena *a = get_thread_arena();
+    size_t mark = arena_mark(a);
+    player_policy policy;
+    placement *placements;
+    game_undo undo;
+    game g;
+    long n, total = 0;
+    int num_of_placements, i;
+    init_search_policy(&policy, default_heuristic_weights(), 1);
+    init_game(&g, standard_field, 1, 0);
+    for (i=0; i < finesse_warmup_moves; i++)
+        policy_move(&policy, &g, a);
+    placements = enumerate_placements(
+        game_kernels(&g), g.field, g.piece.kind, a, &num_of_placements
+    );
+    for (n=0; n < iterations; n++) {
+        game_place_piece_journaled(
+            &g, &placements[n % num_of_placements], &undo
+        );
+        total += g.lines;
+        game_undo_placement(&g, &undo);
+    }
+    arena_release(a, mark);
+    sink = total;
+}
+
+/* the actions a versus benchmark presses at random: no drops, so the match
+lasts long */
+static game_action random_versus_action(unsigned int *state)
+{
+    const game_action actions[] = {
+        no_action, move_left, move_right, rotate_piece
+    };
+    return actions[next_random(state) % (sizeof(actions) / sizeof(*actions))];
+}
+
+static void bench_versus_frame(long iterations)
+{
+    static versus_match m;
+    unsigned int state = 2024, seed = 1;
+    long n, total = 0;
+    init_versus_match(&m, standard_field, seed);
+    for (n=0; n < iterations; n++) {
+        game_action inputs[num_of_versus_players];
+        inputs[0] = random_versus_action(&state);
+        inputs[1] = random_versus_action(&state);
+        versus_frame(&m, inputs);
+        if (versus_outcome(&m) != match_goes_on) {
+            total += m.frame;
+            init_versus_match(&m, standard_field, ++seed);
+        }
+    }
+    sink = total + m.frame;
+}
+
+/* one operation is one snapshot of a match taken and restored */
+static void bench_snapshot_restore(long iterations)
+{
+    static rollback_session s;
+    long n, total = 0;
+    init_rollback_session(&s, standard_field, 1);
+    for (n=0; n < iterations; n++) {
+        s.snapshots[n % max_rollback_frames] = s.match;
+        s.match.frame++;
+        s.match = s.snapshots[(n * 7) % max_rollback_frames];
+        total += s.match.frame;
+    }
+    sink = total;
+}
+
+/* one operation is one frame of a match the other player's inputs come to
+`max_rollback_frames - 1` frames late, every one of them mispredicted: the
+deepest rollback a session makes, then the new frame */
+static void bench_worst_rollback(long iterations)
+{
+    static rollback_session s;
+    unsigned int state = 2024, seed = 1;
+    long n, total = 0;
+    init_rollback_session(&s, standard_field, seed);
+    for (n=0; n < iterations; n++) {
+        set_rollback_input(
+            &s, 0, s.confirmed[0], random_versus_action(&state)
+        );
+        if (s.match.frame + 1 >= s.confirmed[1] + max_rollback_frames) {
+            game_action action = random_versus_action(&state);
+            if (action == no_action)
+                action = move_left;
+            set_rollback_input(&s, 1, s.confirmed[1], action);
+        }
+        advance_rollback(&s);
+        if (versus_outcome(&s.match) != match_goes_on) {
+            total += s.match.frame;
+            init_rollback_session(&s, standard_field, ++seed);
+        }
+    }
+    sink = total + s.max_rollback_depth;
+}
+
+/* the game the rollout benchmarks evaluate: some pieces are down already */
+static void init_rollout_bench_game(game *g)
+{
+    arena *a = get_thread_arena();
+    player_policy policy;
+    int i;
+    init_search_policy(&policy, default_heuristic_weights(), 1);
+    init_game(g, standard_field, 1, 0);
+    for (i=0; i < finesse_warmup_moves; i++) {
+        reset_arena(a);
+        policy_move(&policy, g, a);
+    }
+    reset_arena(a);
+}
+
+/* one operation is one rollout: the placements are evaluated on every
+online CPU, a fixed number of rollouts each, until enough have been made */
+static void bench_rollout(long iterations)
+{
+    static rollout_stats stats[max_num_of_placements];
+    rollout_config config;
+    game g;
+    long done = 0;
+    init_rollout_bench_game(&g);
+    init_rollout_config(&config);
+    config.budget_ms = 0;
+    config.max_rollouts =
+        config.num_of_threads * bench_rollouts_per_placement;
+    while (done < iterations) {
+        int n = evaluate_placements(&g, &config, stats), i;
+        for (i=0; i < n; i++)
+            done += stats[i].num_of_rollouts;
+        config.seed++;
+    }
+    sink = done;
+}
+
+/* one operation is one game step made by the scheduler: every millisecond
+one action is posted to a random game, and the games whose gravity deadline
+has come fall */
+static void bench_scheduled_step(long iterations)
+{
+    const game_action actions[] = {
+        move_left, move_right, rotate_piece, soft_drop, hard_drop
+    };
+    const int num_of_actions = sizeof(actions) / sizeof(*actions);
+    static scheduler s;
+    unsigned int state = 2024, seed = 1;
+    long steps = 0, time = 0;
+    init_scheduler(&s, num_of_scheduled_games, standard_field, seed, time);
+    while (steps < iterations) {
+        unsigned int r = next_random(&state);
+        post_action(
+            &s, r % num_of_scheduled_games,
+            actions[(r >> 16) % num_of_actions]
+        );
+        steps += run_scheduler(&s, ++time, NULL, NULL);
+        if (next_deadline(&s) < 0) {
+            free_scheduler(&s);
+            init_scheduler(
+                &s, num_of_scheduled_games, standard_field, ++seed, time
+            );
+        }
+    }
+    free_scheduler(&s);
+    sink = steps;
+}
+
+/* one operation is one path to one placement of the falling piece */
+static void bench_finesse_path(long iterations)
+{
+    arena *a = get_thread_arena();
+    size_t mark = arena_mark(a);
+    player_policy policy;
+    placement *placements;
+    finesse_path path;
+    game g;
+    long n, total = 0;
+    int num_of_placements, i;
+    init_search_policy(&policy, default_heuristic_weights(), 1);
+    init_game(&g, standard_field, 1, 0);
+    for (i=0; i < finesse_warmup_moves; i++)
+        policy_move(&policy, &g, a);
+    placements = enumerate_placements(
+        game_kernels(&g), g.field, g.piece.kind, a, &num_of_placements
+    );
+    for (n=0; n < iterations; n++) {
+        if (find_finesse_path(&g, &placements[n % num_of_placements], &path))
+            total += path.length;
+    }
+    arena_release(a, mark);
+    sink = total;
+}
+
+static const struct {
+    const char *name;
+    bench_body body;
+    /* whether the benchmark runs the board net */
+    bool needs_net;
+} benchmarks[] = {
+    { "rotate", bench_rotate, false },
+    { "handle_rotation_conflicts", bench_handle_rotation_conflicts, false },
+    { "cast_ghost", bench_cast_ghost, false },
+    { "clear_lines", bench_clear_lines, false },
+    { "check_locked_lines", bench_check_locked_lines, false },
+    { "insert_garbage", bench_insert_garbage, false },
+    { "game_step", bench_game_step, false },
+    { "shift_to_wall", bench_shift_to_wall, false },
+    { "scheduled_step", bench_scheduled_step, false },
+    { "search_move", bench_search_move, false },
+    { "rollout", bench_rollout, false },
+    { "place_and_undo", bench_place_and_undo, false },
+    { "finesse_path", bench_finesse_path, false },
+    { "versus_frame", bench_versus_frame, false },
+    { "snapshot_restore", bench_snapshot_restore, false },
+    { "worst_rollback", bench_worst_rollback, false },
+    { "net_eval", bench_net_eval, true },
+    { "net_move", bench_net_move, true }
+};
+
+enum {
+    num_of_benchmarks = sizeof(benchmarks) / sizeof(*benchmarks)
+};
+
+static double run_bench(bench_body body, long iterations)
+{
+    double start = current_time_ns();
+    body(iterations);
+    return current_time_ns() - start;
+}
+
+static bench_result measure(const char *name, bench_body body)
+{
+    bench_result result = { name, 1, 0 };
+    double elapsed, fastest;
+    int i;
+    while (run_bench(body, result.iterations) < min_bench_time_ns)
+        result.iterations *= 2;
+    fastest = run_bench(body, result.iterations);
+    for (i=1; i < num_of_bench_runs; i++) {
+        elapsed = run_bench(body, result.iterations);
+        if (elapsed < fastest)
+            fastest = elapsed;
+    }
+    result.ns_per_op = fastest / result.iterations;
+    return result;
+}
+
+static void write_csv(
+    FILE *f, const bench_result *results, int num_of_results,
+    const bench_options *options
+)
+{
+    int i;
+    for (i=0; i < num_of_results; i++) {
+        fprintf(
+            f, "%s,%ld,%.3f,%.1f,%s,\"%s\"\n",
+            results[i].name, results[i].iterations, results[i].ns_per_op,
+            1e9 / results[i].ns_per_op, options->commit, options->flags
+        );
+    }
+}
+
+static const char csv_header[] =
+    "benchmark,iterations,ns_per_op,ops_per_sec,commit,flags\n";
+
+static void save_results(
+    const char *file_name, const char *mode, const bench_result *results,
+    int num_of_results, const bench_options *options
+)
+{
+    FILE *f = fopen(file_name, mode);
+    if (!f) {
+        perror(file_name);
+        exit(1);
+    }
+    /* a new or truncated file starts with the header */
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0)
+        fputs(csv_header, f);
+    write_csv(f, results, num_of_results, options);
+    fclose(f);
+}
+
+static bool baseline_ns_per_op(
+    const char *file_name, const char *name, double *ns_per_op
+)
+{
+    char line[max_csv_line_size], bench_name[max_bench_name_size];
+    bool found = false;
+    long iterations;
+    double value;
+    FILE *f = fopen(file_name, "r");
+    if (!f) {
+        perror(file_name);
+        fprintf(stderr, "run `make bench-baseline` to store a baseline\n");
+        exit(1);
+    }
+    /* the last row of the benchmark wins */
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%39[^,],%ld,%lf", bench_name, &iterations, &value)
+            != 3)
+        {
+            continue;
+        }
+        if (strcmp(bench_name, name) == 0) {
+            *ns_per_op = value;
+            found = true;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+static int compare_with_baseline(
+    const bench_result *results, int num_of_results,
+    const bench_options *options
+)
+{
+    int i, regressions = 0;
+    printf("\ncompared to %s:\n", options->baseline_file);
+    for (i=0; i < num_of_results; i++) {
+        double base, change;
+        if (!baseline_ns_per_op(options->baseline_file, results[i].name, &base))
+        {
+            printf("%-28s no baseline\n", results[i].name);
+            continue;
+        }
+        change = (results[i].ns_per_op - base) / base * 100;
+        printf(
+            "%-28s %12.1f -> %12.1f ns/op %+7.1f%%%s\n",
+            results[i].name, base, results[i].ns_per_op, change,
+            (change > options->threshold) ? "  REGRESSION" : ""
+        );
+        if (change > options->threshold)
+            regressions++;
+    }
+    if (regressions) {
+        printf(
+            "%d benchmark(s) slowed down by more than %.1f%%\n",
+            regressions, options->threshold
+        );
+    }
+    return regressions;
+}
+
+/* the game records are compared member by member, the padding between them
+and the preview slots past the previewed pieces are left as they were */
+static bool same_games(const game *a, const game *b)
+{
+    return (a->gravity_deadline == b->gravity_deadline) &&
+        (a->score == b->score) && (a->lines == b->lines) &&
+        (a->rng_state == b->rng_state) &&
+        !memcmp(&a->piece, &b->piece, sizeof(a->piece)) &&
+        (a->preview_head == b->preview_head) &&
+        (a->num_of_previews == b->num_of_previews) &&
+        !memcmp(a->preview, b->preview, a->num_of_previews) &&
+        (a->level == b->level) &&
+        (a->lines_since_level_up == b->lines_since_level_up) &&
+        (a->size == b->size) && (a->stack_top == b->stack_top) &&
+        (a->game_on == b->game_on) && (a->changes == b->changes) &&
+        (a->lock_delay == b->lock_delay) &&
+        (a->move_reset_limit == b->move_reset_limit) &&
+        (a->lock_resets == b->lock_resets) && (a->landed == b->landed) &&
+        (a->cleared_top == b->cleared_top) &&
+        (a->cleared_lines == b->cleared_lines) &&
+        !memcmp(a->field, b->field, sizeof(a->field));
+}
+
+/* the steps the scheduler made for every game */
+static void count_scheduled_step(int game_id, const game *g, void *ctx)
+{
+    long *steps = ctx;
+    (void)g;
+    steps[game_id]++;
+}
+
+/* runs the games through the scheduler with random actions posted to them
+and steps copies of the same games directly by the same events: the games,
+the steps made and the next deadline must be the same after every run */
+static bool check_scheduler()
+{
+    const game_action actions[] = {
+        move_left, move_right, rotate_piece, soft_drop, hard_drop
+    };
+    const int num_of_actions = sizeof(actions) / sizeof(*actions);
+    static scheduler s;
+    static game direct[num_of_scheduled_games];
+    static long scheduled_steps[num_of_scheduled_games],
+        direct_steps[num_of_scheduled_games];
+    unsigned int state = 2024;
+    long time, total = 0;
+    int i;
+    init_scheduler(&s, num_of_scheduled_games, standard_field, 1, 0);
+    memcpy(direct, s.games, sizeof(direct));
+    memset(scheduled_steps, 0, sizeof(scheduled_steps));
+    memset(direct_steps, 0, sizeof(direct_steps));
+    for (time = scheduler_check_tick; time <= scheduler_check_time;
+        time += scheduler_check_tick)
+    {
+        long deadline = -1;
+        for (i=0; i < num_of_scheduled_games; i++) {
+            game_event event = { input_event, no_action, time };
+            int posted = (next_random(&state) % 4) ?
+                0 : 1 + next_random(&state) % 3;
+            /* the actions the scheduler queues are applied right away, in
+            the same order, the falls after them; the ones queued behind a
+            game over are dropped */
+            while (posted--) {
+                event.action = actions[next_random(&state) % num_of_actions];
+                if (post_action(&s, i, event.action) && direct[i].game_on) {
+                    game_step(&direct[i], &event);
+                    direct_steps[i]++;
+                }
+            }
+            event.kind = gravity_event;
+            event.action = no_action;
+            while (direct[i].game_on && (direct[i].gravity_deadline <= time)) {
+                game_step(&direct[i], &event);
+                direct_steps[i]++;
+            }
+            if (direct[i].game_on &&
+                ((deadline < 0) || (direct[i].gravity_deadline < deadline)))
+            {
+                deadline = direct[i].gravity_deadline;
+            }
+        }
+        total += run_scheduler(&s, time, count_scheduled_step, scheduled_steps);
+        for (i=0; i < num_of_scheduled_games; i++) {
+            if (!same_games(&s.games[i], &direct[i]) ||
+                (scheduled_steps[i] != direct_steps[i]))
+            {
+                printf(
+                    "check scheduler: game %d differs at %ld ms\n", i, time
+                );
+                free_scheduler(&s);
+                return false;
+            }
+        }
+        if (next_deadline(&s) != deadline) {
+            printf(
+                "check scheduler: next deadline %ld, not %ld, at %ld ms\n",
+                next_deadline(&s), deadline, time
+            );
+            free_scheduler(&s);
+            return false;
+        }
+    }
+    printf(
+        "check scheduler: %d games, %ld steps, same as stepped directly\n",
+        num_of_scheduled_games, total
+    );
+    free_scheduler(&s);
+    return true;
+}
+
+/* the `changes` flags of the matches are left out: a rollback sets them all,
+so the board simulated again is drawn anew */
+static bool same_matches(const versus_match *a, const versus_match *b)
+{
+    int p;
+    for (p=0; p < num_of_versus_players; p++) {
+        if (!same_games(&a->games[p], &b->games[p]) ||
+            (a->pending_garbage[p] != b->pending_garbage[p]))
+        {
+            return false;
+        }
+    }
+    return (a->garbage_rng == b->garbage_rng) && (a->frame == b->frame);
+}
+
+/* the action a player of the rollback check presses: the next key to the
+placement the search chose, at some frames only, so some predictions of no
+action are right, and now and then a random key */
+static game_action check_player_action(
+    const player_policy *policy, const game *g, bool new_piece,
+    placement *target, bool *has_target, unsigned int *state
+)
+{
+    const game_action random_actions[] = {
+        move_left, move_right, rotate_piece, soft_drop
+    };
+    unsigned int r = next_random(state);
+    finesse_path path;
+    if (new_piece) {
+        reset_arena(get_thread_arena());
+        *has_target = policy->choose(policy, g, get_thread_arena(), target);
+    }
+    if (!g->game_on || (r % 3))
+        return no_action;
+    if (!(r % 8))
+        return random_actions[(r >> 8) % 4];
+    return (*has_target && find_finesse_path(g, target, &path)) ?
+        path.actions[0] : hard_drop;
+}
+
+/* plays the match directly by the actions the players choose, every frame
+kept, and one frame more with nothing pressed (a rollback found at the last
+frame simulates the frame after it too); returns the frame the match ended
+at */
+static unsigned int play_direct_match(
+    unsigned int seed, game_action (*inputs)[num_of_versus_players],
+    versus_match *frames, unsigned int *state
+)
+{
+    placement targets[num_of_versus_players];
+    bool has_target[num_of_versus_players];
+    player_policy policy;
+    unsigned int f = 0;
+    int p;
+    init_search_policy(&policy, default_heuristic_weights(), 1);
+    init_versus_match(&frames[0], standard_field, seed);
+    while ((f < rollback_check_frames) &&
+        (versus_outcome(&frames[f]) == match_goes_on))
+    {
+        for (p=0; p < num_of_versus_players; p++) {
+            inputs[f][p] = check_player_action(
+                &policy, &frames[f].games[p],
+                !f || (frames[f].changes[p] & next_piece_changed),
+                &targets[p], &has_target[p], state
+            );
+        }
+        frames[f + 1] = frames[f];
+        /* the flags tell the spawns of this frame only */
+        frames[f + 1].changes[0] = frames[f + 1].changes[1] = 0;
+        versus_frame(&frames[f + 1], inputs[f]);
+        f++;
+    }
+    inputs[f][0] = inputs[f][1] = no_action;
+    frames[f + 1] = frames[f];
+    versus_frame(&frames[f + 1], inputs[f]);
+    return f;
+}
+
+/* plays matches through a rollback session, the local player's inputs
+confirmed at their frames and the other player's ones coming up to
+`max_check_input_delay` frames late, and the same matches by the same inputs
+directly: every frame the session has all the inputs for, and the last one,
+must be the same */
+static bool check_rollback()
+{
+    static game_action
+        inputs[rollback_check_frames + 1][num_of_versus_players];
+    static versus_match direct[rollback_check_frames + 2];
+    static unsigned int arrival[rollback_check_frames];
+    static rollback_session s;
+    unsigned int state = 2024, seed, frames = 0;
+    unsigned long rollbacks = 0, max_depth = 0;
+    for (seed=1; seed <= rollback_check_matches; seed++) {
+        unsigned int last, tick, delivered = 0, f;
+        last = play_direct_match(seed, inputs, direct, &state);
+        for (f=0; f < last; f++) {
+            unsigned int at = f + next_random(&state) %
+                (max_check_input_delay + 1);
+            /* the inputs come in order */
+            arrival[f] = (f && (arrival[f-1] > at)) ? arrival[f-1] : at;
+        }
+        init_rollback_session(&s, standard_field, seed);
+        for (tick=0;
+            (s.match.frame < last) || (delivered < last) || s.rollback_due;
+            tick++)
+        {
+            if (tick < last)
+                set_rollback_input(&s, 0, tick, inputs[tick][0]);
+            while ((delivered < last) && (arrival[delivered] <= tick)) {
+                set_rollback_input(&s, 1, delivered, inputs[delivered][1]);
+                delivered++;
+            }
+            /* the rollback the last inputs call for is made once they've
+            all come */
+            if ((s.match.frame < last) ||
+                (s.rollback_due && (delivered == last)))
+            {
+                advance_rollback(&s);
+            }
+            if ((s.match.frame <= s.confirmed[0]) &&
+                (s.match.frame <= s.confirmed[1]) && !s.rollback_due &&
+                !same_matches(&s.match, &direct[s.match.frame]))
+            {
+                printf(
+                    "check rollback: match %u differs at frame %u\n",
+                    seed, s.match.frame
+                );
+                return false;
+            }
+        }
+        if (!same_matches(&s.match, &direct[s.match.frame])) {
+            printf("check rollback: match %u differs at its end\n", seed);
+            return false;
+        }
+        frames += last;
+        rollbacks += s.rollbacks;
+        if (s.max_rollback_depth > max_depth)
+            max_depth = s.max_rollback_depth;
+    }
+    /* a check without a rollback would check nothing */
+    if (!rollbacks) {
+        printf("check rollback: no match was rolled back\n");
+        return false;
+    }
+    printf(
+        "check rollback: %d matches, %u frames, %lu rollbacks up to %lu "
+        "frames deep, same as simulated directly\n",
+        rollback_check_matches, frames, rollbacks, max_depth
+    );
+    return true;
+}
+
+static void print_arena_counters(const arena *a)
+{
+    printf(
+        "arena: %lu allocations, %zu bytes allocated, %zu bytes peak, "
+        "%lu resets, %zu bytes capacity\n",
+        a->num_of_allocations, a->bytes_allocated, a->peak_used,
+        a->num_of_resets, a->capacity
+    );
+}
+
+static void print_memory_footprint()
+{
+    /* a scheduler keeps a record, a slot, a heap entry and a woken list entry
+    per game */
+    size_t per_game = sizeof(game) + sizeof(game_slot) + 2 * sizeof(int);
+    printf(
+        "memory: game record %zu bytes (%zu cache lines), "
+        "game slot %zu bytes\n",
+        sizeof(game), sizeof(game) / cache_line_size, sizeof(game_slot)
+    );
+    printf(
+        "memory: %zu bytes per hosted game, %.1f MiB per %d games\n",
+        per_game, (double)per_game * num_of_hosted_games / (1 << 20),
+        num_of_hosted_games
+    );
+    printf(
+        "memory: versus match %zu bytes, rollback session %zu bytes "
+        "(%d snapshots)\n",
+        sizeof(versus_match), sizeof(rollback_session), max_rollback_frames
+    );
+}
+
+/* the rollouts the default evaluation makes in its time budget */
+static void print_rollout_rate()
+{
+    static rollout_stats stats[max_num_of_placements];
+    rollout_config config;
+    game g;
+    long total = 0;
+    int n, i;
+    init_rollout_bench_game(&g);
+    init_rollout_config(&config);
+    n = evaluate_placements(&g, &config, stats);
+    for (i=0; i < n; i++)
+        total += stats[i].num_of_rollouts;
+    printf(
+        "rollouts: %ld of %d placements in a %ld ms budget on %d threads "
+        "(%.0f rollouts/s)\n",
+        total, n, config.budget_ms, config.num_of_threads,
+        total * 1000.0 / config.budget_ms
+    );
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-o results.csv] [-a history.csv] [-b baseline.csv]\n"
+        "       [-t threshold_percent] [-c commit] [-f compiler_flags]\n"
+        "       [-n board_net_weights]\n",
+        program
+    );
+}
+
+static void parse_options(int argc, char **argv, bench_options *options)
+{
+    int opt;
+    options->results_file = NULL;
+    options->history_file = NULL;
+    options->baseline_file = NULL;
+    options->net_file = NULL;
+    options->commit = "unknown";
+    options->flags = "unknown";
+    options->threshold = default_threshold;
+    while ((opt = getopt(argc, argv, "o:a:b:t:c:f:n:")) != -1) {
+        switch (opt) {
+            case 'o':
+                options->results_file = optarg;
+                break;
+            case 'a':
+                options->history_file = optarg;
+                break;
+            case 'b':
+                options->baseline_file = optarg;
+                break;
+            case 't':
+                options->threshold = atof(optarg);
+                break;
+            case 'c':
+                options->commit = optarg;
+                break;
+            case 'f':
+                options->flags = optarg;
+                break;
+            case 'n':
+                options->net_file = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_options options;
+    bench_result results[num_of_benchmarks];
+    game g;
+    int i, n = 0;
+    parse_options(argc, argv, &options);
+    /* the engine tables are built by the 1st game */
+    init_game(&g, standard_field, 1, 0);
+    init_finesse_tables();
+    init_set_of_pieces(set_of_pieces);
+    init_bench_field();
+    if (options.net_file)
+        load_board_net(&bench_net, options.net_file);
+    /* the engine has to be right before it's measured */
+    if (!check_scheduler() || !check_rollback())
+        return 1;
+    printf("%-28s %12s %14s\n", "benchmark", "ns/op", "ops/s");
+    for (i=0; i < num_of_benchmarks; i++) {
+        if (benchmarks[i].needs_net && !options.net_file)
+            continue;
+        results[n] = measure(benchmarks[i].name, benchmarks[i].body);
+        printf(
+            "%-28s %12.1f %14.0f\n",
+            results[n].name, results[n].ns_per_op, 1e9 / results[n].ns_per_op
+        );
+        n++;
+    }
+    print_arena_counters(get_thread_arena());
+    print_memory_footprint();
+    print_rollout_rate();
+    if (options.results_file)
+        save_results(options.results_file, "w", results, n, &options);
+    if (options.history_file)
+        save_results(options.history_file, "a", results, n, &options);
+    free_thread_arena();
+    if (options.net_file)
+        unload_board_net(&bench_net);
+    if (options.baseline_file && compare_with_baseline(results, n, &options))
+        return 1;
+    return 0;
+}
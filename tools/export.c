@@ -0,0 +1,235 @@
+/* export.c */
+
+#include "arena.h"
+#include "board_net.h"
+#include "game.h"
+#include "policy.h"
+#include "search.h"
+#include "training_data.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+enum export_consts {
+    max_export_threads = 64,
+    default_export_games = 64,
+    /* a game is cut at this many pieces, the good policies play forever */
+    default_export_max_pieces = 2000,
+    default_export_depth = 1
+};
+
+typedef struct tag_export_options {
+    int games, max_pieces, depth, num_of_threads;
+    /* the rollouts per placement labelling the decisions (0 - the search or
+    the net decides) */
+    long rollouts;
+    unsigned int seed;
+    const char *output_file, *weights_file, *net_file;
+} export_options;
+
+/* the games the threads share */
+typedef struct tag_export_work {
+    const export_options *options;
+    const player_policy *policy;
+    training_data_file *file;
+    pthread_mutex_t lock;
+    int next_game;
+} export_work;
+
+static double current_time_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* plays the game the way `policy_move` does, recording every decision */
+static void export_game(
+    const player_policy *policy, const export_options *options,
+    int game_index, arena *a, training_data_buffer *b
+)
+{
+    /* the seed replays the game, so it tells the game from the others */
+    unsigned int seed = options->seed + game_index;
+    game g;
+    int pieces;
+    init_game(&g, standard_field, seed, 0);
+    for (pieces=0; g.game_on && (pieces < options->max_pieces); pieces++) {
+        game before = g;
+        placement move;
+        if (!policy->choose(policy, &g, a, &move) ||
+            !game_place_piece(&g, &move))
+        {
+            break;
+        }
+        record_decision(b, seed, &before, &move, &g);
+    }
+}
+
+static void *run_export_worker(void *arg)
+{
+    export_work *work = arg;
+    arena *a = get_thread_arena();
+    training_data_buffer b;
+    init_training_data_buffer(&b, work->file);
+    for (;;) {
+        int game_index;
+        pthread_mutex_lock(&work->lock);
+        game_index = work->next_game++;
+        pthread_mutex_unlock(&work->lock);
+        if (game_index >= work->options->games)
+            break;
+        export_game(work->policy, work->options, game_index, a, &b);
+    }
+    free_training_data_buffer(&b);
+    free_thread_arena();
+    return NULL;
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-o training_data] [-w heuristic_weights | -n board_net]\n"
+        "       [-g games] [-m max_pieces] [-d search_depth] [-j threads]\n"
+        "       [-s seed] [-r rollouts_per_placement]\n",
+        program
+    );
+}
+
+static int online_cpus()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus < 1) ? 1 :
+        (cpus > max_export_threads) ? max_export_threads : cpus;
+}
+
+static void parse_options(int argc, char **argv, export_options *options)
+{
+    int opt;
+    options->games = default_export_games;
+    options->max_pieces = default_export_max_pieces;
+    options->depth = default_export_depth;
+    options->num_of_threads = online_cpus();
+    options->rollouts = 0;
+    options->seed = 1;
+    options->output_file = "training_data.ttd";
+    options->weights_file = NULL;
+    options->net_file = NULL;
+    while ((opt = getopt(argc, argv, "o:w:n:g:m:d:j:s:r:")) != -1) {
+        switch (opt) {
+            case 'o':
+                options->output_file = optarg;
+                break;
+            case 'w':
+                options->weights_file = optarg;
+                break;
+            case 'n':
+                options->net_file = optarg;
+                break;
+            case 'g':
+                options->games = atoi(optarg);
+                break;
+            case 'm':
+                options->max_pieces = atoi(optarg);
+                break;
+            case 'd':
+                options->depth = atoi(optarg);
+                break;
+            case 'j':
+                options->num_of_threads = atoi(optarg);
+                break;
+            case 's':
+                options->seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                options->rollouts = atol(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    if ((options->games < 1) || (options->max_pieces < 1) ||
+        (options->num_of_threads < 1) ||
+        (options->num_of_threads > max_export_threads) ||
+        (options->rollouts < 0) ||
+        (options->weights_file && options->net_file) ||
+        (options->rollouts && options->net_file))
+    {
+        print_usage(argv[0]);
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    export_options options;
+    export_work work;
+    training_data_file file;
+    heuristic_weights weights = *default_heuristic_weights();
+    board_net net;
+    rollout_config rollouts;
+    player_policy policy;
+    pthread_t threads[max_export_threads];
+    unsigned long long first_record;
+    double start, elapsed;
+    int i;
+    game g;
+    parse_options(argc, argv, &options);
+    /* the engine tables are built by the 1st game, before the threads */
+    init_game(&g, standard_field, 1, 0);
+    if (options.net_file) {
+        load_board_net(&net, options.net_file);
+        init_net_policy(&policy, &net);
+    } else {
+        if (options.weights_file)
+            load_heuristic_weights(options.weights_file, &weights);
+        init_search_policy(&policy, &weights, options.depth);
+    }
+    if (options.rollouts) {
+        /* a fixed number of rollouts and one rollout thread per export
+        thread, so the labels don't depend on the machine's speed */
+        init_rollout_config(&rollouts);
+        rollouts.num_of_threads = 1;
+        rollouts.budget_ms = 0;
+        rollouts.max_rollouts = options.rollouts;
+        rollouts.seed = options.seed;
+        rollouts.weights = &weights;
+        init_rollout_policy(&policy, &rollouts);
+    }
+    open_training_data(&file, options.output_file, standard_field);
+    first_record = file.num_of_records;
+    work.options = &options;
+    work.policy = &policy;
+    work.file = &file;
+    work.next_game = 0;
+    pthread_mutex_init(&work.lock, NULL);
+    start = current_time_s();
+    for (i=0; i < options.num_of_threads; i++) {
+        if (pthread_create(&threads[i], NULL, run_export_worker, &work) != 0) {
+            fprintf(
+                stderr, "%s:%d: an export thread can't be started\n",
+                __FILE__, __LINE__
+            );
+            exit(1);
+        }
+    }
+    for (i=0; i < options.num_of_threads; i++)
+        pthread_join(threads[i], NULL);
+    elapsed = current_time_s() - start;
+    printf(
+        "%s: %llu decisions of %d games by the %s policy in %.2fs "
+        "(%.0f decisions/s), %llu in the file\n",
+        options.output_file, file.num_of_records - first_record,
+        options.games, policy.name, elapsed,
+        (file.num_of_records - first_record) / elapsed, file.num_of_records
+    );
+    pthread_mutex_destroy(&work.lock);
+    close_training_data(&file);
+    if (options.net_file)
+        unload_board_net(&net);
+    return 0;
+}
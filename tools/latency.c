@@ -0,0 +1,576 @@
+/* latency.c */
+
+#define _XOPEN_SOURCE 600
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+enum latency_consts {
+    /* the terminal the game is started in, big enough for every mode */
+    terminal_rows = 50,
+    terminal_cols = 120,
+    /* the longest escape sequence parameter list kept */
+    max_csi_params = 16,
+    /* the output coming within this time after the previous output is the
+    same frame, in microseconds */
+    frame_gap_us = 1000,
+    /* the quiet time the game is given to draw its first screen, in
+    milliseconds */
+    startup_quiet_time = 300,
+    /* how long the game is given to exit after Esc, in milliseconds */
+    exit_timeout = 2000,
+    default_samples = 200,
+    /* the mean time between two keys and the longest wait for the screen
+    to answer one, in milliseconds */
+    default_key_interval = 50,
+    default_answer_timeout = 500,
+    initial_frames_capacity = 1024
+};
+
+typedef struct tag_latency_options {
+    const char *game_path;
+    /* the game's own options */
+    char **game_args;
+    int num_of_game_args;
+    int samples, key_interval, answer_timeout;
+} latency_options;
+
+typedef enum tag_parser_state {
+    ground_state, escape_state, csi_state, charset_state
+} parser_state;
+
+/* the part of a terminal the game's output is replayed on: the characters of
+the cells and the cursor, the colors and the modes are ignored */
+typedef struct tag_terminal {
+    char cells[terminal_rows][terminal_cols];
+    int y, x;
+    parser_state state;
+    int params[max_csi_params], num_of_params;
+    bool private_csi;
+    /* set when a cell gets another character */
+    bool changed;
+} terminal;
+
+/* the bytes of every frame the game has written */
+typedef struct tag_frame_log {
+    double *bytes;
+    long count, capacity;
+    /* the frame being written and the time its last output came at */
+    long current_bytes;
+    double last_output_us;
+} frame_log;
+
+typedef struct tag_game_process {
+    pid_t pid;
+    /* the master side of the pseudo-terminal */
+    int fd;
+} game_process;
+
+static double current_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void init_terminal(terminal *t)
+{
+    memset(t->cells, ' ', sizeof(t->cells));
+    t->y = t->x = 0;
+    t->state = ground_state;
+    t->num_of_params = 0;
+    t->private_csi = false;
+    t->changed = false;
+}
+
+static int clamp(int value, int min, int max)
+{
+    return (value < min) ? min : (value > max) ? max : value;
+}
+
+static void set_cell(terminal *t, int y, int x, char c)
+{
+    if (t->cells[y][x] != c) {
+        t->cells[y][x] = c;
+        t->changed = true;
+    }
+}
+
+static void put_char(terminal *t, char c)
+{
+    if (t->x >= terminal_cols) {
+        t->x = 0;
+        t->y = clamp(t->y + 1, 0, terminal_rows - 1);
+    }
+    set_cell(t, t->y, t->x, c);
+    t->x++;
+}
+
+static void erase(terminal *t, int y, int from_x, int to_x)
+{
+    int x;
+    for (x=from_x; x < to_x; x++)
+        set_cell(t, y, x, ' ');
+}
+
+/* the n-th parameter, `value` if it's missing or 0 */
+static int param(const terminal *t, int n, int value)
+{
+    return ((n < t->num_of_params) && t->params[n]) ? t->params[n] : value;
+}
+
+static void erase_display(terminal *t, int mode)
+{
+    int y;
+    if (mode == 0) {
+        erase(t, t->y, t->x, terminal_cols);
+        for (y=t->y + 1; y < terminal_rows; y++)
+            erase(t, y, 0, terminal_cols);
+    } else if (mode == 1) {
+        erase(t, t->y, 0, t->x + 1);
+        for (y=0; y < t->y; y++)
+            erase(t, y, 0, terminal_cols);
+    } else {
+        for (y=0; y < terminal_rows; y++)
+            erase(t, y, 0, terminal_cols);
+    }
+}
+
+static void erase_line(terminal *t, int mode)
+{
+    if (mode == 0)
+        erase(t, t->y, t->x, terminal_cols);
+    else if (mode == 1)
+        erase(t, t->y, 0, t->x + 1);
+    else
+        erase(t, t->y, 0, terminal_cols);
+}
+
+/* the sequences ncurses and the ANSI backend move the cursor and erase with;
+the rest (colors, modes, scrolling regions) change no cell */
+static void run_csi(terminal *t, char final)
+{
+    int mode = (t->num_of_params) ? t->params[0] : 0;
+    if (t->private_csi)
+        return;
+    switch (final) {
+        case 'H':
+        case 'f':
+            t->y = clamp(param(t, 0, 1) - 1, 0, terminal_rows - 1);
+            t->x = clamp(param(t, 1, 1) - 1, 0, terminal_cols - 1);
+            break;
+        case 'A':
+            t->y = clamp(t->y - param(t, 0, 1), 0, terminal_rows - 1);
+            break;
+        case 'B':
+            t->y = clamp(t->y + param(t, 0, 1), 0, terminal_rows - 1);
+            break;
+        case 'C':
+            t->x = clamp(t->x + param(t, 0, 1), 0, terminal_cols - 1);
+            break;
+        case 'D':
+            t->x = clamp(t->x - param(t, 0, 1), 0, terminal_cols - 1);
+            break;
+        case 'G':
+            t->x = clamp(param(t, 0, 1) - 1, 0, terminal_cols - 1);
+            break;
+        case 'd':
+            t->y = clamp(param(t, 0, 1) - 1, 0, terminal_rows - 1);
+            break;
+        case 'J':
+            erase_display(t, mode);
+            break;
+        case 'K':
+            erase_line(t, mode);
+            break;
+        case 'X':
+            erase(
+                t, t->y, t->x, clamp(t->x + param(t, 0, 1), 0, terminal_cols)
+            );
+            break;
+        default:
+            break;
+    }
+}
+
+static void feed_csi(terminal *t, char c)
+{
+    if ((c >= '0') && (c <= '9')) {
+        if (!t->num_of_params)
+            t->num_of_params = 1;
+        t->params[t->num_of_params - 1] =
+            t->params[t->num_of_params - 1] * 10 + (c - '0');
+    } else if (c == ';') {
+        if (!t->num_of_params)
+            t->num_of_params = 1;
+        if (t->num_of_params < max_csi_params)
+            t->params[t->num_of_params++] = 0;
+    } else if ((c == '?') || (c == '>') || (c == '=')) {
+        t->private_csi = true;
+    } else if ((c >= 0x40) && (c <= 0x7e)) {
+        run_csi(t, c);
+        t->state = ground_state;
+    }
+}
+
+static void feed_char(terminal *t, char c)
+{
+    switch (t->state) {
+        case escape_state:
+            if (c == '[') {
+                t->state = csi_state;
+                t->num_of_params = 0;
+                memset(t->params, 0, sizeof(t->params));
+                t->private_csi = false;
+            } else if ((c == '(') || (c == ')')) {
+                t->state = charset_state;
+            } else {
+                t->state = ground_state;
+            }
+            return;
+        case csi_state:
+            feed_csi(t, c);
+            return;
+        case charset_state:
+            t->state = ground_state;
+            return;
+        default:
+            break;
+    }
+    switch (c) {
+        case '\033':
+            t->state = escape_state;
+            break;
+        case '\r':
+            t->x = 0;
+            break;
+        case '\n':
+            t->y = clamp(t->y + 1, 0, terminal_rows - 1);
+            break;
+        case '\b':
+            t->x = clamp(t->x - 1, 0, terminal_cols - 1);
+            break;
+        default:
+            if ((unsigned char)c >= ' ')
+                put_char(t, c);
+    }
+}
+
+static void init_frame_log(frame_log *log)
+{
+    log->capacity = initial_frames_capacity;
+    log->bytes = malloc(log->capacity * sizeof(*log->bytes));
+    if (!log->bytes) {
+        fprintf(stderr, "failed to allocate the frame log\n");
+        exit(1);
+    }
+    log->count = 0;
+    log->current_bytes = 0;
+    log->last_output_us = 0;
+}
+
+static void end_frame(frame_log *log)
+{
+    if (!log->current_bytes)
+        return;
+    if (log->count == log->capacity) {
+        log->capacity *= 2;
+        log->bytes = realloc(log->bytes, log->capacity * sizeof(*log->bytes));
+        if (!log->bytes) {
+            fprintf(stderr, "failed to allocate the frame log\n");
+            exit(1);
+        }
+    }
+    log->bytes[log->count++] = log->current_bytes;
+    log->current_bytes = 0;
+}
+
+static void log_output(frame_log *log, long bytes, double now)
+{
+    if (now - log->last_output_us > frame_gap_us)
+        end_frame(log);
+    log->current_bytes += bytes;
+    log->last_output_us = now;
+}
+
+/* reads whatever the game has written within the time, replaying it on the
+terminal and logging its frames (unless `log` is NULL); returns the number of
+bytes read, -1 once the game has exited */
+static long read_output(
+    game_process *p, terminal *t, frame_log *log, int timeout
+)
+{
+    struct pollfd pfd = { p->fd, POLLIN, 0 };
+    char buffer[65536];
+    ssize_t size, i;
+    if (poll(&pfd, 1, timeout) <= 0)
+        return 0;
+    size = read(p->fd, buffer, sizeof(buffer));
+    if (size <= 0)
+        return -1;
+    if (log)
+        log_output(log, size, current_time_us());
+    for (i=0; i < size; i++)
+        feed_char(t, buffer[i]);
+    return size;
+}
+
+/* reads the output until the game keeps quiet for the time */
+static void drain_output(
+    game_process *p, terminal *t, frame_log *log, int quiet_time
+)
+{
+    while (read_output(p, t, log, quiet_time) > 0)
+        ;
+}
+
+/* reads the output for the time, however much comes */
+static void read_output_for(
+    game_process *p, terminal *t, frame_log *log, double us
+)
+{
+    double end = current_time_us() + us;
+    double left;
+    while ((left = end - current_time_us()) > 0) {
+        if (read_output(p, t, log, (int)(left / 1000) + 1) < 0)
+            return;
+    }
+}
+
+static void start_game(game_process *p, const latency_options *options)
+{
+    struct winsize size = { terminal_rows, terminal_cols, 0, 0 };
+    char *slave_name;
+    p->fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((p->fd < 0) || (grantpt(p->fd) < 0) || (unlockpt(p->fd) < 0) ||
+        !(slave_name = ptsname(p->fd)) ||
+        (ioctl(p->fd, TIOCSWINSZ, &size) < 0))
+    {
+        perror("pseudo-terminal");
+        exit(1);
+    }
+    p->pid = fork();
+    if (p->pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (!p->pid) {
+        char **argv = calloc(options->num_of_game_args + 2, sizeof(*argv));
+        int slave, i;
+        setsid();
+        slave = open(slave_name, O_RDWR);
+        if ((slave < 0) || !argv) {
+            perror(slave_name);
+            _exit(1);
+        }
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        close(slave);
+        close(p->fd);
+        setenv("TERM", "xterm", 1);
+        argv[0] = (char *)options->game_path;
+        for (i=0; i < options->num_of_game_args; i++)
+            argv[i + 1] = options->game_args[i];
+        execv(options->game_path, argv);
+        perror(options->game_path);
+        _exit(1);
+    }
+}
+
+static void stop_game(game_process *p, terminal *t)
+{
+    double deadline = current_time_us() + exit_timeout * 1e3;
+    int status;
+    /* Esc ends the game, the 2nd one leaves the score message */
+    if (write(p->fd, "\033", 1) == 1) {
+        drain_output(p, t, NULL, startup_quiet_time);
+        if (write(p->fd, "\033", 1) != 1)
+            deadline = 0;
+    }
+    while (waitpid(p->pid, &status, WNOHANG) == 0) {
+        if (current_time_us() > deadline) {
+            kill(p->pid, SIGKILL);
+            waitpid(p->pid, &status, 0);
+            break;
+        }
+        drain_output(p, t, NULL, 10);
+    }
+    close(p->fd);
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* the value `fraction` of the sorted values are at most */
+static double percentile(const double *sorted, long count, double fraction)
+{
+    long i = (long)(fraction * (count - 1) + 0.5);
+    return count ? sorted[i] : 0;
+}
+
+static unsigned int next_random(unsigned int *state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* presses left and right by turns, so every key moves the falling piece,
+and times the output until a cell changes */
+static long measure(
+    game_process *p, terminal *t, frame_log *log,
+    const latency_options *options, double *latencies
+)
+{
+    static const char *keys[] = { "\033[D", "\033[C" };
+    unsigned int state = 2024;
+    long count = 0;
+    int n;
+    for (n=0; n < options->samples; n++) {
+        /* the keys come at random times between the frames */
+        double pause = options->key_interval * 1e3 *
+            (0.5 + (next_random(&state) % 1000) / 1000.0);
+        double start, deadline;
+        const char *key = keys[n & 1];
+        read_output_for(p, t, log, pause);
+        t->changed = false;
+        start = current_time_us();
+        if (write(p->fd, key, strlen(key)) != (ssize_t)strlen(key))
+            break;
+        deadline = start + options->answer_timeout * 1e3;
+        while (!t->changed && (current_time_us() < deadline)) {
+            if (read_output(p, t, log, 1) < 0)
+                return count;
+        }
+        if (t->changed)
+            latencies[count++] = current_time_us() - start;
+    }
+    return count;
+}
+
+static void print_report(
+    const latency_options *options, double *latencies, long count,
+    frame_log *log
+)
+{
+    double total = 0;
+    long i;
+    qsort(latencies, count, sizeof(*latencies), compare_doubles);
+    qsort(log->bytes, log->count, sizeof(*log->bytes), compare_doubles);
+    for (i=0; i < log->count; i++)
+        total += log->bytes[i];
+    printf("game:");
+    for (i=0; i < options->num_of_game_args; i++)
+        printf(" %s", options->game_args[i]);
+    printf(
+        "%s\nkeys: %d sent, %ld answered\n",
+        options->num_of_game_args ? "" : " (default)", options->samples,
+        count
+    );
+    printf(
+        "latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+        percentile(latencies, count, 0.5) / 1e3,
+        percentile(latencies, count, 0.99) / 1e3,
+        count ? latencies[count - 1] / 1e3 : 0
+    );
+    printf(
+        "frames: %ld, %.0f bytes on average, p50 %.0f, p99 %.0f, "
+        "%.0f bytes in total\n",
+        log->count, log->count ? total / log->count : 0,
+        percentile(log->bytes, log->count, 0.5),
+        percentile(log->bytes, log->count, 0.99), total
+    );
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-n samples] [-i key_interval] [-t answer_timeout]\n"
+        "       [-g game] [-- game_options]\n",
+        program
+    );
+}
+
+static void parse_options(int argc, char **argv, latency_options *options)
+{
+    int opt;
+    options->game_path = "./build/bin/tetris";
+    options->samples = default_samples;
+    options->key_interval = default_key_interval;
+    options->answer_timeout = default_answer_timeout;
+    while ((opt = getopt(argc, argv, "n:i:t:g:")) != -1) {
+        switch (opt) {
+            case 'n':
+                options->samples = atoi(optarg);
+                break;
+            case 'i':
+                options->key_interval = atoi(optarg);
+                break;
+            case 't':
+                options->answer_timeout = atoi(optarg);
+                break;
+            case 'g':
+                options->game_path = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    if ((options->samples < 1) || (options->key_interval < 1) ||
+        (options->answer_timeout < 1))
+    {
+        print_usage(argv[0]);
+        exit(1);
+    }
+    options->game_args = argv + optind;
+    options->num_of_game_args = argc - optind;
+}
+
+int main(int argc, char **argv)
+{
+    latency_options options;
+    static terminal t;
+    frame_log log;
+    game_process p;
+    double *latencies;
+    long count;
+    parse_options(argc, argv, &options);
+    latencies = malloc(options.samples * sizeof(*latencies));
+    if (!latencies) {
+        fprintf(stderr, "failed to allocate the latencies\n");
+        exit(1);
+    }
+    init_terminal(&t);
+    init_frame_log(&log);
+    start_game(&p, &options);
+    drain_output(&p, &t, &log, startup_quiet_time);
+    /* the frames of the game start aren't counted */
+    end_frame(&log);
+    log.count = 0;
+    count = measure(&p, &t, &log, &options, latencies);
+    end_frame(&log);
+    stop_game(&p, &t);
+    print_report(&options, latencies, count, &log);
+    free(latencies);
+    free(log.bytes);
+    return 0;
+}
@@ -0,0 +1,31 @@
+/* netgen.c */
+
+#include "board_net.h"
+#include "search.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+    heuristic_weights weights = *default_heuristic_weights();
+    int num_of_hidden = default_board_net_hidden;
+    if ((argc < 2) || (argc > 4)) {
+        fprintf(
+            stderr,
+            "usage: %s weights_file [hidden_layer_size [heuristic_weights]]\n",
+            argv[0]
+        );
+        return 1;
+    }
+    if (argc >= 3)
+        num_of_hidden = atoi(argv[2]);
+    if (argc == 4)
+        load_heuristic_weights(argv[3], &weights);
+    save_heuristic_board_net(argv[1], &weights, num_of_hidden);
+    printf(
+        "%s: %d inputs, %d hidden units, the %s heuristic weights\n",
+        argv[1], board_net_inputs, num_of_hidden,
+        (argc == 4) ? argv[3] : "default"
+    );
+    return 0;
+}
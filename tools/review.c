@@ -0,0 +1,227 @@
+/* review.c */
+
+#include "arena.h"
+#include "finesse.h"
+#include "game.h"
+#include "policy.h"
+#include "replay.h"
+#include "search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+enum review_consts {
+    /* the time between two keys the simulated computer player presses, in
+    milliseconds (the gravity at the top level moves the piece every 7) */
+    default_bot_key_delay = 2,
+    default_bot_minutes = 60,
+    /* the seeks timed to report the average seek time */
+    num_of_timed_seeks = 1000
+};
+
+typedef struct tag_review_options {
+    const char *file_name;
+    /* record a computer player's game of this many minutes first */
+    int bot_minutes, key_delay;
+    unsigned int seed, keyframe_interval;
+    /* the time to show the game at in seconds, negative - the end */
+    double seek_time;
+} review_options;
+
+static double current_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void step_and_record(recording *r, game *g, const game_event *event)
+{
+    game_step(g, event);
+    record_step(r, event, g);
+}
+
+/* plays a game the way the terminal game's computer player does, one key at
+a time, on a simulated clock, so an hour long game is recorded in seconds */
+static void record_bot_game(const review_options *options, recording *r)
+{
+    const heuristic_weights *weights = default_heuristic_weights();
+    long end_time = options->bot_minutes * 60000L, now = 0;
+    player_policy policy;
+    placement target;
+    bool has_target = false;
+    game g;
+    init_search_policy(&policy, weights, search_policy_depth);
+    init_game(&g, standard_field, options->seed, now);
+    init_finesse_tables();
+    init_recording(r, &g, now, options->keyframe_interval);
+    while (g.game_on && (now < end_time)) {
+        game_event event = { input_event, no_action, 0 };
+        finesse_path path;
+        if (g.changes & next_piece_changed) {
+            has_target =
+                policy.choose(&policy, &g, get_thread_arena(), &target);
+        }
+        now += options->key_delay;
+        /* the gravity comes first if its deadline is earlier */
+        while (g.game_on && (g.gravity_deadline <= now)) {
+            event.kind = gravity_event;
+            event.time = g.gravity_deadline;
+            step_and_record(r, &g, &event);
+            if (g.changes & next_piece_changed) {
+                has_target =
+                    policy.choose(&policy, &g, get_thread_arena(), &target);
+            }
+        }
+        if (!g.game_on)
+            break;
+        event.kind = input_event;
+        event.action =
+            (has_target && find_finesse_path(&g, &target, &path)) ?
+            path.actions[0] : hard_drop;
+        event.time = now;
+        step_and_record(r, &g, &event);
+    }
+    free_thread_arena();
+}
+
+static void print_game(const game *g, long time)
+{
+    const field_kernels *kernels = game_kernels(g);
+    struct_piece piece = game_piece(g);
+    int x, y;
+    printf(
+        "at %.3fs: score %d, lines %d, level %d%s\n", time / 1000.0,
+        g->score, g->lines, g->level, g->game_on ? "" : ", game over"
+    );
+    for (y=0; y < kernels->height; y++) {
+        putchar('|');
+        for (x=0; x < kernels->width; x++) {
+            int px = x - piece.x_shift, py = y - piece.y_decline;
+            bool in_piece = g->game_on &&
+                (px >= 0) && (px < piece.size) &&
+                (py >= 0) && (py < piece.size) &&
+                ((piece.size == big_piece_size) ?
+                    piece.form.big[py][px] : piece.form.small[py][px]);
+            putchar(
+                in_piece ? '@' : field_cell_is_occupied(g->field, x, y) ?
+                '#' : '.'
+            );
+        }
+        printf("|\n");
+    }
+}
+
+/* times seeks to random points of the game: from the keyframes, and from the
+start for comparison */
+static void time_seeks(const recording *r)
+{
+    long duration = recording_duration(r);
+    unsigned long long rng = 1;
+    double start, keyframe_us, full_us;
+    game g;
+    int i, full_seeks = 10;
+    start = current_time_us();
+    for (i=0; i < num_of_timed_seeks; i++) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        seek_recording(r, (long)((rng >> 33) % (duration + 1)), &g);
+    }
+    keyframe_us = (current_time_us() - start) / num_of_timed_seeks;
+    /* the same with only the 1st keyframe */
+    {
+        recording from_start = *r;
+        from_start.num_of_keyframes = 1;
+        start = current_time_us();
+        for (i=0; i < full_seeks; i++) {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            seek_recording(
+                &from_start, (long)((rng >> 33) % (duration + 1)), &g
+            );
+        }
+        full_us = (current_time_us() - start) / full_seeks;
+    }
+    printf(
+        "a seek takes %.1f us from the keyframes, %.1f us from the start\n",
+        keyframe_us, full_us
+    );
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-b bot_minutes [-k key_delay] [-s seed] [-i interval]]\n"
+        "       [-t seconds] recording\n",
+        program
+    );
+}
+
+static void parse_options(int argc, char **argv, review_options *options)
+{
+    int opt;
+    options->bot_minutes = 0;
+    options->key_delay = default_bot_key_delay;
+    options->seed = 1;
+    options->keyframe_interval = default_keyframe_interval;
+    options->seek_time = -1;
+    while ((opt = getopt(argc, argv, "b:k:s:i:t:")) != -1) {
+        switch (opt) {
+            case 'b':
+                options->bot_minutes = atoi(optarg);
+                break;
+            case 'k':
+                options->key_delay = atoi(optarg);
+                break;
+            case 's':
+                options->seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'i':
+                options->keyframe_interval = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                options->seek_time = atof(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    if ((optind != argc - 1) || (options->bot_minutes < 0) ||
+        (options->key_delay < 1))
+    {
+        print_usage(argv[0]);
+        exit(1);
+    }
+    options->file_name = argv[optind];
+}
+
+int main(int argc, char **argv)
+{
+    review_options options;
+    recording r;
+    long time;
+    game g;
+    parse_options(argc, argv, &options);
+    if (options.bot_minutes) {
+        record_bot_game(&options, &r);
+        save_recording(&r, options.file_name);
+        free_recording(&r);
+    } else {
+        /* the engine tables */
+        init_game(&g, standard_field, 1, 0);
+    }
+    load_recording(&r, options.file_name);
+    printf(
+        "%s: %.1fs, %u events, %u keyframes every %.1fs\n",
+        options.file_name, recording_duration(&r) / 1000.0, r.num_of_events,
+        r.num_of_keyframes, r.keyframe_interval / 1000.0
+    );
+    time = (options.seek_time < 0) ?
+        recording_duration(&r) : (long)(options.seek_time * 1000);
+    seek_recording(&r, time, &g);
+    print_game(&g, time);
+    time_seeks(&r);
+    free_recording(&r);
+    return 0;
+}
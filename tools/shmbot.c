@@ -0,0 +1,154 @@
+/* shmbot.c */
+
+#include "arena.h"
+#include "board_net.h"
+#include "bot_link.h"
+#include "finesse.h"
+#include "game.h"
+#include "policy.h"
+#include "search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+enum shmbot_consts {
+    /* the time the game is waited for before the bot gives up on it, in
+    milliseconds */
+    game_timeout = 5000
+};
+
+typedef struct tag_shmbot_options {
+    const char *name, *weights_file, *net_file;
+    int depth;
+} shmbot_options;
+
+/* the times an action took from being sent to the state it was answered by */
+typedef struct tag_round_trips {
+    long count;
+    double total_us, max_us;
+} round_trips;
+
+static double current_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-w heuristic_weights | -n board_net] [-d search_depth]\n"
+        "       segment_name\n",
+        program
+    );
+}
+
+static void parse_options(int argc, char **argv, shmbot_options *options)
+{
+    int opt;
+    options->weights_file = NULL;
+    options->net_file = NULL;
+    options->depth = search_policy_depth;
+    while ((opt = getopt(argc, argv, "w:n:d:")) != -1) {
+        switch (opt) {
+            case 'w':
+                options->weights_file = optarg;
+                break;
+            case 'n':
+                options->net_file = optarg;
+                break;
+            case 'd':
+                options->depth = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    if ((optind != argc - 1) || (options->weights_file && options->net_file))
+    {
+        print_usage(argv[0]);
+        exit(1);
+    }
+    options->name = argv[optind];
+}
+
+/* presses the keys the way the built-in computer player does: one at a time,
+the path found again from every new state */
+static void play(bot_link *link, const player_policy *policy, round_trips *rt)
+{
+    bot_link_state state;
+    placement target;
+    bool has_target = false;
+    unsigned int target_piece = 0, sent = bot_link_actions_done(link);
+    double sent_at = 0;
+    while (wait_bot_link_state(link, &state, game_timeout)) {
+        finesse_path path;
+        game g;
+        if (!state.game_on)
+            return;
+        /* the state answering the last action */
+        if ((state.actions_done == sent) && (sent_at > 0)) {
+            double us = current_time_us() - sent_at;
+            rt->count++;
+            rt->total_us += us;
+            if (us > rt->max_us)
+                rt->max_us = us;
+            sent_at = 0;
+        }
+        if (state.actions_done != sent)
+            continue;
+        bot_link_game(&state, &g);
+        if (state.num_of_pieces != target_piece) {
+            target_piece = state.num_of_pieces;
+            has_target =
+                policy->choose(policy, &g, get_thread_arena(), &target);
+        }
+        sent_at = current_time_us();
+        send_bot_link_action(
+            link,
+            (has_target && find_finesse_path(&g, &target, &path)) ?
+            path.actions[0] : hard_drop
+        );
+        sent++;
+    }
+    fprintf(stderr, "%s: the game doesn't answer\n", link->name);
+}
+
+int main(int argc, char **argv)
+{
+    shmbot_options options;
+    heuristic_weights weights = *default_heuristic_weights();
+    board_net net;
+    player_policy policy;
+    round_trips rt = { 0, 0, 0 };
+    bot_link link;
+    game g;
+    parse_options(argc, argv, &options);
+    /* the engine tables */
+    init_game(&g, standard_field, 1, 0);
+    init_finesse_tables();
+    if (options.net_file) {
+        load_board_net(&net, options.net_file);
+        init_net_policy(&policy, &net);
+    } else {
+        if (options.weights_file)
+            load_heuristic_weights(options.weights_file, &weights);
+        init_search_policy(&policy, &weights, options.depth);
+    }
+    attach_bot_link(&link, options.name);
+    play(&link, &policy, &rt);
+    printf(
+        "%s: %ld actions, round trip %.1f us on average, %.1f us at most\n",
+        options.name, rt.count, rt.count ? rt.total_us / rt.count : 0,
+        rt.max_us
+    );
+    close_bot_link(&link);
+    free_thread_arena();
+    if (options.net_file)
+        unload_board_net(&net);
+    return 0;
+}
@@ -0,0 +1,417 @@
+/* tune.c */
+
+#include "arena.h"
+#include "game.h"
+#include "policy.h"
+#include "search.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+enum tune_consts {
+    num_of_tuned_weights = 4,
+    max_tune_threads = 64,
+    default_generations = 30,
+    default_population = 32,
+    default_games = 16,
+    /* the games are cut at this many pieces, so a candidate playing forever
+    still finishes; the score then tells the good candidates apart, it grows
+    with the lines cleared at once */
+    default_max_pieces = 500,
+    /* the falling piece only; the search over the next one is ~10 times
+    slower */
+    default_tune_depth = 1,
+    /* the candidates the next generation is sampled around: a quarter of the
+    population */
+    elite_divisor = 4
+};
+
+/* the spread of the 1st generation and the lowest one the search keeps, so
+it never freezes before the last generation */
+static const double initial_sigma = 0.3, min_sigma = 0.005;
+
+typedef struct tag_tune_options {
+    int generations, population, games, max_pieces, depth, num_of_threads;
+    unsigned int seed;
+    const char *output_file, *initial_file;
+} tune_options;
+
+typedef struct tag_game_result {
+    long score, lines, pieces;
+} game_result;
+
+typedef struct tag_candidate {
+    double w[num_of_tuned_weights];
+    /* the sums over the candidate's games */
+    game_result total;
+} candidate;
+
+/* the work the threads share: every game of every candidate */
+typedef struct tag_generation {
+    candidate *candidates;
+    int num_of_candidates;
+    /* a game per job, a thread writes only the results of its jobs */
+    game_result *results;
+    const tune_options *options;
+    unsigned int games_seed;
+    pthread_mutex_t lock;
+    int next_job;
+} generation;
+
+static double current_time_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long long next_stream_random(unsigned long long *state)
+{
+    /* splitmix64 */
+    unsigned long long z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static double next_gaussian(unsigned long long *state)
+{
+    /* Box-Muller, the uniforms are in (0, 1] */
+    double u1 = ((next_stream_random(state) >> 11) + 1) / 9007199254740992.0;
+    double u2 = (next_stream_random(state) >> 11) / 9007199254740992.0;
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static void to_vector(const heuristic_weights *weights, double *w)
+{
+    w[0] = weights->aggregate_height;
+    w[1] = weights->completed_lines;
+    w[2] = weights->holes;
+    w[3] = weights->bumpiness;
+}
+
+static void to_weights(const double *w, heuristic_weights *weights)
+{
+    weights->aggregate_height = w[0];
+    weights->completed_lines = w[1];
+    weights->holes = w[2];
+    weights->bumpiness = w[3];
+}
+
+/* the search only compares the weighted sums, so the weights' scale doesn't
+matter and the vectors are kept unit long */
+static void normalize(double *w)
+{
+    double length = 0;
+    int i;
+    for (i=0; i < num_of_tuned_weights; i++)
+        length += w[i] * w[i];
+    length = sqrt(length);
+    if (length == 0)
+        return;
+    for (i=0; i < num_of_tuned_weights; i++)
+        w[i] /= length;
+}
+
+static void play_game(
+    const candidate *c, const tune_options *options, unsigned int seed,
+    arena *a, game_result *result
+)
+{
+    heuristic_weights weights;
+    player_policy policy;
+    game g;
+    int pieces = 0;
+    to_weights(c->w, &weights);
+    init_search_policy(&policy, &weights, options->depth);
+    init_game(&g, standard_field, seed, 0);
+    while ((pieces < options->max_pieces) && policy_move(&policy, &g, a))
+        pieces++;
+    result->score = g.score;
+    result->lines = g.lines;
+    result->pieces = pieces;
+}
+
+static void *run_tune_worker(void *arg)
+{
+    generation *gen = arg;
+    arena *a = get_thread_arena();
+    int num_of_jobs = gen->num_of_candidates * gen->options->games;
+    for (;;) {
+        int job;
+        pthread_mutex_lock(&gen->lock);
+        job = gen->next_job++;
+        pthread_mutex_unlock(&gen->lock);
+        if (job >= num_of_jobs)
+            break;
+        play_game(
+            &gen->candidates[job % gen->num_of_candidates], gen->options,
+            gen->games_seed + job / gen->num_of_candidates, a,
+            &gen->results[job]
+        );
+    }
+    free_thread_arena();
+    return NULL;
+}
+
+static void evaluate_generation(generation *gen)
+{
+    pthread_t threads[max_tune_threads];
+    int num_of_jobs = gen->num_of_candidates * gen->options->games, i;
+    gen->next_job = 0;
+    for (i=0; i < gen->options->num_of_threads; i++) {
+        if (pthread_create(&threads[i], NULL, run_tune_worker, gen) != 0) {
+            fprintf(
+                stderr, "%s:%d: a tuning thread can't be started\n",
+                __FILE__, __LINE__
+            );
+            exit(1);
+        }
+    }
+    for (i=0; i < gen->options->num_of_threads; i++)
+        pthread_join(threads[i], NULL);
+    for (i=0; i < gen->num_of_candidates; i++) {
+        game_result *total = &gen->candidates[i].total;
+        total->score = total->lines = total->pieces = 0;
+    }
+    for (i=0; i < num_of_jobs; i++) {
+        game_result *total =
+            &gen->candidates[i % gen->num_of_candidates].total;
+        total->score += gen->results[i].score;
+        total->lines += gen->results[i].lines;
+        total->pieces += gen->results[i].pieces;
+    }
+}
+
+static int by_score_descending(const void *a, const void *b)
+{
+    long sa = ((const candidate *)a)->total.score;
+    long sb = ((const candidate *)b)->total.score;
+    return (sa < sb) - (sa > sb);
+}
+
+/* the cross-entropy method: the next generation is sampled from the normal
+distribution fitted to the elite of this one */
+static void fit_distribution(
+    const candidate *elite, int num_of_elite, double *mean, double *sigma
+)
+{
+    int i, k;
+    for (k=0; k < num_of_tuned_weights; k++) {
+        double sum = 0, sum_of_squares = 0;
+        for (i=0; i < num_of_elite; i++) {
+            sum += elite[i].w[k];
+            sum_of_squares += elite[i].w[k] * elite[i].w[k];
+        }
+        mean[k] = sum / num_of_elite;
+        sigma[k] = sqrt(
+            fmax(sum_of_squares / num_of_elite - mean[k] * mean[k], 0)
+        );
+        if (sigma[k] < min_sigma)
+            sigma[k] = min_sigma;
+    }
+    normalize(mean);
+}
+
+static void sample_generation(
+    generation *gen, const double *mean, const double *sigma,
+    unsigned long long *rng_state
+)
+{
+    int i, k;
+    /* the mean itself is kept, the search never loses what it has found */
+    for (i=0; i < gen->num_of_candidates; i++) {
+        for (k=0; k < num_of_tuned_weights; k++) {
+            gen->candidates[i].w[k] = mean[k] +
+                ((i == 0) ? 0 : sigma[k] * next_gaussian(rng_state));
+        }
+        normalize(gen->candidates[i].w);
+    }
+}
+
+static void print_weights(const char *label, const double *w)
+{
+    printf(
+        "  %-6s height %9.5f  lines %9.5f  holes %9.5f  bumpiness %9.5f\n",
+        label, w[0], w[1], w[2], w[3]
+    );
+}
+
+static void print_usage(const char *program)
+{
+    fprintf(
+        stderr,
+        "usage: %s [-o tuned_weights] [-w initial_weights] [-g generations]\n"
+        "       [-p population] [-n games_per_candidate] [-m max_pieces]\n"
+        "       [-d search_depth] [-j threads] [-s seed]\n",
+        program
+    );
+}
+
+static int online_cpus()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus < 1) ? 1 : (cpus > max_tune_threads) ? max_tune_threads : cpus;
+}
+
+static void parse_options(int argc, char **argv, tune_options *options)
+{
+    int opt;
+    options->generations = default_generations;
+    options->population = default_population;
+    options->games = default_games;
+    options->max_pieces = default_max_pieces;
+    options->depth = default_tune_depth;
+    options->num_of_threads = online_cpus();
+    options->seed = 1;
+    options->output_file = "tuned_weights.txt";
+    options->initial_file = NULL;
+    while ((opt = getopt(argc, argv, "o:w:g:p:n:m:d:j:s:")) != -1) {
+        switch (opt) {
+            case 'o':
+                options->output_file = optarg;
+                break;
+            case 'w':
+                options->initial_file = optarg;
+                break;
+            case 'g':
+                options->generations = atoi(optarg);
+                break;
+            case 'p':
+                options->population = atoi(optarg);
+                break;
+            case 'n':
+                options->games = atoi(optarg);
+                break;
+            case 'm':
+                options->max_pieces = atoi(optarg);
+                break;
+            case 'd':
+                options->depth = atoi(optarg);
+                break;
+            case 'j':
+                options->num_of_threads = atoi(optarg);
+                break;
+            case 's':
+                options->seed = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    if ((options->generations < 1) || (options->population < elite_divisor) ||
+        (options->games < 1) || (options->max_pieces < 1) ||
+        (options->num_of_threads < 1) ||
+        (options->num_of_threads > max_tune_threads))
+    {
+        print_usage(argv[0]);
+        exit(1);
+    }
+}
+
+static void init_generation(
+    generation *gen, int num_of_candidates, const tune_options *options
+)
+{
+    gen->candidates = malloc(num_of_candidates * sizeof(candidate));
+    gen->results =
+        malloc(num_of_candidates * options->games * sizeof(game_result));
+    if (!gen->candidates || !gen->results) {
+        fprintf(
+            stderr, "%s:%d: memory allocation failed\n", __FILE__, __LINE__
+        );
+        exit(1);
+    }
+    gen->num_of_candidates = num_of_candidates;
+    gen->options = options;
+    pthread_mutex_init(&gen->lock, NULL);
+}
+
+static void free_generation(generation *gen)
+{
+    pthread_mutex_destroy(&gen->lock);
+    free(gen->candidates);
+    free(gen->results);
+}
+
+int main(int argc, char **argv)
+{
+    tune_options options;
+    /* every generation's top candidate plays the held-out games too: their
+    seeds are the same for all generations and no generation plays them, so
+    the scores there compare candidates of different generations fairly */
+    generation gen, held_out;
+    heuristic_weights weights = *default_heuristic_weights();
+    double mean[num_of_tuned_weights], sigma[num_of_tuned_weights];
+    candidate best;
+    unsigned long long rng_state;
+    double start = current_time_s();
+    int num_of_elite, i, k;
+    game g;
+    parse_options(argc, argv, &options);
+    if (options.initial_file)
+        load_heuristic_weights(options.initial_file, &weights);
+    /* the engine tables are built by the 1st game, before the threads */
+    init_game(&g, standard_field, 1, 0);
+    init_generation(&gen, options.population, &options);
+    init_generation(&held_out, 1, &options);
+    /* the seeds the generation after the last would play */
+    held_out.games_seed = options.seed + options.generations * 0x9e3779b9u;
+    num_of_elite = options.population / elite_divisor;
+    rng_state = options.seed;
+    to_vector(&weights, mean);
+    normalize(mean);
+    for (k=0; k < num_of_tuned_weights; k++)
+        sigma[k] = initial_sigma;
+    best.total.score = -1;
+    printf(
+        "%d candidates x %d games of %d pieces, depth %d, %d threads\n",
+        options.population, options.games, options.max_pieces, options.depth,
+        options.num_of_threads
+    );
+    for (i=0; i < options.generations; i++) {
+        sample_generation(&gen, mean, sigma, &rng_state);
+        /* every candidate of a generation plays the same piece sequences,
+        the next generation plays new ones */
+        gen.games_seed = options.seed + i * 0x9e3779b9u;
+        evaluate_generation(&gen);
+        qsort(gen.candidates, gen.num_of_candidates, sizeof(candidate),
+            by_score_descending);
+        /* the top score of a generation favors a lucky candidate, so the
+        weights written are the ones best on the held-out games */
+        held_out.candidates[0] = gen.candidates[0];
+        evaluate_generation(&held_out);
+        if (held_out.candidates[0].total.score > best.total.score) {
+            best = held_out.candidates[0];
+            to_weights(best.w, &weights);
+            save_heuristic_weights(options.output_file, &weights);
+        }
+        printf(
+            "generation %3d  %7.1fs  top: score %9.1f lines %7.1f  "
+            "median score %9.1f\n",
+            i + 1, current_time_s() - start,
+            (double)gen.candidates[0].total.score / options.games,
+            (double)gen.candidates[0].total.lines / options.games,
+            (double)gen.candidates[gen.num_of_candidates / 2].total.score /
+            options.games
+        );
+        printf(
+            "  held-out score: top %9.1f  written %9.1f\n",
+            (double)held_out.candidates[0].total.score / options.games,
+            (double)best.total.score / options.games
+        );
+        print_weights("top", gen.candidates[0].w);
+        fit_distribution(gen.candidates, num_of_elite, mean, sigma);
+        print_weights("mean", mean);
+        print_weights("sigma", sigma);
+        fflush(stdout);
+    }
+    printf("the best weights are written to %s\n", options.output_file);
+    free_generation(&gen);
+    free_generation(&held_out);
+    return 0;
+}